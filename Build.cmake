@@ -184,15 +184,27 @@ FormatSource( "Source/Main.cpp" )
 FormatSource( "Source/Operators.cpp" )
 FormatSource( "Source/Parser.cpp" )
 FormatSource( "Source/Parser.h" )
+FormatSource( "Source/Plugins.cpp" )
 FormatSource( "Source/Raw.cpp" )
 FormatSource( "Source/ReDefine.cpp" )
 FormatSource( "Source/ReDefine.h" )
 FormatSource( "Source/Script.cpp" )
 FormatSource( "Source/Text.cpp" )
+FormatSource( "Source/Uring.cpp" )
+FormatSource( "Source/Uring.h" )
 FormatSource( "Source/Variables.cpp" )
 FormatSource( "Source/Executable/CommandLine.cpp" )
 FormatSource( "Source/Executable/CommandLine.h" )
+FormatSource( "Source/Executable/Json.cpp" )
+FormatSource( "Source/Executable/Json.h" )
 FormatSource( "Source/Executable/Main.cpp" )
+FormatSource( "Source/Executable/Server.cpp" )
+FormatSource( "Source/Executable/Server.h" )
+FormatSource( "Source/Executable/Watch.cpp" )
+FormatSource( "Source/Executable/Watch.h" )
+FormatSource( "Source/Generator/Generated.cpp" )
+FormatSource( "Source/Generator/Generated.h" )
+FormatSource( "Source/Generator/Main.cpp" )
 
 if( NOT BUILD_DIR )
     set( BUILD_DIR "Build" )
@@ -1,20 +1,51 @@
-static bool DoAutoGVAR( ReDefine::ScriptCode& code, const std::vector<std::string>& values )
+//
+// example plugin
+//
+// build as shared library using same Source/ReDefine.h as ReDefine executable, and add it to configuration:
+//
+// [Plugins]
+// AutoGVAR = path/to/DoAutoGVAR.so
+//
+
+#include "ReDefine.h"
+
+// ? DoAutoGVAR:INDEX
+// ! Adds "GVAR_" prefix to script function argument at INDEX, if resulting name is a known GVAR define.
+// > DoArgumentSet
+static ReDefine::ScriptEditReturn DoAutoGVAR( ReDefine::ScriptEditAction& action, ReDefine::ScriptCode& code )
 {
-    if( !code.IsValues( __FUNCTION__, values, 1 ) )
-        return false;
+    if( !code.IsFunction( __FUNCTION__ ) )
+        return action.Invalid();
+
+    if( !action.IsValues( __FUNCTION__, 1 ) )
+        return action.Invalid();
 
-    unsigned int idx;
-    if( !code.GetINDEX( __FUNCTION__, values[0], idx ) )
-        return false;
+    uint32_t idx;
+    if( !action.GetINDEX( __FUNCTION__, 0, code, idx ) )
+        return action.Invalid();
 
-    if( code.Arguments[idx].length() > 5 /* GVAR_ */ && code.Arguments[idx].substr( 0, 5 ) != "GVAR_" )
+    const std::string& argument = code.Arguments[idx].Arg;
+
+    if( argument.length() > 5 /* GVAR_ */ && argument.substr( 0, 5 ) != "GVAR_" )
     {
         int         val;
-        std::string prefixed = "GVAR_" + code.Arguments[idx];
+        std::string prefixed = "GVAR_" + argument;
 
-        if( code.Parent->GetDefineValue( "GVAR", prefixed, val ) )
-            code.Arguments[idx] = prefixed;
+        if( action.Root->GetDefineValue( "GVAR", prefixed, val ) )
+            return action.CallEditDo( code, "DoArgumentSet", { action.Values[0], prefixed } );
     }
 
+    return action.Success();
+}
+
+REDEFINE_PLUGIN_EXPORT uint32_t ReDefinePluginVersion()
+{
+    return REDEFINE_PLUGIN_VERSION;
+}
+
+REDEFINE_PLUGIN_EXPORT bool ReDefinePluginInit( ReDefine* root )
+{
+    root->EditDo["DoAutoGVAR"] = DoAutoGVAR;
+
     return true;
 }
@@ -1,11 +1,26 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#if defined (_WIN32)
+// snapshot is read into memory
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
 
 #include "Ini.h"
 
 #include "ReDefine.h"
 
-static const std::regex IsSimpleMath( "^([\\-]?[0-9]+)[\\t\\ ]*(\\*|\\/|\\+|\\-)[\\t\\ ]*([\\-]?[0-9]+)$" );
-
 ReDefine::Header::Header( const std::string& filename, const std::string& type, const std::string& prefix, const std::string& suffix, const std::string& group ) :
     Filename( filename ),
     Type( type ),
@@ -14,6 +29,572 @@ ReDefine::Header::Header( const std::string& filename, const std::string& type,
     Group( group )
 {}
 
+//
+// headers snapshot
+//
+// keeps defines found in each header, so files which didn't change since previous run don't need to be parsed again
+// snapshot is mapped into memory and records are used in-place; all numbers are stored in native byte order
+//
+// layout:
+//   SnapshotHead
+//   uint64_t       offsets[SnapshotHead::Records]
+//   for each record (aligned to 8 bytes):
+//     SnapshotRecord
+//     SnapshotDefine defines[SnapshotRecord::Defines]
+//     char           key[SnapshotRecord::KeyLength]     ; full filename, prefix, suffix separated with '\0'
+//     char           names[SnapshotRecord::NamesLength]
+//
+// SnapshotVersion must be increased whenever layout, or the way headers are parsed, changes
+//
+
+static constexpr char     SnapshotMagic[8] = { 'R', 'e', 'D', 'e', 'f', 'i', 'n', 'e' };
+static constexpr uint32_t SnapshotVersion = 4;
+
+struct SnapshotHead
+{
+    char     Magic[8];
+    uint32_t Version;
+    uint32_t Records;
+};
+
+struct SnapshotRecord
+{
+    int64_t  Time;
+    uint64_t Size;
+    uint64_t Hash;
+    uint32_t Defines;
+    uint32_t KeyLength;
+    uint32_t NamesLength;
+    uint32_t Reserved;
+};
+
+struct SnapshotDefine
+{
+    uint32_t Line;
+    int32_t  Value;
+    uint32_t NameOffset;
+    uint32_t NameLength;
+};
+
+// single define found in header; name points either to snapshot or parsed content
+struct HeaderDefine
+{
+    uint32_t         Line;
+    int32_t          Value;
+    std::string_view Name;
+};
+
+struct HeaderContent
+{
+    std::string               Key;
+    int64_t                   Time = 0;
+    uint64_t                  Size = 0;
+    uint64_t                  Hash = 0;
+
+    std::vector<HeaderDefine> Defines;
+    std::vector<std::string>  Names; // storage for parsed names
+};
+
+struct ReDefine::HeadersSnapshot
+{
+    const char*                                 Data = nullptr;
+    size_t                                      DataSize = 0;
+    std::vector<char>                           Buffer;  // used if snapshot cannot be mapped
+
+    std::map<std::string_view, const char*>     Records; // <key, record>
+
+    std::vector<std::unique_ptr<HeaderContent>> Headers; // headers processed in current run
+    bool                                        Changed = false;
+
+    ~HeadersSnapshot()
+    {
+        #if !defined (_WIN32)
+        if( Data && Buffer.empty() )
+            munmap( const_cast<char*>(Data), DataSize );
+        #endif
+    }
+
+    bool Load([[maybe_unused]] ReDefine* root, const std::string& filename )
+    {
+        if( !std::filesystem::exists( filename ) )
+            return false;
+
+        #if defined (_WIN32)
+        if( !root->ReadFile( filename, Buffer ) )
+            return false;
+
+        Data = Buffer.data();
+        DataSize = Buffer.size();
+        #else
+        int fd = open( filename.c_str(), O_RDONLY );
+        if( fd < 0 )
+            return false;
+
+        struct stat st;
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            void* map = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( map != MAP_FAILED )
+            {
+                Data = static_cast<const char*>(map);
+                DataSize = st.st_size;
+            }
+        }
+
+        close( fd );
+        #endif
+
+        if( !Data )
+            return false;
+
+        // validate everything once, so records can be used without further checks
+
+        const SnapshotHead* head = reinterpret_cast<const SnapshotHead*>(Data);
+        if( DataSize < sizeof(SnapshotHead) || std::memcmp( head->Magic, SnapshotMagic, sizeof(SnapshotMagic) ) != 0 || head->Version != SnapshotVersion )
+            return false;
+
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(Data + sizeof(SnapshotHead) );
+        if( sizeof(SnapshotHead) + head->Records * sizeof(uint64_t) > DataSize )
+            return false;
+
+        for( uint32_t idx = 0; idx < head->Records; idx++ )
+        {
+            if( offsets[idx] % alignof(SnapshotRecord) || offsets[idx] + sizeof(SnapshotRecord) > DataSize )
+                return false;
+
+            const SnapshotRecord* record = reinterpret_cast<const SnapshotRecord*>(Data + offsets[idx]);
+            const uint64_t        size = sizeof(SnapshotRecord) + uint64_t( record->Defines ) * sizeof(SnapshotDefine) + record->KeyLength + record->NamesLength;
+            if( offsets[idx] + size > DataSize )
+                return false;
+
+            const SnapshotDefine* defines = reinterpret_cast<const SnapshotDefine*>(Data + offsets[idx] + sizeof(SnapshotRecord) );
+            for( uint32_t def = 0; def < record->Defines; def++ )
+            {
+                if( uint64_t( defines[def].NameOffset ) + defines[def].NameLength > record->NamesLength )
+                    return false;
+            }
+
+            const char* key = Data + offsets[idx] + sizeof(SnapshotRecord) + record->Defines * sizeof(SnapshotDefine);
+            Records[std::string_view( key, record->KeyLength )] = Data + offsets[idx];
+        }
+
+        return true;
+    }
+
+    // fills content with defines stored in snapshot, if file didn't change
+    bool Get( HeaderContent& content )
+    {
+        auto it = Records.find( content.Key );
+        if( it == Records.end() )
+            return false;
+
+        const SnapshotRecord* record = reinterpret_cast<const SnapshotRecord*>(it->second);
+        if( record->Time != content.Time || record->Size != content.Size || record->Hash != content.Hash )
+            return false;
+
+        const SnapshotDefine* defines = reinterpret_cast<const SnapshotDefine*>(it->second + sizeof(SnapshotRecord) );
+        const char*           names = reinterpret_cast<const char*>(defines + record->Defines) + record->KeyLength;
+
+        content.Defines.reserve( record->Defines );
+        for( uint32_t idx = 0; idx < record->Defines; idx++ )
+        {
+            content.Defines.push_back( { defines[idx].Line, defines[idx].Value, std::string_view( names + defines[idx].NameOffset, defines[idx].NameLength ) } );
+        }
+
+        return true;
+    }
+
+    bool Save( ReDefine* root, const std::string& filename )
+    {
+        std::string data;
+
+        auto        append = [&data] ( const void* ptr, size_t size ) {
+                                 data.append( static_cast<const char*>(ptr), size );
+                             };
+
+        SnapshotHead head;
+        std::memcpy( head.Magic, SnapshotMagic, sizeof(SnapshotMagic) );
+        head.Version = SnapshotVersion;
+        head.Records = static_cast<uint32_t>(Headers.size() );
+        append( &head, sizeof(head) );
+
+        const size_t          offsetsPos = data.size();
+        std::vector<uint64_t> offsets( Headers.size(), 0 );
+        append( offsets.data(), offsets.size() * sizeof(uint64_t) );
+
+        for( size_t idx = 0; idx < Headers.size(); idx++ )
+        {
+            const HeaderContent& content = *Headers[idx];
+
+            data.resize( (data.size() + alignof(SnapshotRecord) - 1) / alignof(SnapshotRecord) * alignof(SnapshotRecord), '\0' );
+            offsets[idx] = data.size();
+
+            std::string    names;
+            SnapshotRecord record;
+            record.Time = content.Time;
+            record.Size = content.Size;
+            record.Hash = content.Hash;
+            record.Defines = static_cast<uint32_t>(content.Defines.size() );
+            record.KeyLength = static_cast<uint32_t>(content.Key.size() );
+            record.Reserved = 0;
+
+            std::vector<SnapshotDefine> defines;
+            for( const HeaderDefine& define : content.Defines )
+            {
+                defines.push_back( { define.Line, define.Value, static_cast<uint32_t>(names.size() ), static_cast<uint32_t>(define.Name.size() ) } );
+                names.append( define.Name );
+            }
+
+            record.NamesLength = static_cast<uint32_t>(names.size() );
+
+            append( &record, sizeof(record) );
+            append( defines.data(), defines.size() * sizeof(SnapshotDefine) );
+            append( content.Key.data(), content.Key.size() );
+            append( names.data(), names.size() );
+        }
+
+        std::memcpy( &data[offsetsPos], offsets.data(), offsets.size() * sizeof(uint64_t) );
+
+        return root->WriteFile( filename, data.data(), data.size() );
+    }
+};
+
+//
+// expressions
+//
+// integer expressions used as define values, in headers and scripts
+// supports decimal and hex numbers, define names, parens and operators (from highest to lowest priority):
+//   - bwnot (unary)
+//   * / %
+//   + -
+//   bwand
+//   bwxor
+//   bwor
+// every partial result must fit in int32_t
+//
+
+struct Expression
+{
+    // returns false if name is unknown
+    using Resolver = std::function<bool(const std::string_view& name, int64_t& value)>;
+
+    const std::string_view Text;
+    const Resolver&        Resolve;
+
+    size_t                 Pos = 0;
+    uint32_t               Depth = 0;
+    uint32_t               Operations = 0;
+    uint32_t               References = 0;
+    bool                   DivisionByZero = false;
+
+    Expression( const std::string_view& text, const Resolver& resolve ) : Text( text ), Resolve( resolve )
+    {}
+
+    static bool IsNameChar( const char ch )
+    {
+        return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '_';
+    }
+
+    static bool IsValid( const int64_t value )
+    {
+        return value >= INT32_MIN && value <= INT32_MAX;
+    }
+
+    void SkipBlank()
+    {
+        while( Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t') )
+        {
+            Pos++;
+        }
+    }
+
+    std::string_view GetName()
+    {
+        size_t end = Pos;
+        while( end < Text.size() && IsNameChar( Text[end] ) )
+        {
+            end++;
+        }
+
+        return Text.substr( Pos, end - Pos );
+    }
+
+    // skips operator if it's next in text
+    bool IsOperator( const std::string_view& op )
+    {
+        SkipBlank();
+
+        if( Text.substr( Pos, op.size() ) != op || (IsNameChar( op.front() ) && Pos + op.size() < Text.size() && IsNameChar( Text[Pos + op.size()] ) ) )
+            return false;
+
+        Pos += op.size();
+        Operations++;
+
+        return true;
+    }
+
+    bool Evaluate( int64_t& value )
+    {
+        if( !GetOr( value ) )
+            return false;
+
+        SkipBlank();
+
+        return Pos == Text.size();
+    }
+
+    bool GetOr( int64_t& value )
+    {
+        if( !GetXor( value ) )
+            return false;
+
+        int64_t right;
+        while( IsOperator( "bwor" ) )
+        {
+            if( !GetXor( right ) )
+                return false;
+
+            value = static_cast<int32_t>(value) | static_cast<int32_t>(right);
+        }
+
+        return true;
+    }
+
+    bool GetXor( int64_t& value )
+    {
+        if( !GetAnd( value ) )
+            return false;
+
+        int64_t right;
+        while( IsOperator( "bwxor" ) )
+        {
+            if( !GetAnd( right ) )
+                return false;
+
+            value = static_cast<int32_t>(value) ^ static_cast<int32_t>(right);
+        }
+
+        return true;
+    }
+
+    bool GetAnd( int64_t& value )
+    {
+        if( !GetSum( value ) )
+            return false;
+
+        int64_t right;
+        while( IsOperator( "bwand" ) )
+        {
+            if( !GetSum( right ) )
+                return false;
+
+            value = static_cast<int32_t>(value) & static_cast<int32_t>(right);
+        }
+
+        return true;
+    }
+
+    bool GetSum( int64_t& value )
+    {
+        if( !GetProduct( value ) )
+            return false;
+
+        int64_t right;
+        while( true )
+        {
+            const bool plus = IsOperator( "+" );
+            if( !plus && !IsOperator( "-" ) )
+                break;
+
+            if( !GetProduct( right ) )
+                return false;
+
+            value = plus ? value + right : value - right;
+            if( !IsValid( value ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetProduct( int64_t& value )
+    {
+        if( !GetUnary( value ) )
+            return false;
+
+        int64_t right;
+        while( true )
+        {
+            const char op = IsOperator( "*" ) ? '*' : IsOperator( "/" ) ? '/' : IsOperator( "%" ) ? '%' : 0;
+            if( !op )
+                break;
+
+            if( !GetUnary( right ) )
+                return false;
+
+            if( op != '*' && !right )
+            {
+                DivisionByZero = true;
+                return false;
+            }
+
+            value = op == '*' ? value * right : op == '/' ? value / right : value % right;
+            if( !IsValid( value ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetUnary( int64_t& value )
+    {
+        std::string unary;
+        while( true )
+        {
+            if( IsOperator( "-" ) )
+                unary += '-';
+            else if( IsOperator( "bwnot" ) )
+                unary += '~';
+            else
+                break;
+        }
+
+        if( !GetPrimary( value ) )
+            return false;
+
+        // applied from right to left
+        for( auto it = unary.rbegin(); it != unary.rend(); ++it )
+        {
+            value = *it == '-' ? -value : ~static_cast<int32_t>(value);
+            if( !IsValid( value ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetPrimary( int64_t& value )
+    {
+        SkipBlank();
+
+        if( Pos == Text.size() || Depth >= 64 )
+            return false;
+
+        // (expression)
+        if( Text[Pos] == '(' )
+        {
+            Pos++;
+            Depth++;
+
+            if( !GetOr( value ) )
+                return false;
+
+            SkipBlank();
+            if( Pos == Text.size() || Text[Pos] != ')' )
+                return false;
+
+            Pos++;
+            Depth--;
+
+            return true;
+        }
+
+        const std::string_view name = GetName();
+        if( name.empty() )
+            return false;
+
+        Pos += name.size();
+
+        // number
+        if( name.front() >= '0' && name.front() <= '9' )
+        {
+            const bool hex = name.size() > 2 && name[0] == '0' && (name[1] == 'x' || name[1] == 'X');
+            value = 0;
+
+            for( size_t idx = hex ? 2 : 0; idx < name.size(); idx++ )
+            {
+                const char ch = name[idx];
+                int64_t    digit;
+
+                if( ch >= '0' && ch <= '9' )
+                    digit = ch - '0';
+                else if( hex && ch >= 'a' && ch <= 'f' )
+                    digit = ch - 'a' + 10;
+                else if( hex && ch >= 'A' && ch <= 'F' )
+                    digit = ch - 'A' + 10;
+                else
+                    return false;
+
+                value = value * (hex ? 16 : 10) + digit;
+                if( value > UINT32_MAX )
+                    return false;
+            }
+
+            // hex numbers are allowed to set highest bit
+            if( hex )
+                value = static_cast<int32_t>(static_cast<uint32_t>(value) );
+
+            return IsValid( value );
+        }
+
+        // define
+        References++;
+        return Resolve( name, value ) && IsValid( value );
+    }
+};
+
+// defines found in single header file, used to resolve names in expressions
+// each define is evaluated only once; if name is defined multiple times, first definition is used
+struct HeaderExpressions
+{
+    std::unordered_map<std::string_view, std::string_view>       Values;
+    std::unordered_map<std::string_view, std::optional<int64_t>> Results; // empty result if define is invalid, or still being evaluated
+    Expression::Resolver                                         Resolve;
+    uint32_t                                                     Depth = 0;
+
+    HeaderExpressions()
+    {
+        Resolve = [this] ( const std::string_view& name, int64_t& value ) {
+                      return Get( name, value );
+                  };
+    }
+
+    bool Get( const std::string_view& name, int64_t& value )
+    {
+        auto it = Results.find( name );
+        if( it == Results.end() )
+        {
+            auto itValue = Values.find( name );
+            if( itValue == Values.end() || Depth >= 64 )
+                return false;
+
+            // guard against defines using each other
+            it = Results.emplace( name, std::nullopt ).first;
+
+            int64_t result;
+            Depth++;
+            if( Evaluate( itValue->second, result ) )
+                Results[name] = result;
+            Depth--;
+
+            it = Results.find( name );
+        }
+
+        if( !it->second )
+            return false;
+
+        value = *it->second;
+        return true;
+    }
+
+    bool Evaluate( const std::string_view& text, int64_t& value )
+    {
+        Expression expression( text, Resolve );
+
+        return expression.Evaluate( value );
+    }
+};
+
 //
 
 void ReDefine::FinishDefines()
@@ -22,6 +603,7 @@ void ReDefine::FinishDefines()
     RegularDefines.clear();
     ProgramDefines.clear();
     VirtualDefines.clear();
+    DefineExpressions.clear();
 }
 
 // reading
@@ -226,7 +808,374 @@ bool ReDefine::GetDefineValue( const std::string& type, const std::string& value
 
 // processing
 
-bool ReDefine::ProcessHeader( const std::string& path, const ReDefine::Header& header )
+// header read and parsed by worker thread; tables are merged into defines maps in config order
+struct ReDefine::HeaderTable
+{
+    bool                    Loaded = false;
+    bool                    Parsed = false; // false if defines were taken from snapshot
+    HeaderContent           Content;
+    std::vector<LogMessage> Messages;       // logged while reading header; shown only when header is merged
+};
+
+// all headers using same file; file is read and scanned only once
+struct HeaderFile
+{
+    std::string                                                             Filename;
+    std::vector<std::pair<const ReDefine::Header*, ReDefine::HeaderTable*>> Headers;
+};
+
+// routes define names to headers with matching prefix and suffix
+// prefixes are stored in trie, so each name is walked only once, no matter how many headers are using file
+struct HeaderTrie
+{
+    struct Node
+    {
+        std::map<char, uint32_t>                    Next;
+        std::vector<std::pair<std::string, size_t>> Ends; // <suffix, header> for headers which prefix ends at this node
+    };
+
+    std::vector<Node> Nodes;
+
+    HeaderTrie() : Nodes( 1 )
+    {}
+
+    // prefix/suffix are used as given; separators must be already added
+    void Add( const std::string& prefix, const std::string& suffix, const size_t header )
+    {
+        uint32_t node = 0;
+        for( const char ch : prefix )
+        {
+            auto it = Nodes[node].Next.find( ch );
+            if( it == Nodes[node].Next.end() )
+            {
+                it = Nodes[node].Next.emplace( ch, static_cast<uint32_t>(Nodes.size() ) ).first;
+                Nodes.emplace_back();
+            }
+
+            node = it->second;
+        }
+
+        Nodes[node].Ends.emplace_back( suffix, header );
+    }
+
+    // name must contain at least one character between prefix and suffix
+    void Get( const std::string_view& name, std::vector<size_t>& headers ) const
+    {
+        headers.clear();
+
+        for( size_t pos = 0, node = 0; ; pos++ )
+        {
+            for( const auto& end : Nodes[node].Ends )
+            {
+                if( name.size() > pos + end.first.size() && name.ends_with( end.first ) )
+                    headers.push_back( end.second );
+            }
+
+            if( pos == name.size() )
+                break;
+
+            auto it = Nodes[node].Next.find( name[pos] );
+            if( it == Nodes[node].Next.end() )
+                break;
+
+            node = it->second;
+        }
+    }
+};
+
+// integer value, optionally in parens; anything after value is ignored
+static bool GetDefineInt( ReDefine* root, const std::string_view& text, int32_t& value )
+{
+    const bool paren = !text.empty() && text.front() == '(';
+    size_t     pos = paren ? 1 : 0, end = pos;
+
+    if( end < text.size() && text[end] == '-' )
+        end++;
+
+    const size_t digits = end;
+    while( end < text.size() && text[end] >= '0' && text[end] <= '9' )
+    {
+        end++;
+    }
+
+    if( end == digits || (paren && (end == text.size() || text[end] != ')') ) )
+        return false;
+
+    return root->TextGetInt( std::string( text.substr( pos, end - pos ) ), value );
+}
+
+// removes comments from define value; storage is used only if value needs to be changed
+static std::string_view GetDefineUncommented( std::string_view value, std::deque<std::string>& storage )
+{
+    if( value.find( "/" ) != std::string_view::npos )
+    {
+        std::string result;
+
+        for( size_t pos = 0; pos < value.size(); pos++ )
+        {
+            if( value.substr( pos, 2 ) == "//" )
+                break;
+            else if( value.substr( pos, 2 ) == "/*" )
+            {
+                pos = value.find( "*/", pos + 2 );
+                if( pos == std::string_view::npos )
+                    break;
+
+                result += ' ';
+                pos++;
+            }
+            else
+                result += value[pos];
+        }
+
+        storage.push_back( std::move( result ) );
+        value = storage.back();
+    }
+
+    while( !value.empty() && (value.back() == ' ' || value.back() == '\t') )
+    {
+        value.remove_suffix( 1 );
+    }
+
+    return value;
+}
+
+// returns true if define value is only a name of other define, optionally in parens
+// such defines are aliases; they can be used in expressions, but are never added to defines tables, so they cannot take over names they're pointing to
+static bool IsDefineAlias( std::string_view value )
+{
+    while( true )
+    {
+        while( !value.empty() && (value.front() == ' ' || value.front() == '\t') )
+        {
+            value.remove_prefix( 1 );
+        }
+
+        while( !value.empty() && (value.back() == ' ' || value.back() == '\t') )
+        {
+            value.remove_suffix( 1 );
+        }
+
+        if( value.size() < 2 || value.front() != '(' || value.back() != ')' )
+            break;
+
+        value = value.substr( 1, value.size() - 2 );
+    }
+
+    if( value.empty() || (value.front() >= '0' && value.front() <= '9') )
+        return false;
+
+    return std::all_of( value.begin(), value.end(), Expression::IsNameChar );
+}
+
+// reads and parses header file; must not change anything outside of given tables
+static void ParseHeaderFile( ReDefine* root, HeaderFile& file, ReDefine::HeadersSnapshot* snapshot )
+{
+    // read content
+    std::vector<char>                 data;
+    std::vector<ReDefine::LogMessage> messages;
+
+    root->LogCapture( &messages );
+    const bool loaded = root->ReadFile( file.Filename, data );
+    root->LogCapture( nullptr );
+
+    std::error_code error;
+    const int64_t   time = loaded ? std::filesystem::last_write_time( file.Filename, error ).time_since_epoch().count() : 0;
+    const uint64_t  hash = loaded ? root->TextGetHash( data.data(), data.size() ) : 0;
+
+    // parse content only for headers which are not available in snapshot
+    HeaderTrie                                             trie;
+    std::vector<std::vector<std::pair<uint32_t, int32_t>>> found( file.Headers.size() );
+    bool                                                   parse = false;
+
+    for( size_t idx = 0; idx < file.Headers.size(); idx++ )
+    {
+        const ReDefine::Header& header = *file.Headers[idx].first;
+        ReDefine::HeaderTable&  table = *file.Headers[idx].second;
+
+        table.Loaded = loaded;
+        table.Messages = messages;
+        if( !loaded )
+            continue;
+
+        HeaderContent& content = table.Content;
+        content.Key = file.Filename + '\0' + header.Prefix + '\0' + header.Suffix;
+        content.Time = time;
+        content.Size = data.size();
+        content.Hash = hash;
+
+        if( snapshot && snapshot->Get( content ) )
+            continue;
+
+        table.Parsed = parse = true;
+        trie.Add( header.Prefix.empty() ? "" : header.Prefix + "_", header.Suffix.empty() ? "" : "_" + header.Suffix, idx );
+    }
+
+    if( !parse )
+        return;
+
+    // all defines are collected first, as values can use defines placed further in file
+    struct HeaderLine
+    {
+        uint32_t         Number;
+        std::string_view Name;
+        std::string_view Value;
+        std::string_view Expression;
+    };
+
+    std::deque<std::string> stripped;  // lines changed before parsing
+    std::vector<HeaderLine> lines;
+    HeaderExpressions       expressions;
+    std::string_view        name, value;
+    uint32_t                lineNumber = 0;
+
+    for( size_t pos = 0, len = data.size(); pos < len;)
+    {
+        const char* begin = data.data() + pos;
+        const char* end = static_cast<const char*>(std::memchr( begin, '\n', len - pos ) );
+        if( !end )
+            end = data.data() + len;
+
+        std::string_view line( begin, end - begin );
+        pos = end - data.data() + 1;
+
+        lineNumber++;
+
+        while( !line.empty() && line.back() == '\r' )
+        {
+            line.remove_suffix( 1 );
+        }
+
+        if( line.find( '\r' ) != std::string_view::npos )
+        {
+            stripped.emplace_back( line );
+            std::erase( stripped.back(), '\r' );
+            line = stripped.back();
+        }
+
+        // ignore random lines
+        if( !root->TextGetDefine( line, name, value ) )
+            continue;
+
+        lines.push_back( { lineNumber, name, value, GetDefineUncommented( value, stripped ) } );
+        expressions.Values.emplace( name, lines.back().Expression );
+    }
+
+    std::vector<size_t> headers;
+    int64_t             result;
+    int32_t             number;
+
+    for( const HeaderLine& line : lines )
+    {
+        trie.Get( line.Name, headers );
+        if( headers.empty() || IsDefineAlias( line.Expression ) )
+            continue;
+
+        // values which are not valid expressions are still accepted if they start with number
+        if( expressions.Values[line.Name].data() == line.Expression.data() ? expressions.Get( line.Name, result ) : expressions.Evaluate( line.Expression, result ) )
+            number = static_cast<int32_t>(result);
+        else if( !GetDefineInt( root, line.Value, number ) )
+            continue;
+
+        for( const size_t header : headers )
+        {
+            found[header].emplace_back( line.Number, number );
+            file.Headers[header].second->Content.Names.emplace_back( line.Name );
+        }
+    }
+
+    // names storage must not change after string_view is created
+    for( size_t header = 0; header < file.Headers.size(); header++ )
+    {
+        HeaderContent& content = file.Headers[header].second->Content;
+
+        for( size_t idx = 0; idx < found[header].size(); idx++ )
+        {
+            content.Defines.push_back( { found[header][idx].first, found[header][idx].second, content.Names[idx] } );
+        }
+    }
+}
+
+struct HeadersParse
+{
+    ReDefine*                  Root;
+    ReDefine::HeadersSnapshot* Snapshot; // read-only until all headers are parsed
+    std::vector<HeaderFile>*   Files;
+    std::atomic<size_t>        Next { 0 };
+};
+
+static void ParseHeaders( HeadersParse* parse )
+{
+    for( size_t idx = parse->Next++; idx < parse->Files->size(); idx = parse->Next++ )
+    {
+        ParseHeaderFile( parse->Root, (*parse->Files)[idx], parse->Snapshot );
+    }
+}
+
+void ReDefine::ProcessHeadersDefines( const std::string& path )
+{
+    HeadersSnapshot  snapshotData;
+    HeadersSnapshot* snapshot = nullptr;
+
+    if( !DefinesSnapshot.empty() )
+    {
+        if( !snapshotData.Load( this, DefinesSnapshot ) )
+            DEBUG( __FUNCTION__, "defines snapshot<%s> not used", DefinesSnapshot.c_str() );
+
+        snapshot = &snapshotData;
+    }
+
+    // headers don't depend on each other until they're merged
+    std::vector<HeaderTable>      tables( Headers.size() );
+    std::vector<HeaderFile>       files;
+    std::map<std::string, size_t> filesIndex;
+
+    for( size_t idx = 0; idx < Headers.size(); idx++ )
+    {
+        const std::string filename = TextGetFilename( path, Headers[idx].Filename );
+
+        auto              it = filesIndex.find( filename );
+        if( it == filesIndex.end() )
+        {
+            it = filesIndex.emplace( filename, files.size() ).first;
+            files.push_back( { filename, {} } );
+        }
+
+        files[it->second].Headers.emplace_back( &Headers[idx], &tables[idx] );
+    }
+
+    HeadersParse             parse { this, snapshot, &files };
+
+    const uint32_t           workers = std::clamp<uint32_t>( static_cast<uint32_t>(std::min<size_t>( std::thread::hardware_concurrency(), files.size() ) ), 1, 8 );
+    std::vector<std::thread> threads;
+
+    for( uint32_t idx = 1; idx < workers; idx++ )
+    {
+        threads.emplace_back( ParseHeaders, &parse );
+    }
+
+    ParseHeaders( &parse );
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    for( size_t idx = 0; idx < Headers.size(); idx++ )
+    {
+        ProcessHeader( path, Headers[idx], snapshot, &tables[idx] );
+    }
+
+    // headers can be removed from config without changing remaining ones
+    if( snapshot && (snapshot->Changed || snapshot->Records.size() != snapshot->Headers.size() ) )
+    {
+        if( !snapshot->Save( this, DefinesSnapshot ) )
+            WARNING( __FUNCTION__, "cannot save defines snapshot<%s>", DefinesSnapshot.c_str() );
+    }
+}
+
+// if table is not given, header is parsed in current thread
+bool ReDefine::ProcessHeader( const std::string& path, const ReDefine::Header& header, HeadersSnapshot* snapshot /* = nullptr */, HeaderTable* table /* = nullptr */ )
 {
     if( path.empty() )
     {
@@ -254,48 +1203,49 @@ bool ReDefine::ProcessHeader( const std::string& path, const ReDefine::Header& h
         return false;
     }
 
-    // read content
-    std::vector<std::string> lines;
-    if( !ReadFile( TextGetFilename( path, header.Filename ), lines ) )
+    HeaderTable parsed;
+    if( !table )
+    {
+        HeaderFile file { TextGetFilename( path, header.Filename ), { { &header, &parsed } } };
+        ParseHeaderFile( this, file, snapshot );
+        table = &parsed;
+    }
+
+    LogReplay( table->Messages );
+
+    if( !table->Loaded )
         return false;
 
+    HeaderContent& content = table->Content;
+
+    if( snapshot && table->Parsed )
+        snapshot->Changed = true;
+
     // update status
     Status.Current.Clear();
     Status.Current.File = header.Filename;
     Status.Current.LineNumber = 0;
 
-    // cache patterns
-    std::regex  reParen = TextGetDefineIntRegex( header.Prefix, header.Suffix, true );
-    std::regex  reNoParen = TextGetDefineIntRegex( header.Prefix, header.Suffix, false );
-
-    std::string name;
-    int         value;
-
-    for( const std::string& line : lines )
+    for( const HeaderDefine& define : content.Defines )
     {
-        Status.Current.LineNumber++;
-
-        // ignore random lines
-        if( !TextIsDefine( line ) )
-            continue;
+        Status.Current.LineNumber = define.Line;
 
-        // find defines with given prefix
-        if( TextGetDefineInt( line, reParen, name, value ) || TextGetDefineInt( line, reNoParen, name, value ) )
+        // human detection
+        if( RegularDefines[header.Type].find( define.Value ) != RegularDefines[header.Type].end() )
         {
-            // human detection
-            if( RegularDefines[header.Type].find( value ) != RegularDefines[header.Type].end() )
-            {
-                WARNING( nullptr, "value<%d> already used by define<%s>, current define<%s> ignored", value, RegularDefines[header.Type][value].c_str(), name.c_str() );
-                continue;
-            }
+            WARNING( nullptr, "value<%d> already used by define<%s>, current define<%s> ignored", define.Value, RegularDefines[header.Type][define.Value].c_str(), std::string( define.Name ).c_str() );
+            continue;
+        }
 
-            RegularDefines[header.Type][value] = name;
+        RegularDefines[header.Type][define.Value] = define.Name;
 
-            if( !header.Group.empty() )
-                VirtualDefines[header.Group].push_back( header.Type );
-        }
+        if( !header.Group.empty() )
+            VirtualDefines[header.Group].push_back( header.Type );
     }
 
+    if( snapshot )
+        snapshot->Headers.push_back( std::make_unique<HeaderContent>( std::move( content ) ) );
+
     Status.Current.Clear();
 
     std::string what;
@@ -320,10 +1270,47 @@ bool ReDefine::ProcessHeader( const std::string& path, const ReDefine::Header& h
     return true;
 }
 
-bool ReDefine::ProcessValue( const std::string& type, std::string& value, const bool silent /* = false */ )
+// expressions are cached, as their value never changes after headers are processed
+ReDefine::DefineExpression ReDefine::GetDefineExpression( const std::string& type, const std::string& expression )
 {
-    std::smatch match;
+    {
+        std::lock_guard<std::mutex> lock( DefineExpressionsLock );
+
+        auto                        itType = DefineExpressions.find( type );
+        if( itType != DefineExpressions.end() )
+        {
+            auto it = itType->second.find( expression );
+            if( it != itType->second.end() )
+                return it->second;
+        }
+    }
 
+    Expression::Resolver resolve = [this, &type] ( const std::string_view& name, int64_t& value ) {
+                                       int result;
+                                       if( !GetDefineValue( type, std::string( name ), result ) )
+                                           return false;
+
+                                       value = result;
+                                       return true;
+                                   };
+
+    Expression       parser( expression, resolve );
+    DefineExpression result;
+    int64_t          value;
+
+    // single define name is not an expression
+    result.Valid = parser.Evaluate( value ) && (parser.Operations || !parser.References);
+    result.DivisionByZero = parser.DivisionByZero;
+    result.Value = result.Valid ? static_cast<int32_t>(value) : 0;
+
+    std::lock_guard<std::mutex> lock( DefineExpressionsLock );
+    DefineExpressions[type][expression] = result;
+
+    return result;
+}
+
+bool ReDefine::ProcessValue( const std::string& type, std::string& value, const bool silent /* = false */ )
+{
     if( !IsDefineType( type ) )
     {
         if( !silent )
@@ -344,55 +1331,35 @@ bool ReDefine::ProcessValue( const std::string& type, std::string& value, const
         if( GetDefineName( type, val, value ) )
             return true;
     }
-    // check if it's just simple math
-    else if( std::regex_match( value, match, IsSimpleMath ) )
+    // check if it's an expression
+    else
     {
-        int               left, right;
-        const std::string math = match.str( 2 );
+        const DefineExpression expression = GetDefineExpression( type, value );
 
-        if( TextGetInt( match.str( 1 ), left ) && TextGetInt( match.str( 3 ), right ) )
+        // don't get into trouble due to shitty modders
+        if( expression.DivisionByZero )
         {
-            if( math == "*" )
-                val = left * right;
-            else if( math == "/" )
-            {
-                // don't get into trouble due to shitty modders
-                if( right == 0 )
-                {
-                    if( !silent )
-                        WARNING( __FUNCTION__, "DIVISION BY ZERO" );
-                    return false;
-                }
+            if( !silent )
+                WARNING( __FUNCTION__, "DIVISION BY ZERO" );
 
-                val = left / right;
-            }
-            else if( math == "+" )
-                val = left + right;
-            else if( math == "-" )
-                val = left - right;
-            else
-            {
-                if( !silent )
-                    WARNING( __FUNCTION__, "???" );
-
-                return false;
-            }
-
-            if( GetDefineName( type, val, value ) )
-                return true;        // great success!
-            else
-                useVal = true;      // math failed us
+            return false;
         }
+        else if( !expression.Valid )
+            return false;
+
+        val = expression.Value;
+        if( GetDefineName( type, val, value ) )
+            return true;        // great success!
+        else
+            useVal = true;      // math failed us
     }
-    else
-        return false;
 
     if( !silent )
     {
         std::string unknown = useVal ? std::to_string( val ) : value;
 
         WARNING( nullptr, "unknown %s<%s>", type.c_str(), unknown.c_str() );
-        Status.Process.Counters["!Unknown " + type + "!"][unknown]++;
+        CountUnknown( type, unknown );
     }
 
     return false;
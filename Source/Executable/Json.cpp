@@ -0,0 +1,486 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Json.h"
+
+namespace
+{
+    struct Parser
+    {
+        // arrays/objects nested deeper than that are rejected, so malformed (or malicious) message cannot exhaust stack
+        static const uint32_t DepthLimit = 256;
+
+        const std::string&    Text;
+        size_t                Pos;
+        uint32_t              Depth;
+
+        Parser( const std::string& text ) : Text( text ), Pos( 0 ), Depth( 0 )
+        {}
+
+        void SkipSpace()
+        {
+            while( Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t' || Text[Pos] == '\r' || Text[Pos] == '\n') )
+            {
+                Pos++;
+            }
+        }
+
+        bool Skip( const char* word )
+        {
+            const std::string what( word );
+            if( Text.compare( Pos, what.size(), what ) != 0 )
+                return false;
+
+            Pos += what.size();
+            return true;
+        }
+
+        bool GetHex( uint32_t& result )
+        {
+            if( Pos + 4 > Text.size() )
+                return false;
+
+            result = 0;
+            for( uint8_t idx = 0; idx < 4; idx++ )
+            {
+                const char c = Text[Pos++];
+                result <<= 4;
+
+                if( c >= '0' && c <= '9' )
+                    result |= c - '0';
+                else if( c >= 'a' && c <= 'f' )
+                    result |= c - 'a' + 10;
+                else if( c >= 'A' && c <= 'F' )
+                    result |= c - 'A' + 10;
+                else
+                    return false;
+            }
+
+            return true;
+        }
+
+        static void PutUtf8( std::string& result, uint32_t code )
+        {
+            if( code < 0x80 )
+                result += static_cast<char>(code);
+            else if( code < 0x800 )
+            {
+                result += static_cast<char>(0xC0 | (code >> 6) );
+                result += static_cast<char>(0x80 | (code & 0x3F) );
+            }
+            else if( code < 0x10000 )
+            {
+                result += static_cast<char>(0xE0 | (code >> 12) );
+                result += static_cast<char>(0x80 | ( (code >> 6) & 0x3F ) );
+                result += static_cast<char>(0x80 | (code & 0x3F) );
+            }
+            else
+            {
+                result += static_cast<char>(0xF0 | (code >> 18) );
+                result += static_cast<char>(0x80 | ( (code >> 12) & 0x3F ) );
+                result += static_cast<char>(0x80 | ( (code >> 6) & 0x3F ) );
+                result += static_cast<char>(0x80 | (code & 0x3F) );
+            }
+        }
+
+        bool GetString( std::string& result )
+        {
+            if( Pos >= Text.size() || Text[Pos] != '"' )
+                return false;
+
+            Pos++;
+            while( Pos < Text.size() )
+            {
+                const char c = Text[Pos++];
+
+                if( c == '"' )
+                    return true;
+                else if( c != '\\' )
+                {
+                    result += c;
+                    continue;
+                }
+
+                if( Pos >= Text.size() )
+                    return false;
+
+                const char escaped = Text[Pos++];
+                switch( escaped )
+                {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        result += escaped;
+                        break;
+                    case 'b':
+                        result += '\b';
+                        break;
+                    case 'f':
+                        result += '\f';
+                        break;
+                    case 'n':
+                        result += '\n';
+                        break;
+                    case 'r':
+                        result += '\r';
+                        break;
+                    case 't':
+                        result += '\t';
+                        break;
+                    case 'u':
+                    {
+                        uint32_t code;
+                        if( !GetHex( code ) )
+                            return false;
+
+                        // surrogate pair
+                        if( code >= 0xD800 && code <= 0xDBFF && Skip( "\\u" ) )
+                        {
+                            uint32_t low;
+                            if( !GetHex( low ) || low < 0xDC00 || low > 0xDFFF )
+                                return false;
+
+                            code = 0x10000 + ( (code - 0xD800) << 10 ) + (low - 0xDC00);
+                        }
+
+                        PutUtf8( result, code );
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+
+            return false;
+        }
+
+        bool GetValue( Json& result )
+        {
+            if( Depth >= DepthLimit )
+                return false;
+
+            Depth++;
+            const bool parsed = GetValueContent( result );
+            Depth--;
+
+            return parsed;
+        }
+
+        bool GetValueContent( Json& result )
+        {
+            SkipSpace();
+            if( Pos >= Text.size() )
+                return false;
+
+            const char c = Text[Pos];
+
+            if( c == '{' )
+            {
+                Pos++;
+                result = Json::MakeObject();
+
+                SkipSpace();
+                if( Pos < Text.size() && Text[Pos] == '}' )
+                {
+                    Pos++;
+                    return true;
+                }
+
+                while( true )
+                {
+                    std::string key;
+
+                    SkipSpace();
+                    if( !GetString( key ) )
+                        return false;
+
+                    SkipSpace();
+                    if( !Skip( ":" ) )
+                        return false;
+
+                    if( !GetValue( result.Object[key] ) )
+                        return false;
+
+                    SkipSpace();
+                    if( Skip( "}" ) )
+                        return true;
+                    else if( !Skip( "," ) )
+                        return false;
+                }
+            }
+            else if( c == '[' )
+            {
+                Pos++;
+                result = Json::MakeArray();
+
+                SkipSpace();
+                if( Pos < Text.size() && Text[Pos] == ']' )
+                {
+                    Pos++;
+                    return true;
+                }
+
+                while( true )
+                {
+                    result.Array.emplace_back();
+                    if( !GetValue( result.Array.back() ) )
+                        return false;
+
+                    SkipSpace();
+                    if( Skip( "]" ) )
+                        return true;
+                    else if( !Skip( "," ) )
+                        return false;
+                }
+            }
+            else if( c == '"' )
+            {
+                result = Json( std::string() );
+                return GetString( result.String );
+            }
+            else if( Skip( "true" ) )
+                result = Json( true );
+            else if( Skip( "false" ) )
+                result = Json( false );
+            else if( Skip( "null" ) )
+                result = Json();
+            else
+            {
+                const char* begin = Text.c_str() + Pos;
+                char*       end = nullptr;
+                double      number = std::strtod( begin, &end );
+
+                if( end == begin )
+                    return false;
+
+                Pos += end - begin;
+                result = Json( number );
+            }
+
+            return true;
+        }
+    };
+
+    void DumpString( const std::string& text, std::string& result )
+    {
+        result += '"';
+
+        for( const char c : text )
+        {
+            switch( c )
+            {
+                case '"':
+                    result += "\\\"";
+                    break;
+                case '\\':
+                    result += "\\\\";
+                    break;
+                case '\n':
+                    result += "\\n";
+                    break;
+                case '\r':
+                    result += "\\r";
+                    break;
+                case '\t':
+                    result += "\\t";
+                    break;
+                default:
+                    if( static_cast<unsigned char>(c) < 0x20 )
+                    {
+                        char code[7];
+                        std::snprintf( code, sizeof(code), "\\u%04x", c );
+                        result += code;
+                    }
+                    else
+                        result += c;
+            }
+        }
+
+        result += '"';
+    }
+
+    void DumpValue( const Json& value, std::string& result )
+    {
+        switch( value.Kind )
+        {
+            case Json::Type::NIL:
+                result += "null";
+                break;
+            case Json::Type::BOOL:
+                result += value.Bool ? "true" : "false";
+                break;
+            case Json::Type::NUMBER:
+                if( value.Number == std::floor( value.Number ) && std::fabs( value.Number ) < 1e15 )
+                    result += std::to_string( static_cast<int64_t>(value.Number) );
+                else
+                {
+                    char number[32];
+                    std::snprintf( number, sizeof(number), "%.17g", value.Number );
+                    result += number;
+                }
+                break;
+            case Json::Type::STRING:
+                DumpString( value.String, result );
+                break;
+            case Json::Type::ARRAY:
+            {
+                result += '[';
+                bool first = true;
+                for( const Json& item : value.Array )
+                {
+                    if( !first )
+                        result += ',';
+
+                    DumpValue( item, result );
+                    first = false;
+                }
+                result += ']';
+                break;
+            }
+            case Json::Type::OBJECT:
+            {
+                result += '{';
+                bool first = true;
+                for( const auto& item : value.Object )
+                {
+                    if( !first )
+                        result += ',';
+
+                    DumpString( item.first, result );
+                    result += ':';
+                    DumpValue( item.second, result );
+                    first = false;
+                }
+                result += '}';
+                break;
+            }
+        }
+    }
+}
+
+Json::Json() : Kind( Type::NIL ), Bool( false ), Number( 0 )
+{}
+
+Json::Json( bool value ) : Kind( Type::BOOL ), Bool( value ), Number( 0 )
+{}
+
+Json::Json( int value ) : Kind( Type::NUMBER ), Bool( false ), Number( value )
+{}
+
+Json::Json( int64_t value ) : Kind( Type::NUMBER ), Bool( false ), Number( static_cast<double>(value) )
+{}
+
+Json::Json( double value ) : Kind( Type::NUMBER ), Bool( false ), Number( value )
+{}
+
+Json::Json( const char* value ) : Kind( Type::STRING ), Bool( false ), Number( 0 ), String( value )
+{}
+
+Json::Json( const std::string& value ) : Kind( Type::STRING ), Bool( false ), Number( 0 ), String( value )
+{}
+
+Json Json::MakeArray()
+{
+    Json result;
+    result.Kind = Type::ARRAY;
+
+    return result;
+}
+
+Json Json::MakeObject()
+{
+    Json result;
+    result.Kind = Type::OBJECT;
+
+    return result;
+}
+
+bool Json::IsNull() const
+{
+    return Kind == Type::NIL;
+}
+
+bool Json::IsNumber() const
+{
+    return Kind == Type::NUMBER;
+}
+
+bool Json::IsString() const
+{
+    return Kind == Type::STRING;
+}
+
+bool Json::IsArray() const
+{
+    return Kind == Type::ARRAY;
+}
+
+bool Json::IsObject() const
+{
+    return Kind == Type::OBJECT;
+}
+
+const Json& Json::Get( const std::string& key ) const
+{
+    static const Json none;
+
+    if( Kind != Type::OBJECT )
+        return none;
+
+    auto it = Object.find( key );
+    if( it == Object.end() )
+        return none;
+
+    return it->second;
+}
+
+int64_t Json::GetInt( int64_t defaultValue /* = 0 */ ) const
+{
+    return Kind == Type::NUMBER ? static_cast<int64_t>(Number) : defaultValue;
+}
+
+std::string Json::GetStr( const std::string& defaultValue /* = std::string() */ ) const
+{
+    return Kind == Type::STRING ? String : defaultValue;
+}
+
+Json& Json::operator[]( const std::string& key )
+{
+    if( Kind != Type::OBJECT )
+    {
+        *this = MakeObject();
+    }
+
+    return Object[key];
+}
+
+void Json::Push( const Json& value )
+{
+    if( Kind != Type::ARRAY )
+    {
+        *this = MakeArray();
+    }
+
+    Array.push_back( value );
+}
+
+bool Json::Parse( const std::string& text, Json& result )
+{
+    Parser parser( text );
+
+    if( !parser.GetValue( result ) )
+        return false;
+
+    parser.SkipSpace();
+
+    return parser.Pos == text.size();
+}
+
+std::string Json::Dump() const
+{
+    std::string result;
+    DumpValue( *this, result );
+
+    return result;
+}
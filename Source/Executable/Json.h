@@ -0,0 +1,60 @@
+#ifndef __JSON__
+#define __JSON__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// minimal json value; covers only what language server protocol and reports needs
+class Json
+{
+public:
+    enum class Type : uint8_t
+    {
+        NIL = 0,
+        BOOL,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Type                        Kind;
+    bool                        Bool;
+    double                      Number;
+    std::string                 String;
+    std::vector<Json>           Array;
+    std::map<std::string, Json> Object;
+
+    Json();
+    Json( bool value );
+    Json( int value );
+    Json( int64_t value );
+    Json( double value );
+    Json( const char* value );
+    Json( const std::string& value );
+
+    static Json MakeArray();
+    static Json MakeObject();
+
+    bool IsNull() const;
+    bool IsNumber() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsObject() const;
+
+    // returns null value if key is missing, or value is not an object
+    const Json& Get( const std::string& key ) const;
+    int64_t     GetInt( int64_t defaultValue = 0 ) const;
+    std::string GetStr( const std::string& defaultValue = std::string() ) const;
+
+    // converts value to object/array if needed
+    Json& operator[]( const std::string& key );
+    void  Push( const Json& value );
+
+    static bool Parse( const std::string& text, Json& result );
+    std::string Dump() const;
+};
+
+#endif // __JSON__ //
@@ -1,8 +1,37 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#if defined (_WIN32)
+# include <fcntl.h>
+# include <io.h>
+# if !defined (NOMINMAX)
+#  define NOMINMAX
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <spawn.h>
+# include <sys/wait.h>
+# include <unistd.h>
+
+extern char** environ;
+#endif
+
 #include "CommandLine.h"
+#include "Json.h"
+#include "Server.h"
+#include "Watch.h"
 #include "../Ini.h"
 
 #include "../ReDefine.h"
 
+#if defined (HAVE_GENERATED)
+# include "../Generator/Generated.h"
+#endif
+
 void Usage( ReDefine* redefine )
 {
     redefine->SHOW( "" );
@@ -17,8 +46,27 @@ void Usage( ReDefine* redefine )
     redefine->SHOW( "  --log-file [filename]      Changes location of general logfile (default: %s)", redefine->LogFile.c_str() );
     redefine->SHOW( "  --log-warning [filename]   Changes location of warnings logfile (default: %s)", redefine->LogWarning.c_str() );
     redefine->SHOW( "  --log-debug [filename]     Changes location of debug logfile (default: %s)", redefine->LogDebug.c_str() );
+    redefine->SHOW( "  --config-cache [filename]  Changes location of config cache, used to skip validating unchanged config (default: disabled)" );
+    redefine->SHOW( "  --defines-snapshot [filename]  Changes location of defines snapshot, used to skip parsing unchanged headers (default: disabled)" );
+    redefine->SHOW( "  --scripts-manifest [filename]  Changes location of scripts manifest, used to skip processing unchanged scripts (default: disabled)" );
+    redefine->SHOW( "  --scripts-pipeline [size]  Changes number of scripts read ahead and waiting for write when processing scripts; 0=no separate threads (default: %u)", redefine->ScriptsPipeline );
+    redefine->SHOW( "  --scripts-extensions [list]  Changes extensions of files treated as scripts (default: ssl)" );
+    redefine->SHOW( "  --scripts-include [globs]  Processes only scripts matching any of patterns; '*' doesn't cross directories, '**' does (default: all scripts)" );
+    redefine->SHOW( "  --scripts-exclude [globs]  Skips scripts and directories matching any of patterns (default: none)" );
+    redefine->SHOW( "  --files [list]             Processes only given scripts (separated with comma) instead of whole scripts directory" );
+    redefine->SHOW( "  --files-from [filename]    Processes only scripts listed in file, one per line; '-' reads list from standard input" );
+    redefine->SHOW( "  --changed-since [revision] Processes only scripts changed since given git revision" );
+    redefine->SHOW( "  --shard [index/count]      Processes only part of scripts, so run can be split between multiple processes; index starts from 1; each shard uses own logfiles" );
+    redefine->SHOW( "  --shard-by-size            Splits scripts between shards by total size instead of number of scripts" );
+    redefine->SHOW( "  --report [filename]        Saves summary in JSON format; shards running at same time must use different filenames" );
+    redefine->SHOW( "  --merge-reports [list]     Shows summary combined from reports (separated with comma) instead of processing scripts" );
     redefine->SHOW( "  --ro, --read, --read-only  Enables read-only mode; scripts files won't be changed (default: disabled)" );
+    redefine->SHOW( "  --durability [mode]        Changes flushing changed scripts to disk; none, batch=once at end, file=after each script (default: none)" );
     redefine->SHOW( "  --debug-changes [level]    Enables debug mode; 0=off, 1=only if script code changed, 2=full (default: %u)", redefine->DebugChanges );
+    redefine->SHOW( "  --adaptive-conditions      Enables reordering script edits conditions based on runtime statistics" );
+    redefine->SHOW( "  --batch-edits              Enables checking first condition of script edits for whole file at once" );
+    redefine->SHOW( "  --watch                    Keeps running and processes scripts whenever they change; config and headers changes reloads everything" );
+    redefine->SHOW( "  --lsp                      Runs as language server over stdin/stdout; scripts changes are shown as diagnostics and code actions" );
     redefine->SHOW( "  --dev                      Enables extra debug messages" );
     #if defined (HAVE_PARSER)
     redefine->SHOW( "  --parser" );
@@ -26,30 +74,360 @@ void Usage( ReDefine* redefine )
     redefine->SHOW( "" );
 }
 
-int main( int argc, char** argv )
+// reads whole stream; used for list of files passed from other tools
+static std::string ReadStream( std::FILE* stream )
 {
-    int result = EXIT_SUCCESS;
+    std::string result;
+    char        buffer[4096];
+    size_t      size;
 
-    // boring stuff
-    std::setvbuf( stdout, nullptr, _IONBF, 0 );
-    CmdLine*  cmd = new CmdLine( argc, argv );
-    ReDefine* redefine = new ReDefine();
+    while( (size = std::fread( buffer, 1, sizeof(buffer), stream ) ) > 0 )
+    {
+        result.append( buffer, size );
+    }
 
-    if( cmd->IsOption( "help" ) )
+    return result;
+}
+
+#if defined (_WIN32)
+// quotes argument, so it's parsed back as-is by CommandLineToArgvW() and C runtime
+static std::string GetQuotedArgument( const std::string& argument )
+{
+    if( !argument.empty() && argument.find_first_of( " \t\n\v\"" ) == std::string::npos )
+        return argument;
+
+    std::string result = "\"";
+    size_t      backslashes = 0;
+
+    for( const char c : argument )
     {
-        Usage( redefine );
+        if( c == '\\' )
+        {
+            backslashes++;
+            continue;
+        }
 
-        delete cmd;
-        delete redefine;
+        // backslashes are special only if followed by quote
+        result.append( c == '"' ? backslashes * 2 + 1 : backslashes, '\\' );
+        result += c;
+        backslashes = 0;
+    }
 
-        return result;
+    result.append( backslashes * 2, '\\' );
+    result += '"';
+
+    return result;
+}
+#endif
+
+// runs program without using shell, and reads its standard output; arguments are passed as-is
+// returns false if program cannot be started, or exited with non-zero status
+static bool RunProgram( const std::vector<std::string>& arguments, std::string& output )
+{
+    output.clear();
+
+    if( arguments.empty() )
+        return false;
+
+    #if defined (_WIN32)
+    SECURITY_ATTRIBUTES security;
+    std::memset( &security, 0, sizeof(security) );
+    security.nLength = sizeof(security);
+    security.bInheritHandle = TRUE;
+
+    HANDLE pipeRead = nullptr, pipeWrite = nullptr;
+    if( !CreatePipe( &pipeRead, &pipeWrite, &security, 0 ) )
+        return false;
+
+    SetHandleInformation( pipeRead, HANDLE_FLAG_INHERIT, 0 );
+
+    STARTUPINFOA startup;
+    std::memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = GetStdHandle( STD_INPUT_HANDLE );
+    startup.hStdOutput = pipeWrite;
+    startup.hStdError = GetStdHandle( STD_ERROR_HANDLE );
+
+    std::string commandLine;
+    for( const std::string& argument : arguments )
+    {
+        if( !commandLine.empty() )
+            commandLine += ' ';
+
+        commandLine += GetQuotedArgument( argument );
     }
 
-    // exciting stuff
-    const bool readOnly = cmd->IsOption( "ro" ) || cmd->IsOption( "read" ) || cmd->IsOption( "read-only" );
+    PROCESS_INFORMATION process;
+    std::memset( &process, 0, sizeof(process) );
 
-    redefine->SHOW( "ReDefine <3 FO1@2" );
-    redefine->SHOW( " " );
+    const bool started = CreateProcessA( nullptr, &commandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &process ) != 0;
+    CloseHandle( pipeWrite );
+
+    if( !started )
+    {
+        CloseHandle( pipeRead );
+        return false;
+    }
+
+    char  buffer[4096];
+    DWORD size = 0;
+    while( ReadFile( pipeRead, buffer, sizeof(buffer), &size, nullptr ) && size > 0 )
+    {
+        output.append( buffer, size );
+    }
+
+    CloseHandle( pipeRead );
+
+    DWORD status = 1;
+    WaitForSingleObject( process.hProcess, INFINITE );
+    GetExitCodeProcess( process.hProcess, &status );
+
+    CloseHandle( process.hThread );
+    CloseHandle( process.hProcess );
+
+    return status == 0;
+    #else
+    int pipes[2];
+    if( pipe( pipes ) != 0 )
+        return false;
+
+    // only duplicated end of pipe is passed to program
+    fcntl( pipes[0], F_SETFD, FD_CLOEXEC );
+    fcntl( pipes[1], F_SETFD, FD_CLOEXEC );
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init( &actions );
+    posix_spawn_file_actions_adddup2( &actions, pipes[1], STDOUT_FILENO );
+
+    std::vector<char*> argv;
+    for( const std::string& argument : arguments )
+    {
+        argv.push_back( const_cast<char*>(argument.c_str() ) );
+    }
+    argv.push_back( nullptr );
+
+    pid_t     pid = 0;
+    const int error = posix_spawnp( &pid, argv[0], &actions, nullptr, argv.data(), environ );
+
+    posix_spawn_file_actions_destroy( &actions );
+    close( pipes[1] );
+
+    if( error != 0 )
+    {
+        close( pipes[0] );
+        return false;
+    }
+
+    std::FILE* stream = fdopen( pipes[0], "r" );
+    if( stream )
+    {
+        output = ReadStream( stream );
+        std::fclose( stream );
+    }
+    else
+        close( pipes[0] );
+
+    int status = 0;
+    while( waitpid( pid, &status, 0 ) < 0 )
+    {
+        if( errno != EINTR )
+            return false;
+    }
+
+    return stream && WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+    #endif
+}
+
+// asks git for list of files changed since given revision (including uncommitted changes); removed files are skipped
+// filenames are relative to scripts directory, and files outside of it are not listed
+static bool GetScriptsChanged( ReDefine* redefine, const std::string& scripts, const std::string& revision, std::vector<std::string>& files )
+{
+    // revision cannot look like an option
+    if( revision.empty() || revision.front() == '-' )
+    {
+        redefine->WARNING( nullptr, "invalid revision<%s>", revision.c_str() );
+        return false;
+    }
+
+    const std::string directory = scripts.empty() ? "." : scripts;
+    std::string       output;
+
+    if( !RunProgram( { "git", "-C", directory, "diff", "--name-only", "--relative", "--diff-filter=d", "-z", revision, "--" }, output ) )
+    {
+        redefine->WARNING( nullptr, "cannot get files changed since revision<%s>", revision.c_str() );
+        return false;
+    }
+
+    for( size_t pos = 0, end; pos < output.size(); pos = end + 1 )
+    {
+        end = output.find( '\0', pos );
+        if( end == std::string::npos )
+            end = output.size();
+
+        if( end > pos )
+            files.push_back( output.substr( pos, end - pos ) );
+    }
+
+    return true;
+}
+
+// collects scripts selected with --files, --files-from and --changed-since; scripts directory is not walked if any of them is used
+// filenames can be relative to scripts directory, or to current directory; non-scripts are silently skipped, so output of other tools can be used as-is
+// returns false if list cannot be created
+static bool GetScriptsSelected( CmdLine* cmd, ReDefine* redefine, const std::string& scripts, bool& selected, std::vector<std::string>& result )
+{
+    std::vector<std::string> files;
+
+    selected = false;
+    result.clear();
+
+    if( cmd->IsOption( "files" ) )
+    {
+        selected = true;
+
+        for( const std::string& file : cmd->GetStrVec( "files", ',' ) )
+        {
+            files.push_back( file );
+        }
+    }
+
+    if( cmd->IsOption( "files-from" ) )
+    {
+        selected = true;
+
+        const std::string        filename = cmd->GetStr( "files-from" );
+        std::vector<std::string> lines;
+
+        if( filename == "-" )
+            lines = redefine->TextGetLines( ReadStream( stdin ) );
+        else if( !redefine->ReadFile( filename, lines ) )
+            return false;
+
+        files.insert( files.end(), lines.begin(), lines.end() );
+    }
+
+    if( cmd->IsOption( "changed-since" ) )
+    {
+        selected = true;
+
+        if( !GetScriptsChanged( redefine, scripts, cmd->GetStr( "changed-since" ), files ) )
+            return false;
+    }
+
+    const std::filesystem::path path = scripts.empty() ? "." : scripts;
+
+    for( const std::string& file : files )
+    {
+        std::filesystem::path script = redefine->TextGetTrimmed( file );
+        std::error_code       ec;
+
+        if( script.empty() )
+            continue;
+
+        if( script.is_absolute() || (!std::filesystem::exists( path / script, ec ) && std::filesystem::exists( script, ec ) ) )
+        {
+            script = std::filesystem::relative( script, path, ec );
+            if( ec )
+                script.clear();
+        }
+
+        // paths relative to scripts directory can point outside of it as well
+        script = script.lexically_normal();
+        if( script.empty() || script.is_absolute() || script.has_root_path() || *script.begin() == ".." )
+        {
+            redefine->WARNING( nullptr, "file<%s> is outside of scripts directory : ignored", file.c_str() );
+            continue;
+        }
+
+        // use same script name as ReDefine::GetScripts()
+        const std::string name = script.make_preferred().string();
+
+        if( redefine->IsScript( name ) )
+            result.push_back( name );
+    }
+
+    std::sort( result.begin(), result.end() );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+
+    return true;
+}
+
+// returns filename used by given shard; "ReDefine.log" becomes "ReDefine.shard1.log"
+static std::string GetShardFilename( const std::string& filename, const uint32_t shard )
+{
+    const std::filesystem::path path( filename );
+
+    return (path.parent_path() / (path.stem().string() + ".shard" + std::to_string( shard ) + path.extension().string() ) ).string();
+}
+
+// reads --shard and --shard-by-size options
+// shards can run at same time, so each one uses own logfiles; see GetShardFilename()
+// returns false if shard is invalid
+static bool GetScriptsShard( CmdLine* cmd, ReDefine* redefine, const bool reload )
+{
+    redefine->ScriptsShard = redefine->ScriptsShards = 0;
+    redefine->ScriptsShardBySize = cmd->IsOption( "shard-by-size" );
+
+    if( !cmd->IsOption( "shard" ) )
+        return true;
+
+    const std::string              shard = cmd->GetStr( "shard" );
+    const std::vector<std::string> values = redefine->TextGetSplitted( shard, '/' );
+    int                            current = 0, shards = 0;
+
+    if( values.size() != 2 || !redefine->TextGetInt( values[0], current ) || !redefine->TextGetInt( values[1], shards ) || shards < 1 || (current < 1) || (current > shards) )
+    {
+        redefine->WARNING( nullptr, "invalid shard<%s>", shard.c_str() );
+        return false;
+    }
+
+    redefine->ScriptsShard = static_cast<uint32_t>(current);
+    redefine->ScriptsShards = static_cast<uint32_t>(shards);
+
+    if( shards > 1 )
+    {
+        for( std::string* log : { &redefine->LogFile, &redefine->LogWarning, &redefine->LogDebug } )
+        {
+            if( !log->empty() )
+                *log = GetShardFilename( *log, redefine->ScriptsShard );
+        }
+
+        if( !reload )
+            redefine->RemoveLogs();
+    }
+
+    return true;
+}
+
+// wrappers around Generator/Generated.cpp, so executable without generated tables doesn't need ifdefs around every use
+static bool ReadConfigGenerated( ReDefine* redefine, const std::string& plugins )
+{
+    #if defined (HAVE_GENERATED)
+    return ReDefineGeneratedReadConfig( redefine, plugins );
+    #else
+    (void)redefine;
+    (void)plugins;
+    return false;
+    #endif
+}
+
+static void ProcessHeadersGenerated( ReDefine* redefine )
+{
+    #if defined (HAVE_GENERATED)
+    ReDefineGeneratedProcessHeaders( redefine );
+    #else
+    (void)redefine;
+    #endif
+}
+
+// loads configuration, processes headers and all scripts
+static int Run( CmdLine* cmd, ReDefine* redefine, const bool readOnly, const bool reload, std::string& config, std::string& headers, std::string& scripts )
+{
+    int result = EXIT_SUCCESS;
+
+    // language server processes documents sent by client, scripts directory is not used
+    const bool server = cmd->IsOption( "lsp" );
 
     //
     // initialization
@@ -62,8 +440,8 @@ int main( int argc, char** argv )
 
     redefine->Init();
 
-    std::string       config = "ReDefine.cfg";
     const std::string section = "ReDefine";
+    config = "ReDefine.cfg";
 
     // override configuration filename from command line
     if( !cmd->IsOptionEmpty( "config" ) )
@@ -77,7 +455,22 @@ int main( int argc, char** argv )
     // in both cases it has to be done before any ReadConfig*() call(s), which checks ReDefine::Config content without touching any files
     //
 
-    if( redefine->Config->LoadFile( config ) )
+    bool loaded = false;
+    bool generated = false;
+
+    #if defined (HAVE_GENERATED)
+    // use generated tables, unless config file is set from command line
+    if( cmd->IsOptionEmpty( "config" ) )
+    {
+        config = ReDefineGenerated.Name;
+        loaded = generated = ReDefineGeneratedConfig( redefine->Config );
+    }
+    #endif
+
+    if( !loaded )
+        loaded = redefine->Config->LoadFile( config );
+
+    if( loaded )
     {
         redefine->Dev = redefine->Config->GetBool( section, "Dev", redefine->Dev );
         if( cmd->IsOption( "dev" ) )
@@ -136,20 +529,70 @@ int main( int argc, char** argv )
             redefine->LogDebug = cmd->GetStr( "log-debug", redefine->LogDebug );
 
         // remove old logfiles
-        redefine->RemoveLogs();
+        // skipped when reloading configuration in watch mode, so results of previous runs are kept
+        if( !reload )
+            redefine->RemoveLogs();
+
+        // shard must be known before writing any file, as temporary files are not shared between shards; see ReDefine::WriteFile()
+        const bool shard = server || GetScriptsShard( cmd, redefine, reload );
 
         //
         // read directories configuration
         //
 
-        std::string headers = redefine->Config->GetStr( section, "HeadersDir" );
+        headers = redefine->Config->GetStr( section, "HeadersDir" );
         if( !cmd->IsOptionEmpty( "headers" ) )
             headers = cmd->GetStr( "headers" );
 
-        std::string scripts = redefine->Config->GetStr( section, "ScriptsDir" );
+        scripts = redefine->Config->GetStr( section, "ScriptsDir" );
         if( !cmd->IsOptionEmpty( "scripts" ) )
             scripts = cmd->GetStr( "scripts" );
 
+        // keeps validated config between runs
+        redefine->ConfigCache = redefine->Config->GetStr( section, "ConfigCache", redefine->ConfigCache );
+        if( !cmd->IsOptionEmpty( "config-cache" ) )
+            redefine->ConfigCache = cmd->GetStr( "config-cache" );
+
+        // keeps results of processing scripts between runs
+        redefine->ScriptsManifest = redefine->Config->GetStr( section, "ScriptsManifest", redefine->ScriptsManifest );
+        if( !cmd->IsOptionEmpty( "scripts-manifest" ) )
+            redefine->ScriptsManifest = cmd->GetStr( "scripts-manifest" );
+
+        // reads and writes scripts in separate threads
+        redefine->ScriptsPipeline = static_cast<uint32_t>(std::max( 0, redefine->Config->GetInt( section, "ScriptsPipeline", static_cast<int>(redefine->ScriptsPipeline) ) ) );
+        if( cmd->IsOption( "scripts-pipeline" ) )
+            redefine->ScriptsPipeline = static_cast<uint32_t>(std::max( 0, cmd->GetInt( "scripts-pipeline", static_cast<int>(redefine->ScriptsPipeline) ) ) );
+
+        // scripts selection; extensions can be given with or without leading dot
+        if( redefine->Config->IsSectionKey( section, "ScriptsExtensions" ) )
+            redefine->ScriptsExtensions = redefine->Config->GetStrVec( section, "ScriptsExtensions" );
+        if( !cmd->IsOptionEmpty( "scripts-extensions" ) )
+            redefine->ScriptsExtensions = redefine->TextGetSplitted( cmd->GetStr( "scripts-extensions" ), ' ' );
+
+        std::erase( redefine->ScriptsExtensions, std::string() );
+        for( auto& extension : redefine->ScriptsExtensions )
+        {
+            extension = redefine->TextGetLower( extension );
+            if( !extension.starts_with( "." ) )
+                extension.insert( 0, "." );
+        }
+
+        redefine->ScriptsInclude = redefine->Config->GetStrVec( section, "ScriptsInclude" );
+        if( !cmd->IsOptionEmpty( "scripts-include" ) )
+            redefine->ScriptsInclude = redefine->TextGetSplitted( cmd->GetStr( "scripts-include" ), ' ' );
+
+        redefine->ScriptsExclude = redefine->Config->GetStrVec( section, "ScriptsExclude" );
+        if( !cmd->IsOptionEmpty( "scripts-exclude" ) )
+            redefine->ScriptsExclude = redefine->TextGetSplitted( cmd->GetStr( "scripts-exclude" ), ' ' );
+
+        std::erase( redefine->ScriptsInclude, std::string() );
+        std::erase( redefine->ScriptsExclude, std::string() );
+
+        // keeps parsed headers between runs
+        redefine->DefinesSnapshot = redefine->Config->GetStr( section, "DefinesSnapshot", redefine->DefinesSnapshot );
+        if( !cmd->IsOptionEmpty( "defines-snapshot" ) )
+            redefine->DefinesSnapshot = cmd->GetStr( "defines-snapshot" );
+
         //
         // read additional configuration
         //
@@ -159,6 +602,10 @@ int main( int argc, char** argv )
             debugChanges = cmd->GetInt( "debug-changes", static_cast<int>(redefine->DebugChanges) );
 
 
+        std::string durability = redefine->Config->GetStr( section, "Durability", "none" );
+        if( !cmd->IsOptionEmpty( "durability" ) )
+            durability = cmd->GetStr( "durability" );
+
         #if defined (HAVE_PARSER)
         bool parser = redefine->Config->GetBool( section, "Parser", false );
         if( cmd->IsOption( "parser" ) )
@@ -172,6 +619,17 @@ int main( int argc, char** argv )
             redefine->ScriptFormatting = static_cast<ReDefine::ScriptCode::Format>(formatting);
         redefine->ScriptFormattingForced = redefine->Config->GetBool( section, "FormatFunctionsForced", redefine->ScriptFormattingForced );
 
+        // measure conditions pass rate and cost, and check cheapest/most selective ones first
+        // learned order is saved in regular log
+        redefine->EditAdaptive = redefine->Config->GetBool( section, "AdaptiveConditions", redefine->EditAdaptive );
+        if( cmd->IsOption( "adaptive-conditions" ) )
+            redefine->EditAdaptive = true;
+
+        // extract all script code from file before processing it, and check first condition of all edits in one go
+        redefine->EditBatch = redefine->Config->GetBool( section, "BatchEdits", redefine->EditBatch );
+        if( cmd->IsOption( "batch-edits" ) )
+            redefine->EditBatch = true;
+
         //
         // pre-validate config
         //
@@ -180,7 +638,7 @@ int main( int argc, char** argv )
             redefine->WARNING( nullptr, "headers directory not set" );
             result = EXIT_FAILURE;
         }
-        else if( scripts.empty() )
+        else if( scripts.empty() && !server )
         {
             redefine->WARNING( nullptr, "scripts directory not set" );
             result = EXIT_FAILURE;
@@ -193,7 +651,9 @@ int main( int argc, char** argv )
         //
         // defines section is required and needs to be processed before other settings
         //
-        else if( redefine->ReadConfig( "Defines", "Variable", "Function", "Raw", "Script" ) )
+        // generated tables are already validated, and only needs to be copied
+        //
+        else if( generated ? ReadConfigGenerated( redefine, "Plugins" ) : redefine->ReadConfig( "Defines", "Variable", "Function", "Raw", "Script", "Plugins" ) )
         {
             // unload config
             // added here to make sure Process*() functions are independent of ReadConfig*()
@@ -207,6 +667,16 @@ int main( int argc, char** argv )
             if( debugChanges >= static_cast<int>(ReDefine::ScriptDebugChanges::MIN) && debugChanges <= static_cast<int>(ReDefine::ScriptDebugChanges::MAX) )
                 redefine->DebugChanges = static_cast<ReDefine::ScriptDebugChanges>(debugChanges);
 
+            durability = redefine->TextGetLower( durability );
+            if( durability == "none" )
+                redefine->Durability = ReDefine::ScriptDurability::NONE;
+            else if( durability == "batch" )
+                redefine->Durability = ReDefine::ScriptDurability::BATCH;
+            else if( durability == "file" )
+                redefine->Durability = ReDefine::ScriptDurability::FILE;
+            else
+                redefine->WARNING( nullptr, "unknown durability<%s> : ignored", durability.c_str() );
+
             #if defined (HAVE_PARSER)
             redefine->UseParser = parser;
             #endif
@@ -215,13 +685,27 @@ int main( int argc, char** argv )
             // process headers
             //
 
-            redefine->ProcessHeaders( headers );
+            if( generated )
+                ProcessHeadersGenerated( redefine );
+            else
+                redefine->ProcessHeaders( headers );
 
             //
             // process scripts
             //
 
-            redefine->ProcessScripts( scripts, readOnly );
+            if( !server )
+            {
+                std::vector<std::string> selection;
+                bool                     selected = false;
+
+                if( !shard || !GetScriptsSelected( cmd, redefine, scripts, selected, selection ) )
+                    result = EXIT_FAILURE;
+                else if( selected )
+                    redefine->ProcessScripts( scripts, selection, readOnly );
+                else
+                    redefine->ProcessScripts( scripts, readOnly );
+            }
         }
         else
         {
@@ -237,6 +721,13 @@ int main( int argc, char** argv )
         result = EXIT_FAILURE;
     }
 
+    return result;
+}
+
+static void Summary( ReDefine* redefine, const bool readOnly )
+{
+    redefine->FlushCounters();
+
     //
     // show summary, if available
     //
@@ -292,8 +783,252 @@ int main( int argc, char** argv )
             }
         }
     }
+}
+
+// saves summary in machine-readable format
+static bool SaveReport( ReDefine* redefine, const bool readOnly, const std::string& filename )
+{
+    Json report = Json::MakeObject();
+
+    report["ReadOnly"] = readOnly;
+    report["Files"] = static_cast<int64_t>(redefine->Status.Process.Files);
+    report["Lines"] = static_cast<int64_t>(redefine->Status.Process.Lines);
+    report["FilesChanges"] = static_cast<int64_t>(redefine->Status.Process.FilesChanges);
+    report["LinesChanges"] = static_cast<int64_t>(redefine->Status.Process.LinesChanges);
+
+    Json& counters = report["Counters"] = Json::MakeObject();
+    for( const auto& counter : redefine->Status.Process.Counters )
+    {
+        Json& values = counters[counter.first] = Json::MakeObject();
+        for( const auto& value : counter.second )
+        {
+            values[value.first] = static_cast<int64_t>(value.second);
+        }
+    }
+
+    const std::string data = report.Dump() + "\n";
+    if( !redefine->WriteFile( filename, data.data(), data.size() ) )
+    {
+        redefine->WARNING( nullptr, "cannot save report<%s>", filename.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+// adds results saved with SaveReport() to current status
+static bool LoadReport( ReDefine* redefine, const std::string& filename, bool& readOnly )
+{
+    std::vector<char> data;
+    Json              report;
+
+    if( !redefine->ReadFile( filename, data ) )
+        return false;
+
+    if( !Json::Parse( std::string( data.begin(), data.end() ), report ) || !report.IsObject() )
+    {
+        redefine->WARNING( nullptr, "invalid report<%s>", filename.c_str() );
+        return false;
+    }
+
+    ReDefine::SStatus::SProcess process;
+
+    readOnly = report.Get( "ReadOnly" ).Kind == Json::Type::BOOL && report.Get( "ReadOnly" ).Bool;
+    process.Files = static_cast<uint32_t>(report.Get( "Files" ).GetInt() );
+    process.Lines = static_cast<uint32_t>(report.Get( "Lines" ).GetInt() );
+    process.FilesChanges = static_cast<uint32_t>(report.Get( "FilesChanges" ).GetInt() );
+    process.LinesChanges = static_cast<uint32_t>(report.Get( "LinesChanges" ).GetInt() );
+
+    for( const auto& counter : report.Get( "Counters" ).Object )
+    {
+        for( const auto& value : counter.second.Object )
+        {
+            process.Counters[counter.first][value.first] = static_cast<uint32_t>(value.second.GetInt() );
+        }
+    }
+
+    redefine->Status.Process.Add( process );
+
+    return true;
+}
+
+// combines reports of multiple runs (for example, all shards) into single summary
+// config is not loaded, and logfiles are used only if set with command line options
+static int MergeReports( CmdLine* cmd, ReDefine* redefine, bool& readOnly )
+{
+    int result = EXIT_SUCCESS;
+
+    redefine->LogFile = cmd->GetStr( "log-file" );
+    redefine->LogWarning = cmd->GetStr( "log-warning" );
+    redefine->LogDebug = cmd->GetStr( "log-debug" );
+
+    const std::vector<std::string> reports = cmd->GetStrVec( "merge-reports", ',' );
+    if( reports.empty() )
+    {
+        redefine->WARNING( nullptr, "no reports to merge" );
+        return EXIT_FAILURE;
+    }
+
+    for( size_t idx = 0; idx < reports.size(); idx++ )
+    {
+        bool reportReadOnly = false;
+
+        if( !LoadReport( redefine, reports[idx], reportReadOnly ) )
+        {
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        if( !idx )
+            readOnly = reportReadOnly;
+        else if( readOnly != reportReadOnly )
+            redefine->WARNING( nullptr, "report<%s> read-only mode differs from report<%s>", reports[idx].c_str(), reports.front().c_str() );
+    }
+
+    return result;
+}
+
+// reprocesses scripts whenever they change, and reloads everything if config or headers changes
+// never returns, unless watching is not possible
+static int RunWatch( CmdLine* cmd, ReDefine* redefine, const bool readOnly, std::string& config, std::string& headers, std::string& scripts )
+{
+    bool ready = true;
+
+    while( true )
+    {
+        Watch watch( config, headers, scripts );
+
+        // ignore files changed by ReDefine itself
+        for( const std::string& filename : { redefine->LogFile, redefine->LogWarning, redefine->LogDebug, redefine->ConfigCache, redefine->DefinesSnapshot, redefine->ScriptsManifest } )
+        {
+            if( filename.empty() )
+                continue;
+
+            watch.Ignore( filename );
+            watch.Ignore( redefine->GetTemporaryFilename( filename ) );
+        }
+
+        watch.TemporarySuffix = redefine->GetTemporaryFilename( "" );
+
+        // use same scripts selection as ReDefine::ProcessScripts()
+        watch.Filter = [redefine] ( const std::string& script ) {
+                           return redefine->IsScript( script );
+                       };
+
+        if( !watch.Init() )
+        {
+            redefine->WARNING( nullptr, "cannot watch for changes" );
+            return EXIT_FAILURE;
+        }
+
+        redefine->LOG( "Watching for changes ..." );
+
+        while( true )
+        {
+            std::vector<std::string> changed;
+            const bool               rules = watch.Wait( changed );
+
+            if( rules )
+            {
+                const std::string oldConfig = config, oldHeaders = headers, oldScripts = scripts;
+
+                redefine->LOG( "Reload ..." );
+                ready = Run( cmd, redefine, readOnly, true, config, headers, scripts ) == EXIT_SUCCESS;
+                Summary( redefine, readOnly );
+
+                // directories might be changed in config
+                if( config != oldConfig || headers != oldHeaders || scripts != oldScripts )
+                    break;
+            }
+            // scripts are not processed until config is fixed
+            else if( ready )
+            {
+                redefine->Status.Clear();
+
+                for( const std::string& script : changed )
+                {
+                    redefine->ProcessScript( scripts, script, readOnly );
+                }
+
+                redefine->SyncScripts();
+
+                Summary( redefine, readOnly );
+            }
+        }
+    }
+}
+
+int main( int argc, char** argv )
+{
+    int result = EXIT_SUCCESS;
+
+    // boring stuff
+    std::setvbuf( stdout, nullptr, _IONBF, 0 );
+    CmdLine*  cmd = new CmdLine( argc, argv );
+    ReDefine* redefine = new ReDefine();
+
+    if( cmd->IsOption( "help" ) )
+    {
+        Usage( redefine );
+
+        delete cmd;
+        delete redefine;
+
+        return result;
+    }
+
+    // language server protocol uses stdout exclusively
+    // everything else printed by ReDefine goes to stderr
+    FILE* output = nullptr;
+    if( cmd->IsOption( "lsp" ) )
+    {
+        #if defined (_WIN32)
+        _setmode( _fileno( stdin ), _O_BINARY );
+        output = _fdopen( _dup( 1 ), "wb" );
+        _dup2( 2, 1 );
+        #else
+        output = fdopen( dup( 1 ), "wb" );
+        dup2( 2, 1 );
+        #endif
+    }
+
+    // exciting stuff
+    bool readOnly = cmd->IsOption( "ro" ) || cmd->IsOption( "read" ) || cmd->IsOption( "read-only" );
+
+    redefine->SHOW( "ReDefine <3 FO1@2" );
+    redefine->SHOW( " " );
+
+    const bool  merge = cmd->IsOption( "merge-reports" );
+    std::string config, headers, scripts;
+    if( merge )
+        result = MergeReports( cmd, redefine, readOnly );
+    else
+        result = Run( cmd, redefine, readOnly, false, config, headers, scripts );
+    Summary( redefine, readOnly );
+
+    if( !cmd->IsOptionEmpty( "report" ) && !SaveReport( redefine, readOnly, cmd->GetStr( "report" ) ) )
+        result = EXIT_FAILURE;
+
+    // keep rules loaded, and process documents sent by editor
+    // logfiles are not used, as everything is reported to client
+    if( output && !merge && result == EXIT_SUCCESS )
+    {
+        redefine->LogFile.clear();
+        redefine->LogWarning.clear();
+        redefine->LogDebug.clear();
+        redefine->DebugChanges = ReDefine::ScriptDebugChanges::NONE;
+
+        Server server( redefine, stdin, output );
+        result = server.Run();
+    }
+    // keep rules loaded, and process scripts as they change
+    else if( cmd->IsOption( "watch" ) && !merge && result == EXIT_SUCCESS )
+        result = RunWatch( cmd, redefine, readOnly, config, headers, scripts );
 
     // cleanup
+    if( output )
+        std::fclose( output );
+
     delete cmd;
     delete redefine;
 
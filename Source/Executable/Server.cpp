@@ -0,0 +1,423 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "Server.h"
+
+#include "../ReDefine.h"
+
+// returns line length in utf-16 code units, as used by protocol positions
+static int64_t GetUtf16Length( const std::string& text )
+{
+    int64_t result = 0;
+
+    for( const char c : text )
+    {
+        const unsigned char uc = static_cast<unsigned char>(c);
+
+        // skip continuation bytes; characters outside basic plane takes two units
+        if( (uc & 0xC0) != 0x80 )
+            result++;
+        if( (uc & 0xF8) == 0xF0 )
+            result++;
+    }
+
+    return result;
+}
+
+// returns last part of "file://" uri, used by conditions checking filename
+static std::string GetFilename( const std::string& uri )
+{
+    std::string result;
+    std::string filename = uri.substr( uri.find_last_of( "/\\" ) + 1 );
+
+    for( size_t idx = 0; idx < filename.size(); idx++ )
+    {
+        if( filename[idx] == '%' && idx + 2 < filename.size() )
+        {
+            result += static_cast<char>(std::strtol( filename.substr( idx + 1, 2 ).c_str(), nullptr, 16 ) );
+            idx += 2;
+        }
+        else
+            result += filename[idx];
+    }
+
+    return result;
+}
+
+static Json GetRange( int64_t line, const std::string& text )
+{
+    Json result;
+
+    result["start"]["line"] = line;
+    result["start"]["character"] = 0;
+    result["end"]["line"] = line;
+    result["end"]["character"] = GetUtf16Length( text );
+
+    return result;
+}
+
+static Json GetTextEdit( int64_t line, const std::string& oldText, const std::string& newText )
+{
+    Json result;
+
+    result["range"] = GetRange( line, oldText );
+    result["newText"] = newText;
+
+    return result;
+}
+
+//
+
+Server::Server( ReDefine* redefine, FILE* input, FILE* output ) :
+    Redefine( redefine ),
+    Input( input ),
+    Output( output ),
+    Shutdown( false )
+{}
+
+Server::~Server()
+{}
+
+bool Server::Read( Json& message )
+{
+    size_t length = 0;
+    char   header[1024];
+
+    // headers are separated from content with empty line
+    while( true )
+    {
+        if( !std::fgets( header, sizeof(header), Input ) )
+            return false;
+
+        if( std::strcmp( header, "\r\n" ) == 0 || std::strcmp( header, "\n" ) == 0 )
+            break;
+
+        if( std::strncmp( header, "Content-Length:", 15 ) == 0 )
+            length = std::strtoul( header + 15, nullptr, 10 );
+    }
+
+    std::string content( length, '\0' );
+    if( length && std::fread( &content[0], 1, length, Input ) != length )
+        return false;
+
+    if( !Json::Parse( content, message ) )
+        message = Json();
+
+    return true;
+}
+
+void Server::Write( const Json& message )
+{
+    const std::string content = message.Dump();
+
+    std::fprintf( Output, "Content-Length: %zu\r\n\r\n", content.size() );
+    std::fwrite( content.data(), 1, content.size(), Output );
+    std::fflush( Output );
+}
+
+void Server::Respond( const Json& id, const Json& result )
+{
+    Json message;
+
+    message["jsonrpc"] = "2.0";
+    message["id"] = id;
+    message["result"] = result;
+
+    Write( message );
+}
+
+void Server::RespondError( const Json& id, int code, const std::string& text )
+{
+    Json message;
+
+    message["jsonrpc"] = "2.0";
+    message["id"] = id;
+    message["error"]["code"] = code;
+    message["error"]["message"] = text;
+
+    Write( message );
+}
+
+void Server::Notify( const std::string& method, const Json& params )
+{
+    Json message;
+
+    message["jsonrpc"] = "2.0";
+    message["method"] = method;
+    message["params"] = params;
+
+    Write( message );
+}
+
+// processes document lines in the same way as ReDefine::ProcessScript(), without side-cleanup
+// results of lines placed before first changed line are reused
+void Server::Update( const std::string& uri, int64_t version, const std::string& text )
+{
+    auto                     start = std::chrono::steady_clock::now();
+
+    Document&                document = Documents[uri];
+    std::vector<std::string> lines;
+
+    document.Filename = GetFilename( uri );
+    document.Version = version;
+
+    size_t begin = 0;
+    while( begin <= text.size() )
+    {
+        size_t end = text.find( '\n', begin );
+        if( end == std::string::npos )
+            end = text.size();
+
+        std::string line = text.substr( begin, end - begin );
+        if( !line.empty() && line.back() == '\r' )
+            line.pop_back();
+
+        lines.push_back( line );
+        begin = end + 1;
+    }
+
+    // any line might change results of following lines (for example, with script defines), so everything after first changed line is processed again
+    size_t unchanged = 0;
+    while( unchanged < lines.size() && unchanged < document.Results.size() && lines[unchanged] == document.Lines[unchanged] )
+    {
+        unchanged++;
+    }
+
+    document.Lines.swap( lines );
+    document.Results.resize( unchanged );
+
+    std::vector<ReDefine::LogMessage> record;
+    ReDefine::ScriptFile              file;
+    uint32_t                          processed = 0;
+
+    for( size_t idx = 0; idx < document.Lines.size(); idx++ )
+    {
+        std::string line = document.Lines[idx];
+        line.erase( line.find_last_not_of( "\t " ) + 1 );
+
+        std::string name;
+        if( Redefine->TextGetScriptDefine( line, name ) )
+            file.Defines.push_back( name );
+
+        if( idx < unchanged )
+            continue;
+
+        if( line.empty() || Redefine->TextIsComment( line ) || Redefine->TextIsIgnored( line ) )
+        {
+            document.Results.emplace_back();
+            continue;
+        }
+
+        LineResult result;
+        result.Text = line;
+
+        // line number is left unset, so warnings doesn't need to be updated when lines are added or removed
+        Redefine->Status.Current.Clear();
+        Redefine->Status.Current.File = document.Filename;
+
+        if( Redefine->TextIsConflict( line ) )
+            result.Warnings.push_back( "possible merge conflict" );
+
+        record.clear();
+        Redefine->LogRecord = &record;
+        result.Changed = Redefine->ProcessScriptLine( result.Text, &file );
+        Redefine->LogRecord = nullptr;
+
+        const std::string prefix = "WARNING ", suffix = " : file<" + document.Filename + ">";
+        for( const ReDefine::LogMessage& message : record )
+        {
+            if( message.Type != ReDefine::LogType::WARNING )
+                continue;
+
+            std::string warning = message.Text;
+            if( warning.compare( 0, prefix.size(), prefix ) == 0 )
+                warning.erase( 0, prefix.size() );
+            if( warning.size() >= suffix.size() && warning.compare( warning.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+                warning.erase( warning.size() - suffix.size() );
+
+            result.Warnings.push_back( warning );
+        }
+
+        document.Results.emplace_back( std::move( result ) );
+        processed++;
+    }
+
+    Redefine->FlushCounters();
+    Redefine->Status.Clear();
+
+    if( Redefine->Dev )
+    {
+        auto finish = std::chrono::steady_clock::now();
+        Redefine->DEBUG( nullptr, "%s : processed %u/%zu line%s in %lldus", document.Filename.c_str(), processed, document.Lines.size(), document.Lines.size() != 1 ? "s" : "",
+                         static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>( finish - start ).count() ) );
+    }
+}
+
+void Server::Publish( const std::string& uri )
+{
+    Json params;
+    params["uri"] = uri;
+    params["diagnostics"] = Json::MakeArray();
+
+    auto it = Documents.find( uri );
+    if( it != Documents.end() )
+    {
+        const Document& document = it->second;
+
+        params["version"] = document.Version;
+
+        for( size_t idx = 0; idx < document.Results.size(); idx++ )
+        {
+            const std::optional<LineResult>& result = document.Results[idx];
+            if( !result )
+                continue;
+
+            for( const std::string& warning : result->Warnings )
+            {
+                Json diagnostic;
+                diagnostic["range"] = GetRange( idx, document.Lines[idx] );
+                diagnostic["severity"] = 2;
+                diagnostic["source"] = "ReDefine";
+                diagnostic["message"] = warning;
+
+                params["diagnostics"].Push( diagnostic );
+            }
+
+            if( result->Changed )
+            {
+                Json diagnostic;
+                diagnostic["range"] = GetRange( idx, document.Lines[idx] );
+                diagnostic["severity"] = 3;
+                diagnostic["source"] = "ReDefine";
+                diagnostic["message"] = "-> " + Redefine->TextGetTrimmed( result->Text );
+
+                params["diagnostics"].Push( diagnostic );
+            }
+        }
+    }
+
+    Notify( "textDocument/publishDiagnostics", params );
+}
+
+Json Server::GetCodeActions( const Json& params )
+{
+    Json              result = Json::MakeArray();
+
+    const std::string uri = params.Get( "textDocument" ).Get( "uri" ).GetStr();
+
+    auto              it = Documents.find( uri );
+    if( it == Documents.end() )
+        return result;
+
+    const Document& document = it->second;
+    const int64_t   first = params.Get( "range" ).Get( "start" ).Get( "line" ).GetInt();
+    const int64_t   last = params.Get( "range" ).Get( "end" ).Get( "line" ).GetInt( first );
+
+    Json            all;
+    uint32_t        changes = 0;
+
+    for( size_t idx = 0; idx < document.Results.size(); idx++ )
+    {
+        const std::optional<LineResult>& line = document.Results[idx];
+        if( !line || !line->Changed )
+            continue;
+
+        const Json edit = GetTextEdit( idx, document.Lines[idx], line->Text );
+
+        all["changes"][uri].Push( edit );
+        changes++;
+
+        if( static_cast<int64_t>(idx) < first || static_cast<int64_t>(idx) > last )
+            continue;
+
+        Json action;
+        action["title"] = "ReDefine: " + Redefine->TextGetTrimmed( line->Text );
+        action["kind"] = "quickfix";
+        action["isPreferred"] = true;
+        action["edit"]["changes"][uri].Push( edit );
+
+        result.Push( action );
+    }
+
+    if( changes > 1 )
+    {
+        Json action;
+        action["title"] = "ReDefine: apply all changes (" + std::to_string( changes ) + ")";
+        action["kind"] = "source.fixAll";
+        action["edit"] = all;
+
+        result.Push( action );
+    }
+
+    return result;
+}
+
+int Server::Run()
+{
+    Json message;
+
+    while( Read( message ) )
+    {
+        const std::string method = message.Get( "method" ).GetStr();
+        const Json&       id = message.Get( "id" );
+        const Json&       params = message.Get( "params" );
+        const bool        request = message.IsObject() && message.Object.count( "id" ) > 0;
+
+        if( !message.IsObject() )
+            RespondError( Json(), -32700, "parse error" );
+        else if( method == "initialize" )
+        {
+            Json result;
+
+            result["capabilities"]["textDocumentSync"]["openClose"] = true;
+            result["capabilities"]["textDocumentSync"]["change"] = 1; // full document
+            result["capabilities"]["codeActionProvider"]["codeActionKinds"].Push( "quickfix" );
+            result["capabilities"]["codeActionProvider"]["codeActionKinds"].Push( "source.fixAll" );
+            result["serverInfo"]["name"] = "ReDefine";
+
+            Respond( id, result );
+        }
+        else if( method == "shutdown" )
+        {
+            Shutdown = true;
+            Respond( id, Json() );
+        }
+        else if( method == "exit" )
+            return Shutdown ? EXIT_SUCCESS : EXIT_FAILURE;
+        else if( method == "textDocument/didOpen" )
+        {
+            const Json&       document = params.Get( "textDocument" );
+            const std::string uri = document.Get( "uri" ).GetStr();
+
+            Update( uri, document.Get( "version" ).GetInt(), document.Get( "text" ).GetStr() );
+            Publish( uri );
+        }
+        else if( method == "textDocument/didChange" )
+        {
+            const Json&       document = params.Get( "textDocument" );
+            const std::string uri = document.Get( "uri" ).GetStr();
+            const Json&       changes = params.Get( "contentChanges" );
+
+            // full document sync; last change contains whole text
+            if( changes.IsArray() && !changes.Array.empty() )
+            {
+                Update( uri, document.Get( "version" ).GetInt(), changes.Array.back().Get( "text" ).GetStr() );
+                Publish( uri );
+            }
+        }
+        else if( method == "textDocument/didClose" )
+        {
+            const std::string uri = params.Get( "textDocument" ).Get( "uri" ).GetStr();
+
+            Documents.erase( uri );
+            Publish( uri );
+        }
+        else if( method == "textDocument/codeAction" )
+            Respond( id, GetCodeActions( params ) );
+        else if( request )
+            RespondError( id, -32601, "method not supported<" + method + ">" );
+    }
+
+    return Shutdown ? EXIT_SUCCESS : EXIT_FAILURE;
+}
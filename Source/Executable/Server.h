@@ -0,0 +1,61 @@
+#ifndef __SERVER__
+#define __SERVER__
+
+#include <cstdio>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Json.h"
+
+class ReDefine;
+
+// language server (over stdio) showing script changes as diagnostics and code actions
+// config and headers are loaded once; only lines starting from first line changed since previous document update are processed
+class Server
+{
+protected:
+    struct LineResult
+    {
+        bool                     Changed = false;
+        std::string              Text;     // line after processing
+        std::vector<std::string> Warnings;
+    };
+
+    // results are kept by line position, as line can be affected by content of previous lines
+    struct Document
+    {
+        std::string                            Filename;
+        int64_t                                Version = 0;
+        std::vector<std::string>               Lines;
+        std::vector<std::optional<LineResult>> Results; // <line index, result>; empty if line is not processed
+    };
+
+    ReDefine*                       Redefine;
+    FILE*                           Input;
+    FILE*                           Output;
+    bool                            Shutdown;
+
+    std::map<std::string, Document> Documents; // <uri, document>
+
+    bool Read( Json& message );
+    void Write( const Json& message );
+
+    void Respond( const Json& id, const Json& result );
+    void RespondError( const Json& id, int code, const std::string& message );
+    void Notify( const std::string& method, const Json& params );
+
+    void Update( const std::string& uri, int64_t version, const std::string& text );
+    void Publish( const std::string& uri );
+    Json GetCodeActions( const Json& params );
+
+public:
+    Server( ReDefine* redefine, FILE* input, FILE* output );
+    virtual ~Server();
+
+    // handles messages until client exits
+    virtual int Run();
+};
+
+#endif // __SERVER__ //
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined (__linux__)
+# include <cerrno>
+# include <poll.h>
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
+
+#include "Watch.h"
+
+// delay between first change and processing; editors often changes same file multiple times when saving
+static constexpr int SettleTime = 200; // milliseconds
+
+static std::string GetCanonical( const std::string& filename )
+{
+    std::error_code error;
+    std::string     result = std::filesystem::weakly_canonical( filename, error ).string();
+
+    return error ? filename : result;
+}
+
+static bool IsScript( const std::string& filename )
+{
+    std::string extension = std::filesystem::path( filename ).extension().string();
+    std::transform( extension.begin(), extension.end(), extension.begin(), ::tolower );
+
+    return extension == ".ssl";
+}
+
+// checks if file is placed inside directory (or any of its subdirectories); both paths must be canonical
+static bool IsInside( const std::string& filename, const std::string& directory )
+{
+    return filename.length() > directory.length() && filename.compare( 0, directory.length(), directory ) == 0 && (filename[directory.length()] == '/' || filename[directory.length()] == '\\');
+}
+
+//
+
+Watch::Watch( const std::string& config, const std::string& headers, const std::string& scripts ) :
+    Config( config ),
+    Headers( headers ),
+    Scripts( scripts )
+#if defined (__linux__)
+    , Inotify( -1 )
+#endif
+{}
+
+Watch::~Watch()
+{
+    #if defined (__linux__)
+    if( Inotify >= 0 )
+        close( Inotify );
+    #endif
+}
+
+bool Watch::Init()
+{
+    if( !std::filesystem::is_directory( Headers ) || !std::filesystem::is_directory( Scripts ) )
+        return false;
+
+    // config might be embedded in executable
+    if( std::filesystem::is_regular_file( Config ) )
+        ConfigPath = GetCanonical( Config );
+
+    HeadersPath = GetCanonical( Headers );
+    ScriptsPath = GetCanonical( Scripts );
+
+    #if defined (__linux__)
+    Inotify = inotify_init1( IN_CLOEXEC );
+    if( Inotify < 0 )
+        return false;
+
+    AddDirectory( HeadersPath, true, false, true );
+    AddDirectory( ScriptsPath, false, true, true );
+
+    // parent directory is used, as editors often replaces config file instead of changing it
+    if( !ConfigPath.empty() )
+        AddDirectory( std::filesystem::path( ConfigPath ).parent_path().string(), false, false, false );
+
+    return !Directories.empty();
+    #else
+    Scan( Files );
+
+    return true;
+    #endif
+}
+
+void Watch::Ignore( const std::string& filename )
+{
+    Ignored.insert( GetCanonical( filename ) );
+}
+
+bool Watch::Changed( const std::string& filename, bool headers, bool scripts, std::set<std::string>& changed )
+{
+    const std::string canonical = GetCanonical( filename );
+
+    if( Ignored.find( canonical ) != Ignored.end() )
+        return false;
+
+    if( !ConfigPath.empty() && canonical == ConfigPath )
+        return true;
+
+    if( IsInside( canonical, ScriptsPath ) )
+    {
+        // use same script name as ReDefine::ProcessScripts()
+        std::string script = canonical.substr( ScriptsPath.length() );
+        script.erase( 0, script.find_first_not_of( "\\/" ) );
+
+        // temporary file written when saving script (see ReDefine::WriteFile()); script itself is reported when temporary file is renamed
+        if( !TemporarySuffix.empty() && script.ends_with( TemporarySuffix ) )
+        {
+            const std::string saved = script.substr( 0, script.length() - TemporarySuffix.length() );
+            if( Filter ? Filter( saved ) : IsScript( saved ) )
+                return false;
+        }
+
+        if( scripts && (Filter ? Filter( script ) : IsScript( script ) ) )
+        {
+            if( std::filesystem::is_regular_file( canonical ) )
+                changed.insert( script );
+
+            return false;
+        }
+    }
+
+    // any other file inside headers directory might be used as header
+    return headers;
+}
+
+#if defined (__linux__)
+
+void Watch::AddDirectory( const std::string& path, bool headers, bool scripts, bool recursive )
+{
+    const uint32_t mask = recursive ? (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE) : (IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    // same directory can be added multiple times (for example, if headers and scripts are kept together)
+    int wd = inotify_add_watch( Inotify, path.c_str(), mask | IN_MASK_ADD | IN_ONLYDIR );
+    if( wd < 0 )
+        return;
+
+    Directory& directory = Directories[wd];
+    directory.Path = path;
+    directory.Headers |= headers;
+    directory.Scripts |= scripts;
+
+    if( !recursive )
+        return;
+
+    std::error_code error;
+    for( const auto& entry : std::filesystem::directory_iterator( path, error ) )
+    {
+        if( entry.is_directory( error ) )
+            AddDirectory( entry.path().string(), headers, scripts, true );
+    }
+}
+
+bool Watch::Wait( std::vector<std::string>& scripts )
+{
+    bool                  rules = false;
+    std::set<std::string> changed;
+    int                   timeout = -1;
+
+    while( true )
+    {
+        pollfd fd = { Inotify, POLLIN, 0 };
+        int    ready = poll( &fd, 1, timeout );
+
+        if( ready < 0 && errno == EINTR )
+            continue;
+        else if( ready <= 0 )
+            break;
+
+        alignas( inotify_event ) char buffer[16 * 1024];
+        ssize_t length = read( Inotify, buffer, sizeof(buffer) );
+        if( length <= 0 )
+            continue;
+
+        for( char* ptr = buffer; ptr < buffer + length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            // some events were dropped, so it's unknown what changed; everything is processed again,
+            // and directories created in meantime are added
+            if( event->mask & IN_Q_OVERFLOW )
+            {
+                AddDirectory( HeadersPath, true, false, true );
+                AddDirectory( ScriptsPath, false, true, true );
+
+                rules = true;
+                continue;
+            }
+
+            auto it = Directories.find( event->wd );
+            if( it == Directories.end() )
+                continue;
+            else if( event->mask & IN_IGNORED )
+            {
+                Directories.erase( it );
+                continue;
+            }
+            else if( !event->len )
+                continue;
+
+            const Directory   directory = it->second;
+            const std::string filename = directory.Path + "/" + event->name;
+
+            if( event->mask & IN_ISDIR )
+            {
+                if( event->mask & (IN_CREATE | IN_MOVED_TO) )
+                    AddDirectory( filename, directory.Headers, directory.Scripts, true );
+
+                continue;
+            }
+
+            if( Changed( filename, directory.Headers, directory.Scripts, changed ) )
+                rules = true;
+        }
+
+        if( rules || !changed.empty() )
+            timeout = SettleTime;
+    }
+
+    scripts.assign( changed.begin(), changed.end() );
+
+    return rules;
+}
+
+#else
+
+void Watch::Scan( FilesMap& files )
+{
+    files.clear();
+
+    std::error_code error;
+    for( const std::string& directory : { HeadersPath, ScriptsPath } )
+    {
+        for( const auto& entry : std::filesystem::recursive_directory_iterator( directory, error ) )
+        {
+            if( entry.is_regular_file( error ) )
+                files[entry.path().string()] = { entry.last_write_time( error ), entry.file_size( error ) };
+        }
+    }
+
+    if( !ConfigPath.empty() )
+        files[ConfigPath] = { std::filesystem::last_write_time( ConfigPath, error ), std::filesystem::file_size( ConfigPath, error ) };
+}
+
+bool Watch::Wait( std::vector<std::string>& scripts )
+{
+    bool                  rules = false;
+    std::set<std::string> changed;
+
+    while( !rules && changed.empty() )
+    {
+        std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+
+        FilesMap files;
+        Scan( files );
+
+        for( const auto& file : files )
+        {
+            auto it = Files.find( file.first );
+            if( it == Files.end() || it->second != file.second )
+                rules |= Changed( file.first, IsInside( file.first, HeadersPath ), IsInside( file.first, ScriptsPath ), changed );
+        }
+
+        // removed files
+        for( const auto& file : Files )
+        {
+            if( files.find( file.first ) == files.end() )
+                rules |= Changed( file.first, IsInside( file.first, HeadersPath ), false, changed );
+        }
+
+        Files.swap( files );
+    }
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( SettleTime ) );
+    scripts.assign( changed.begin(), changed.end() );
+
+    return rules;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __WATCH__
+#define __WATCH__
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// waits for changes of config file, headers and scripts
+// uses inotify if available, otherwise files are checked every second
+class Watch
+{
+protected:
+    const std::string     Config;
+    const std::string     Headers;
+    const std::string     Scripts;
+
+    std::string           ConfigPath;  // canonical
+    std::string           HeadersPath; // canonical
+    std::string           ScriptsPath; // canonical
+
+    std::set<std::string> Ignored;     // <canonical filename>; files changed by ReDefine itself
+
+    #if defined (__linux__)
+    struct Directory
+    {
+        std::string Path;
+        bool        Headers = false;
+        bool        Scripts = false;
+    };
+
+    int                      Inotify;
+    std::map<int, Directory> Directories;   // <watch descriptor, directory>
+
+    void AddDirectory( const std::string& path, bool headers, bool scripts, bool recursive );
+    #else
+    typedef std::map<std::string, std::pair<std::filesystem::file_time_type, uintmax_t>> FilesMap; // <canonical filename, <time, size>>
+
+    FilesMap Files;
+
+    void Scan( FilesMap& files );
+    #endif
+
+    // returns true if file change requires reloading config and headers
+    // otherwise, changed script name (relative to scripts directory) is added to list
+    bool Changed( const std::string& filename, bool headers, bool scripts, std::set<std::string>& changed );
+
+public:
+    // decides if file inside scripts directory is a script; called with filename relative to scripts directory
+    // by default, only .ssl files are treated as scripts
+    std::function<bool(const std::string& script)> Filter;
+
+    // added to script name by ReDefine::WriteFile() when saving script; such files are ignored
+    std::string TemporarySuffix = ".tmp";
+
+    Watch( const std::string& config, const std::string& headers, const std::string& scripts );
+    virtual ~Watch();
+
+    virtual bool Init();
+    virtual void Ignore( const std::string& filename );
+
+    // blocks until any of watched files changes
+    // returns true if config or headers changed, otherwise changed scripts are added to list
+    virtual bool Wait( std::vector<std::string>& scripts );
+};
+
+#endif // __WATCH__ //
@@ -5,6 +5,7 @@
 void ReDefine::FinishFunctions()
 {
     FunctionsPrototypes.clear();
+    FunctionsLookup = nullptr;
 }
 
 // reading
@@ -42,15 +43,28 @@ bool ReDefine::ReadConfigFunctions( const std::string& section )
     return true;
 }
 
+// returns nullptr if function is not configured
+const ReDefine::FunctionProto* ReDefine::GetFunctionProto( const std::string& name )
+{
+    if( FunctionsLookup )
+        return FunctionsLookup( name );
+
+    auto it = FunctionsPrototypes.find( name );
+    if( it == FunctionsPrototypes.end() )
+        return nullptr;
+
+    return &it->second;
+}
+
 // processing
 
 void ReDefine::ProcessFunctionArguments( ReDefine::ScriptCode& function )
 {
     // make sure function is preconfigured properly
-    auto it = FunctionsPrototypes.find( function.Name );
-    if( it != FunctionsPrototypes.end() )
+    const FunctionProto* proto = GetFunctionProto( function.Name );
+    if( proto )
     {
-        const size_t expected = it->second.ArgumentsTypes.size(), found = function.Arguments.size();
+        const size_t expected = proto->ArgumentsTypes.size(), found = function.Arguments.size();
 
         if( expected != found )
         {
@@ -0,0 +1,193 @@
+#include "../Ini.h"
+
+#include "../ReDefine.h"
+
+#include "Generated.h"
+
+//
+// installs tables written by ReDefineGenerator; see Generator/Main.cpp
+//
+// executable using them replaces ReadConfig() with ReDefineGeneratedReadConfig(), and ProcessHeaders() with ReDefineGeneratedProcessHeaders();
+// results are same as if both functions would be called with configuration and headers used by generator
+//
+
+// prototypes in same order as ReDefineGenerated.Functions; created once, as they're shared by all ReDefine objects
+static std::vector<ReDefine::FunctionProto> Prototypes;
+
+static const char* GetString( const uint32_t idx )
+{
+    return ReDefineGenerated.Strings[idx];
+}
+
+static std::vector<std::string> GetList( const GeneratedList& list )
+{
+    std::vector<std::string> result;
+    result.reserve( list.Size );
+
+    for( uint32_t idx = 0; idx < list.Size; idx++ )
+    {
+        result.emplace_back( GetString( ReDefineGenerated.Lists[list.Offset + idx] ) );
+    }
+
+    return result;
+}
+
+static void GetDefines( const GeneratedDefine* defines, const uint32_t size, ReDefine::DefinesMap& result )
+{
+    for( uint32_t idx = 0; idx < size; idx++ )
+    {
+        result[GetString( defines[idx].Type )][defines[idx].Value] = GetString( defines[idx].Name );
+    }
+}
+
+static void GetActions( const uint32_t offset, const uint32_t size, std::vector<ReDefine::ScriptEdit::Action>& result )
+{
+    result.resize( size );
+
+    for( uint32_t idx = 0; idx < size; idx++ )
+    {
+        const GeneratedAction&        generated = ReDefineGenerated.Actions[offset + idx];
+        ReDefine::ScriptEdit::Action& action = result[idx];
+
+        action.Name = GetString( generated.Name );
+        action.Values = GetList( generated.Values );
+        action.Negate = generated.Negate;
+        action.CacheSlot = generated.CacheSlot;
+        action.CounterSlot = generated.CounterSlot;
+        action.SharedSlot = generated.SharedSlot;
+    }
+}
+
+static void Replay( ReDefine* redefine, const GeneratedMessage* messages, const uint32_t size )
+{
+    std::vector<ReDefine::LogMessage> replay;
+    replay.reserve( size );
+
+    for( uint32_t idx = 0; idx < size; idx++ )
+    {
+        replay.push_back( { static_cast<ReDefine::LogType>(messages[idx].Type), GetString( messages[idx].Text ) } );
+    }
+
+    redefine->LogReplay( replay );
+}
+
+// perfect hash lookup; function can be only at slot selected by seed of its bucket
+static const ReDefine::FunctionProto* GetFunctionProto( const std::string& name )
+{
+    const uint32_t size = ReDefineGenerated.FunctionsSize;
+    if( !size )
+        return nullptr;
+
+    const uint32_t bucket = GeneratedHash( name.data(), name.size(), 0 ) % size;
+    const uint32_t slot = GeneratedHash( name.data(), name.size(), ReDefineGenerated.FunctionsSeeds[bucket] ) % size;
+
+    if( name != GetString( ReDefineGenerated.Functions[slot].Name ) )
+        return nullptr;
+
+    return &Prototypes[slot];
+}
+
+bool ReDefineGeneratedConfig( Ini* config )
+{
+    config->Unload();
+
+    for( uint32_t idx = 0; idx < ReDefineGenerated.ConfigSize; idx++ )
+    {
+        const GeneratedConfig& entry = ReDefineGenerated.Config[idx];
+
+        config->SetStr( GetString( entry.Section ), GetString( entry.Key ), GetString( entry.Value ) );
+    }
+
+    return true;
+}
+
+bool ReDefineGeneratedReadConfig( ReDefine* redefine, const std::string& plugins )
+{
+    // plugins can only replace existing actions, as edits using actions added by plugins are not known to generator
+    if( !plugins.empty() && !redefine->ReadConfigPlugins( plugins ) )
+        return false;
+
+    // same cleanup as done by ReadConfig*()
+    redefine->FinishDefines();
+    redefine->FinishVariables();
+    redefine->FinishFunctions();
+    redefine->FinishRaw();
+    redefine->FinishScript( false );
+
+    Replay( redefine, ReDefineGenerated.ConfigMessages, ReDefineGenerated.ConfigMessagesSize );
+
+    return true;
+}
+
+void ReDefineGeneratedProcessHeaders( ReDefine* redefine )
+{
+    const GeneratedTables& tables = ReDefineGenerated;
+
+    GetDefines( tables.RegularDefines, tables.RegularDefinesSize, redefine->RegularDefines );
+    GetDefines( tables.ProgramDefines, tables.ProgramDefinesSize, redefine->ProgramDefines );
+
+    for( uint32_t idx = 0; idx < tables.VirtualDefinesSize; idx++ )
+    {
+        redefine->VirtualDefines[GetString( tables.VirtualDefines[idx].Type )] = GetList( tables.VirtualDefines[idx].Types );
+    }
+
+    for( uint32_t idx = 0; idx < tables.VariablesSize; idx++ )
+    {
+        redefine->VariablesPrototypes[GetString( tables.Variables[idx].First )] = GetString( tables.Variables[idx].Second );
+    }
+
+    redefine->VariablesGuessing = GetList( tables.VariablesGuessing );
+
+    if( Prototypes.empty() )
+    {
+        Prototypes.resize( tables.FunctionsSize );
+
+        for( uint32_t idx = 0; idx < tables.FunctionsSize; idx++ )
+        {
+            Prototypes[idx].ReturnType = GetString( tables.Functions[idx].ReturnType );
+            Prototypes[idx].ArgumentsTypes = GetList( tables.Functions[idx].ArgumentsTypes );
+        }
+    }
+
+    // map is still filled, as some functions (config cache, scripts manifest) needs to iterate over prototypes
+    for( uint32_t idx = 0; idx < tables.FunctionsSize; idx++ )
+    {
+        redefine->FunctionsPrototypes[GetString( tables.Functions[idx].Name )] = Prototypes[idx];
+    }
+
+    redefine->FunctionsLookup = &GetFunctionProto;
+
+    for( uint32_t idx = 0; idx < tables.RawSize; idx++ )
+    {
+        redefine->Raw[GetString( tables.Raw[idx].First )] = GetString( tables.Raw[idx].Second );
+    }
+
+    redefine->EditCacheSlots = GetList( tables.EditCacheSlots );
+    redefine->CounterSlots = GetList( tables.CounterSlots );
+
+    for( uint32_t idx = 0; idx < tables.CounterUnknownSlotsSize; idx++ )
+    {
+        redefine->CounterUnknownSlots[GetString( tables.CounterUnknownSlots[idx].Name )] = tables.CounterUnknownSlots[idx].Slot;
+    }
+
+    redefine->EditSharedSlots = tables.EditSharedSlots;
+    redefine->EditBatchSlots = tables.EditBatchSlots;
+
+    for( uint32_t idx = 0; idx < tables.EditsSize; idx++ )
+    {
+        const GeneratedEdit&                                   generated = tables.Edits[idx];
+        std::map<uint32_t, std::vector<ReDefine::ScriptEdit>>& edits = generated.Run == 0 ? redefine->EditBefore : (generated.Run == 1 ? redefine->EditAfter : redefine->EditOnDemand);
+
+        ReDefine::ScriptEdit                                   edit;
+        edit.Debug = generated.Debug;
+        edit.Name = GetString( generated.Name );
+        edit.BatchSlot = generated.BatchSlot;
+
+        GetActions( generated.Conditions, generated.ConditionsSize, edit.Conditions );
+        GetActions( generated.Results, generated.ResultsSize, edit.Results );
+
+        edits[generated.Priority].push_back( std::move( edit ) );
+    }
+
+    Replay( redefine, tables.HeadersMessages, tables.HeadersMessagesSize );
+}
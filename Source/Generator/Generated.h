@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Ini;
+class ReDefine;
+
+//
+// tables written by ReDefineGenerator, and functions installing them in ReDefine object
+//
+// generated source keeps configuration as it looks after ReadConfig() and ProcessHeaders() are done;
+// defines, prototypes and (already validated) script edits are copied as-is, without reading headers or validating config again
+//
+// all strings are kept in single pool, and referenced by index; lists are ranges of GeneratedTables::Lists
+//
+
+struct GeneratedList
+{
+    uint32_t Offset;
+    uint32_t Size;
+};
+
+struct GeneratedConfig
+{
+    uint32_t Section;
+    uint32_t Key;
+    uint32_t Value;
+};
+
+struct GeneratedDefine
+{
+    uint32_t Type;
+    int32_t  Value;
+    uint32_t Name;
+};
+
+struct GeneratedPair
+{
+    uint32_t First;
+    uint32_t Second;
+};
+
+struct GeneratedTypes
+{
+    uint32_t      Type;
+    GeneratedList Types;
+};
+
+struct GeneratedSlot
+{
+    uint32_t Name;
+    int32_t  Slot;
+};
+
+// functions are stored in order of their perfect hash slots, see GeneratedHash()
+struct GeneratedFunction
+{
+    uint32_t      Name;
+    uint32_t      ReturnType;
+    GeneratedList ArgumentsTypes;
+};
+
+struct GeneratedAction
+{
+    uint32_t      Name;
+    GeneratedList Values;
+    bool          Negate;
+    int32_t       CacheSlot;
+    int32_t       CounterSlot;
+    int32_t       SharedSlot;
+};
+
+struct GeneratedEdit
+{
+    uint8_t  Run; // 0 - EditBefore, 1 - EditAfter, 2 - EditOnDemand
+    uint32_t Priority;
+    bool     Debug;
+    uint32_t Name;
+    int32_t  BatchSlot;
+    uint32_t Conditions; // GeneratedTables::Actions offset
+    uint32_t ConditionsSize;
+    uint32_t Results;    // GeneratedTables::Actions offset
+    uint32_t ResultsSize;
+};
+
+struct GeneratedMessage
+{
+    uint8_t  Type; // ReDefine::LogType
+    uint32_t Text;
+};
+
+struct GeneratedTables
+{
+    const char*              Name; // configuration filename
+
+    const char* const*       Strings;
+    const uint32_t*          Lists;
+
+    const GeneratedConfig*   Config;
+    uint32_t                 ConfigSize;
+
+    const GeneratedDefine*   RegularDefines;
+    uint32_t                 RegularDefinesSize;
+    const GeneratedDefine*   ProgramDefines;
+    uint32_t                 ProgramDefinesSize;
+    const GeneratedTypes*    VirtualDefines;
+    uint32_t                 VirtualDefinesSize;
+
+    const GeneratedPair*     Variables;
+    uint32_t                 VariablesSize;
+    GeneratedList            VariablesGuessing;
+
+    const GeneratedFunction* Functions;
+    const uint32_t*          FunctionsSeeds; // <hash bucket, seed used to find function slot>
+    uint32_t                 FunctionsSize;
+
+    const GeneratedPair*     Raw;
+    uint32_t                 RawSize;
+
+    GeneratedList            EditCacheSlots;
+    GeneratedList            CounterSlots;
+    const GeneratedSlot*     CounterUnknownSlots;
+    uint32_t                 CounterUnknownSlotsSize;
+    uint32_t                 EditSharedSlots;
+    uint32_t                 EditBatchSlots;
+
+    const GeneratedAction*   Actions;
+    const GeneratedEdit*     Edits;
+    uint32_t                 EditsSize;
+
+    // messages logged by ReadConfig() and ProcessHeaders() when generating tables; replayed by executable
+    const GeneratedMessage*  ConfigMessages;
+    uint32_t                 ConfigMessagesSize;
+    const GeneratedMessage*  HeadersMessages;
+    uint32_t                 HeadersMessagesSize;
+};
+
+// FNV-1a mixed with seed; used by generator to build perfect hash table of functions, and by executable to search it
+constexpr uint32_t GeneratedHash( const char* text, const size_t size, const uint32_t seed )
+{
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+
+    for( size_t idx = 0; idx < size; idx++ )
+    {
+        hash ^= static_cast<unsigned char>(text[idx]);
+        hash *= 16777619u;
+    }
+
+    // final mix, so seeds differing by single bit gives unrelated results
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+// defined in generated source
+extern const GeneratedTables ReDefineGenerated;
+
+// see Generator/Generated.cpp
+bool ReDefineGeneratedConfig( Ini* config );
+bool ReDefineGeneratedReadConfig( ReDefine* redefine, const std::string& plugins );
+void ReDefineGeneratedProcessHeaders( ReDefine* redefine );
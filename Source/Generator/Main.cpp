@@ -0,0 +1,538 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "../Executable/CommandLine.h"
+#include "../Ini.h"
+
+#include "../ReDefine.h"
+
+#include "Generated.h"
+
+//
+// generates C++ source with configuration, defines, functions prototypes and script edits stored as constant tables, see Generator/Generated.h
+// used to build ReDefine executable for fixed configuration, which doesn't need to load config, validate it, or parse headers at runtime
+//
+
+static std::string GetLiteral( const std::string& text )
+{
+    std::string result = "\"";
+
+    for( const char& ch : text )
+    {
+        const unsigned char uch = static_cast<unsigned char>(ch);
+
+        if( ch == '"' || ch == '\\' )
+        {
+            result += '\\';
+            result += ch;
+        }
+        else if( uch < 0x20 || uch >= 0x7F || ch == '?' ) // '?' prevents trigraphs
+        {
+            char oct[5];
+            std::snprintf( oct, sizeof(oct), "\\%03o", uch );
+            result += oct;
+        }
+        else
+            result += ch;
+    }
+
+    return result + "\"";
+}
+
+// collects strings and lists of strings referenced by tables
+struct GeneratedPool
+{
+    std::map<std::string, uint32_t> Index;
+    std::vector<std::string>        Strings;
+    std::vector<uint32_t>           Lists;
+
+    uint32_t                        GetIndex( const std::string& value )
+    {
+        auto it = Index.find( value );
+        if( it == Index.end() )
+        {
+            it = Index.emplace( value, static_cast<uint32_t>(Strings.size() ) ).first;
+            Strings.push_back( value );
+        }
+
+        return it->second;
+    }
+
+    std::string GetString( const std::string& value )
+    {
+        return std::to_string( GetIndex( value ) );
+    }
+
+    std::string GetList( const std::vector<std::string>& values )
+    {
+        const size_t offset = Lists.size();
+
+        for( const auto& value : values )
+        {
+            Lists.push_back( GetIndex( value ) );
+        }
+
+        return "{ " + std::to_string( offset ) + ", " + std::to_string( values.size() ) + " }";
+    }
+};
+
+// arrays always ends with zeroed entry, so they're never empty
+static void AddTable( std::string& text, const std::string& type, const std::string& name, const std::vector<std::string>& entries )
+{
+    text += "static constexpr " + type + " " + name + "[] =\n";
+    text += "{\n";
+
+    for( const auto& entry : entries )
+    {
+        text += "    " + entry + ",\n";
+    }
+
+    text += "    {}\n";
+    text += "};\n";
+    text += "\n";
+}
+
+static void AddDefines( GeneratedPool& pool, const ReDefine::DefinesMap& defines, std::vector<std::string>& entries )
+{
+    for( const auto& type : defines )
+    {
+        for( const auto& define : type.second )
+        {
+            entries.push_back( "{ " + pool.GetString( type.first ) + ", " + std::to_string( define.first ) + ", " + pool.GetString( define.second ) + " }" );
+        }
+    }
+}
+
+static void AddMessages( GeneratedPool& pool, const std::vector<ReDefine::LogMessage>& messages, std::vector<std::string>& entries )
+{
+    for( const auto& message : messages )
+    {
+        entries.push_back( "{ " + std::to_string( static_cast<uint32_t>(message.Type) ) + ", " + pool.GetString( message.Text ) + " }" );
+    }
+}
+
+static void AddActions( GeneratedPool& pool, const std::vector<ReDefine::ScriptEdit::Action>& actions, std::vector<std::string>& entries )
+{
+    for( const auto& action : actions )
+    {
+        entries.push_back( "{ " + pool.GetString( action.Name ) + ", " + pool.GetList( action.Values ) + ", " + (action.Negate ? "true" : "false") + ", " +
+                           std::to_string( action.CacheSlot ) + ", " + std::to_string( action.CounterSlot ) + ", " + std::to_string( action.SharedSlot ) + " }" );
+    }
+}
+
+static void AddEdits( GeneratedPool& pool, const uint8_t run, const std::map<uint32_t, std::vector<ReDefine::ScriptEdit>>& edits, std::vector<std::string>& actions, std::vector<std::string>& entries )
+{
+    for( const auto& priority : edits )
+    {
+        for( const auto& edit : priority.second )
+        {
+            const size_t conditions = actions.size();
+            AddActions( pool, edit.Conditions, actions );
+
+            const size_t results = actions.size();
+            AddActions( pool, edit.Results, actions );
+
+            entries.push_back( "{ " + std::to_string( run ) + ", " + std::to_string( priority.first ) + ", " + (edit.Debug ? "true" : "false") + ", " + pool.GetString( edit.Name ) + ", " + std::to_string( edit.BatchSlot ) + ", " +
+                               std::to_string( conditions ) + ", " + std::to_string( edit.Conditions.size() ) + ", " + std::to_string( results ) + ", " + std::to_string( edit.Results.size() ) + " }" );
+        }
+    }
+}
+
+// hash and displace; functions of each bucket are moved to free slots by searching for seed which doesn't cause collisions
+// returns false if seeds cannot be found
+static bool GetFunctionsTable( const std::map<std::string, ReDefine::FunctionProto>& functions, std::vector<const std::string*>& slots, std::vector<uint32_t>& seeds )
+{
+    const uint32_t                               size = static_cast<uint32_t>(functions.size() );
+    std::vector<std::vector<const std::string*>> buckets( size );
+
+    for( const auto& function : functions )
+    {
+        buckets[GeneratedHash( function.first.data(), function.first.size(), 0 ) % size].push_back( &function.first );
+    }
+
+    std::vector<uint32_t> order( size );
+    for( uint32_t idx = 0; idx < size; idx++ )
+    {
+        order[idx] = idx;
+    }
+
+    // biggest buckets first, while most slots are still free
+    auto biggest = [&buckets] ( const uint32_t& left, const uint32_t& right )
+                   {
+                       return buckets[left].size() > buckets[right].size();
+                   };
+    std::stable_sort( order.begin(), order.end(), biggest );
+
+    slots.assign( size, nullptr );
+    seeds.assign( size, 0 );
+
+    for( const uint32_t& bucket : order )
+    {
+        if( buckets[bucket].empty() )
+            break;
+
+        bool found = false;
+
+        for( uint32_t seed = 1; !found && seed < 0x1000000; seed++ )
+        {
+            std::vector<uint32_t> used;
+
+            found = true;
+            for( const std::string* name : buckets[bucket] )
+            {
+                const uint32_t slot = GeneratedHash( name->data(), name->size(), seed ) % size;
+
+                if( slots[slot] || std::find( used.begin(), used.end(), slot ) != used.end() )
+                {
+                    found = false;
+                    break;
+                }
+
+                used.push_back( slot );
+            }
+
+            if( found )
+            {
+                for( size_t idx = 0; idx < used.size(); idx++ )
+                {
+                    slots[used[idx]] = buckets[bucket][idx];
+                }
+
+                seeds[bucket] = seed;
+            }
+        }
+
+        if( !found )
+            return false;
+    }
+
+    return true;
+}
+
+static bool Generate( ReDefine* redefine, const std::string& config, const std::vector<ReDefine::LogMessage>& configMessages, const std::vector<ReDefine::LogMessage>& headersMessages, std::string& text )
+{
+    GeneratedPool            pool;
+    std::vector<std::string> entries;
+
+    text.clear();
+
+    // configuration in order of appearance; only settings which are not converted to tables below are used by executable
+
+    std::vector<std::string> sections;
+    redefine->Config->GetSections( sections, true );
+
+    for( const auto& section : sections )
+    {
+        std::vector<std::string> keys;
+        redefine->Config->GetSectionKeys( section, keys, true );
+
+        for( const auto& key : keys )
+        {
+            entries.push_back( "{ " + pool.GetString( section ) + ", " + pool.GetString( key ) + ", " + pool.GetString( redefine->Config->GetStr( section, key ) ) + " }" );
+        }
+    }
+
+    AddTable( text, "GeneratedConfig", "Config", entries );
+    const size_t configSize = entries.size();
+    entries.clear();
+
+    // defines
+
+    AddDefines( pool, redefine->RegularDefines, entries );
+    AddTable( text, "GeneratedDefine", "RegularDefines", entries );
+    const size_t regularDefinesSize = entries.size();
+    entries.clear();
+
+    AddDefines( pool, redefine->ProgramDefines, entries );
+    AddTable( text, "GeneratedDefine", "ProgramDefines", entries );
+    const size_t programDefinesSize = entries.size();
+    entries.clear();
+
+    for( const auto& type : redefine->VirtualDefines )
+    {
+        entries.push_back( "{ " + pool.GetString( type.first ) + ", " + pool.GetList( type.second ) + " }" );
+    }
+    AddTable( text, "GeneratedTypes", "VirtualDefines", entries );
+    const size_t virtualDefinesSize = entries.size();
+    entries.clear();
+
+    // variables
+
+    for( const auto& variable : redefine->VariablesPrototypes )
+    {
+        entries.push_back( "{ " + pool.GetString( variable.first ) + ", " + pool.GetString( variable.second ) + " }" );
+    }
+    AddTable( text, "GeneratedPair", "Variables", entries );
+    const size_t      variablesSize = entries.size();
+    const std::string variablesGuessing = pool.GetList( redefine->VariablesGuessing );
+    entries.clear();
+
+    // functions
+
+    std::vector<const std::string*> slots;
+    std::vector<uint32_t>           seeds;
+
+    if( !GetFunctionsTable( redefine->FunctionsPrototypes, slots, seeds ) )
+    {
+        redefine->WARNING( nullptr, "cannot create functions table" );
+        return false;
+    }
+
+    for( const std::string* name : slots )
+    {
+        const ReDefine::FunctionProto& function = redefine->FunctionsPrototypes[*name];
+
+        entries.push_back( "{ " + pool.GetString( *name ) + ", " + pool.GetString( function.ReturnType ) + ", " + pool.GetList( function.ArgumentsTypes ) + " }" );
+    }
+    AddTable( text, "GeneratedFunction", "Functions", entries );
+    const size_t functionsSize = entries.size();
+    entries.clear();
+
+    for( const uint32_t& seed : seeds )
+    {
+        entries.push_back( std::to_string( seed ) );
+    }
+    AddTable( text, "uint32_t", "FunctionsSeeds", entries );
+    entries.clear();
+
+    // raw
+
+    for( const auto& raw : redefine->Raw )
+    {
+        entries.push_back( "{ " + pool.GetString( raw.first ) + ", " + pool.GetString( raw.second ) + " }" );
+    }
+    AddTable( text, "GeneratedPair", "Raw", entries );
+    const size_t rawSize = entries.size();
+    entries.clear();
+
+    // script edits
+
+    const std::string editCacheSlots = pool.GetList( redefine->EditCacheSlots );
+    const std::string counterSlots = pool.GetList( redefine->CounterSlots );
+
+    // unordered map is sorted, so generated source doesn't change between runs
+    const std::map<std::string, int32_t> counterUnknownSlots( redefine->CounterUnknownSlots.begin(), redefine->CounterUnknownSlots.end() );
+    for( const auto& slot : counterUnknownSlots )
+    {
+        entries.push_back( "{ " + pool.GetString( slot.first ) + ", " + std::to_string( slot.second ) + " }" );
+    }
+    AddTable( text, "GeneratedSlot", "CounterUnknownSlots", entries );
+    const size_t counterUnknownSlotsSize = entries.size();
+    entries.clear();
+
+    std::vector<std::string> actions;
+
+    AddEdits( pool, 0, redefine->EditBefore, actions, entries );
+    AddEdits( pool, 1, redefine->EditAfter, actions, entries );
+    AddEdits( pool, 2, redefine->EditOnDemand, actions, entries );
+    AddTable( text, "GeneratedAction", "Actions", actions );
+    AddTable( text, "GeneratedEdit", "Edits", entries );
+    const size_t editsSize = entries.size();
+    entries.clear();
+
+    // messages
+
+    AddMessages( pool, configMessages, entries );
+    AddTable( text, "GeneratedMessage", "ConfigMessages", entries );
+    entries.clear();
+
+    AddMessages( pool, headersMessages, entries );
+    AddTable( text, "GeneratedMessage", "HeadersMessages", entries );
+    entries.clear();
+
+    // strings and lists are added last, as all tables above needs to fill them first
+
+    std::string head;
+    head += "// generated by ReDefineGenerator from " + config + "\n";
+    head += "// do not edit\n";
+    head += "\n";
+    head += "#include \"Generator/Generated.h\"\n";
+    head += "\n";
+
+    for( const auto& value : pool.Strings )
+    {
+        entries.push_back( GetLiteral( value ) );
+    }
+    AddTable( head, "const char*", "Strings", entries );
+    entries.clear();
+
+    for( const uint32_t& value : pool.Lists )
+    {
+        entries.push_back( std::to_string( value ) );
+    }
+    AddTable( head, "uint32_t", "Lists", entries );
+    entries.clear();
+
+    text.insert( 0, head );
+
+    text += "const GeneratedTables ReDefineGenerated =\n";
+    text += "{\n";
+    text += "    " + GetLiteral( config ) + ",\n";
+    text += "    Strings, Lists,\n";
+    text += "    Config, " + std::to_string( configSize ) + ",\n";
+    text += "    RegularDefines, " + std::to_string( regularDefinesSize ) + ",\n";
+    text += "    ProgramDefines, " + std::to_string( programDefinesSize ) + ",\n";
+    text += "    VirtualDefines, " + std::to_string( virtualDefinesSize ) + ",\n";
+    text += "    Variables, " + std::to_string( variablesSize ) + ", " + variablesGuessing + ",\n";
+    text += "    Functions, FunctionsSeeds, " + std::to_string( functionsSize ) + ",\n";
+    text += "    Raw, " + std::to_string( rawSize ) + ",\n";
+    text += "    " + editCacheSlots + ", " + counterSlots + ", CounterUnknownSlots, " + std::to_string( counterUnknownSlotsSize ) + ", " + std::to_string( redefine->EditSharedSlots ) + ", " + std::to_string( redefine->EditBatchSlots ) + ",\n";
+    text += "    Actions, Edits, " + std::to_string( editsSize ) + ",\n";
+    text += "    ConfigMessages, " + std::to_string( configMessages.size() ) + ", HeadersMessages, " + std::to_string( headersMessages.size() ) + "\n";
+    text += "};\n";
+
+    return true;
+}
+
+// makefile-like list of files used to generate output, so build system can regenerate it when headers changes
+static std::string GetDepfile( ReDefine* redefine, const std::string& output, const std::vector<std::string>& files )
+{
+    std::string text = redefine->TextGetReplaced( output, " ", "\\ " ) + ":";
+
+    for( const auto& file : files )
+    {
+        text += " \\\n  " + redefine->TextGetReplaced( file, " ", "\\ " );
+    }
+
+    return text + "\n";
+}
+
+template<typename K, typename V>
+static uint32_t GetSize( const std::map<K, V>& map )
+{
+    uint32_t size = 0;
+
+    for( const auto& it : map )
+    {
+        size += static_cast<uint32_t>(it.second.size() );
+    }
+
+    return size;
+}
+
+static bool Save( ReDefine* redefine, const std::string& filename, const std::string& text )
+{
+    // file is always written, even if content didn't change, as build system compares its time with time of inputs
+    std::ofstream file( filename, std::ios::out | std::ios::binary | std::ios::trunc );
+    if( !file.is_open() )
+    {
+        redefine->WARNING( nullptr, "cannot write file<%s>", filename.c_str() );
+        return false;
+    }
+
+    file << text;
+
+    return true;
+}
+
+void Usage( ReDefine* redefine )
+{
+    redefine->SHOW( "" );
+    redefine->SHOW( "Usage: ReDefineGenerator [options]" );
+    redefine->SHOW( "" );
+    redefine->SHOW( "OPTIONS" );
+    redefine->SHOW( "" );
+    redefine->SHOW( "  --help                     Short summary of available options" );
+    redefine->SHOW( "  --config [filename]        Changes location of configuration file (default: ReDefine.cfg)" );
+    redefine->SHOW( "  --headers [directory]      Changes location of headers (default: HeadersDir from configuration)" );
+    redefine->SHOW( "  --output [filename]        Changes location of generated file (default: ReDefine.Generated.cpp)" );
+    redefine->SHOW( "  --depfile [filename]       Saves list of files used to generate output" );
+    redefine->SHOW( "" );
+    redefine->SHOW( "Headers directory is relative to current directory, same as when running ReDefine." );
+    redefine->SHOW( "" );
+}
+
+int main( int argc, char** argv )
+{
+    CmdLine*  cmd = new CmdLine( argc, argv );
+    ReDefine* redefine = new ReDefine();
+
+    if( cmd->IsOption( "help" ) )
+    {
+        Usage( redefine );
+
+        delete cmd;
+        delete redefine;
+
+        return EXIT_SUCCESS;
+    }
+
+    redefine->Init();
+
+    // generator never writes logfiles
+    redefine->LogFile.clear();
+    redefine->LogWarning.clear();
+    redefine->LogDebug.clear();
+
+    const std::string config = cmd->IsOptionEmpty( "config" ) ? "ReDefine.cfg" : cmd->GetStr( "config" );
+    const std::string output = cmd->IsOptionEmpty( "output" ) ? "ReDefine.Generated.cpp" : cmd->GetStr( "output" );
+
+    int               result = EXIT_FAILURE;
+
+    // messages are stored in generated source, so executable logs them same way as when reading config and headers on its own
+    std::vector<ReDefine::LogMessage> configMessages, headersMessages;
+
+    if( !redefine->Config->LoadFile( config ) )
+    {
+        redefine->Status.Current.File = config;
+        redefine->WARNING( nullptr, "cannot read config" );
+    }
+    else
+    {
+        const std::string headers = cmd->IsOptionEmpty( "headers" ) ? redefine->Config->GetStr( "ReDefine", "HeadersDir" ) : cmd->GetStr( "headers" );
+
+        // validate config before converting it to tables; plugins are not loaded, as they might not exists yet
+        redefine->LogRecord = &configMessages;
+        const bool valid = redefine->ReadConfig( "Defines", "Variable", "Function", "Raw", "Script", "" );
+        redefine->LogRecord = nullptr;
+
+        // headers list is gone after ProcessHeaders()
+        std::vector<std::string> files = { std::filesystem::absolute( config ).lexically_normal().generic_string() };
+        for( const auto& header : redefine->Headers )
+        {
+            const std::string file = std::filesystem::absolute( std::filesystem::path( headers ) / header.Filename ).lexically_normal().generic_string();
+
+            if( std::find( files.begin(), files.end(), file ) == files.end() )
+                files.push_back( file );
+        }
+
+        std::string text;
+
+        if( !valid )
+        {
+            redefine->Status.Current.File = config;
+            redefine->WARNING( nullptr, "cannot parse config" );
+        }
+        else
+        {
+            redefine->LogRecord = &headersMessages;
+            redefine->ProcessHeaders( headers );
+            redefine->LogRecord = nullptr;
+
+            if( Generate( redefine, config, configMessages, headersMessages, text ) && Save( redefine, output, text ) )
+            {
+                result = EXIT_SUCCESS;
+
+                if( !cmd->IsOptionEmpty( "depfile" ) && !Save( redefine, cmd->GetStr( "depfile" ), GetDepfile( redefine, output, files ) ) )
+                    result = EXIT_FAILURE;
+            }
+        }
+
+        if( result == EXIT_SUCCESS )
+        {
+            const uint32_t defines = GetSize( redefine->RegularDefines ) + GetSize( redefine->ProgramDefines );
+            const uint32_t functions = static_cast<uint32_t>(redefine->FunctionsPrototypes.size() );
+            const uint32_t edits = GetSize( redefine->EditBefore ) + GetSize( redefine->EditAfter ) + GetSize( redefine->EditOnDemand );
+
+            redefine->SHOW( "Generated %s ... %u define%s, %u function%s, %u edit%s from %s", output.c_str(),
+                            defines, defines != 1 ? "s" : "", functions, functions != 1 ? "s" : "", edits, edits != 1 ? "s" : "", config.c_str() );
+        }
+    }
+
+    delete cmd;
+    delete redefine;
+
+    return result;
+}
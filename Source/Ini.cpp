@@ -37,11 +37,9 @@
 #include <climits>
 #include <cstring>
 #include <fstream>
-#include <functional>
-#include <istream>
 #include <map>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Ini.h"
@@ -52,49 +50,54 @@ using namespace std;
 #define SECTION_END      ']'
 #define KEY_ASSIGN       '='
 
-static vector<char> CommentChars{ ';', '#' };
+static constexpr string_view CommentChars = ";#";
 
-inline void TrimLeft( string& str )
+inline bool IsSpace( char c )
 {
-    /*c++14
-    str.erase( str.begin(), find_if( str.begin(), str.end(), not1( ptr_fun<int, int>( isspace ) ) ) );
-    //c++17+
-    */
-    str.erase(str.begin(), find_if(str.begin(), str.end(), [](char c) {return !std::isspace(c); }));
+    return std::isspace( static_cast<unsigned char>(c) ) != 0;
 }
 
-inline void TrimRight( string& str )
+inline string_view TrimLeft( string_view str )
 {
-    /*c++14
-    str.erase( find_if( str.rbegin(), str.rend(), not1( ptr_fun<int, int>( isspace ) ) ).base(), str.end() );
-    //c++17+
-    */
-    str.erase(find_if(str.rbegin(), str.rend(), [](char c) { return !std::isspace(c); }).base(), str.end() );
+    while( !str.empty() && IsSpace( str.front() ) )
+    {
+        str.remove_prefix( 1 );
+    }
+
+    return str;
 }
 
-inline void Cleanup( string& str )
+inline string_view TrimRight( string_view str )
 {
-    str.erase( remove( str.begin(), str.end(), '\r' ), str.end() );
-    str.erase( remove( str.begin(), str.end(), '\n' ), str.end() );
-    replace( str.begin(), str.end(), '\t', ' ' );
-}
+    while( !str.empty() && IsSpace( str.back() ) )
+    {
+        str.remove_suffix( 1 );
+    }
 
-//
+    return str;
+}
 
-Ini::Ini() : KeepComments( false ), KeepSectionsRaw( false ), KeepKeysOrder( false )
+// removes newlines and changes tabs into spaces; returns new length, as string can only get shorter
+inline size_t Cleanup( char* str, size_t length )
 {
-    /*
-    #if defined (FOCLASSIC_ENGINE) && defined (FO_WINDOWS) && defined (FO_MSVC) && _MSC_VER >= 1910 && !defined (__INTELLISENSE__)
-    # pragma TODO("Use initializer list for CommentChars")
-    #endif
-    if( CommentChars.empty() )
+    char* out = str;
+
+    for( char* in = str, * end = str + length; in != end; ++in )
     {
-        CommentChars.push_back( '#' );
-        CommentChars.push_back( ';' );
+        if( *in == '\r' || *in == '\n' )
+            continue;
+
+        *out++ = *in == '\t' ? ' ' : *in;
     }
-    */
+
+    return out - str;
 }
 
+//
+
+Ini::Ini() : KeepComments( false ), KeepSectionsRaw( false ), KeepKeysOrder( false )
+{}
+
 Ini::~Ini()
 {
     Unload();
@@ -108,16 +111,26 @@ bool Ini::LoadFile( const string& fname, bool unload /* = true */ )
         Unload();
 
     ifstream fstream;
-    fstream.open( fname, ios_base::in | ios_base::binary );
+    fstream.open( fname, ios_base::in | ios_base::binary | ios_base::ate );
 
     if( fstream.is_open() )
     {
+        streamoff size = fstream.tellg();
+        fstream.seekg( 0, fstream.beg );
+
         char bom[3] = { 0, 0, 0 };
         fstream.read( bom, sizeof(bom) );
+        fstream.clear();
         if( bom[0] != (char)0xEF || bom[1] != (char)0xBB || bom[2] != (char)0xBF )
             fstream.seekg( 0, fstream.beg );
+        else
+            size -= 3;
 
-        Parse( fstream );
+        // whole file is read into arena, and parsed in place
+        Arena.emplace_back( new char[size > 0 ? size : 1] );
+        fstream.read( Arena.back().get(), size );
+
+        Parse( Arena.back().get(), static_cast<size_t>(fstream.gcount() ) );
 
         return true;
     }
@@ -129,7 +142,11 @@ bool Ini::LoadStr( const string& str, bool unload /* = true */ )
 {
     if( unload )
         Unload();
-    ParseString( str );
+
+    Arena.emplace_back( new char[str.size() + 1] );
+    memcpy( Arena.back().get(), str.data(), str.size() );
+
+    Parse( Arena.back().get(), str.size() );
 
     return true;
 }
@@ -137,151 +154,186 @@ bool Ini::LoadStr( const string& str, bool unload /* = true */ )
 void Ini::Unload()
 {
     Sections.clear();
-    SectionsRaw.clear();
     SectionsOrder.clear();
+    SectionsRaw.clear();
+    Arena.clear();
 }
 
 //
 
-void Ini::Parse( basic_istream<char>& stream )
+void Ini::Parse( char* data, size_t size )
 {
-    string line;
-    string section;
+    string_view section;
+    char*       end = data + size;
 
-    while( !stream.eof() )
+    for( char* pos = data; pos < end;)
     {
-        getline( stream, line );
+        char* eol = static_cast<char*>(memchr( pos, '\n', end - pos ) );
+        if( !eol )
+            eol = end;
 
-        Cleanup( line );
+        string_view line( pos, Cleanup( pos, eol - pos ) );
+        pos = eol + 1;
 
         if( !KeepComments )
-        {
-            for( auto it = CommentChars.begin(), end = CommentChars.end(); it != end; ++it )
-            {
-                line = line.substr( 0, line.find( *it ) );
-            }
-        }
-
-        TrimLeft( line );
-        TrimRight( line );
+            line = line.substr( 0, line.find_first_of( CommentChars ) );
 
-        const size_t length = line.length();
+        line = TrimRight( TrimLeft( line ) );
 
-        if( !length || line.empty() )
+        if( line.empty() )
             continue;
 
-        const size_t pos = line.find_first_of( KEY_ASSIGN );
-        const char&  front = line.front();
+        const size_t pos_assign = line.find( KEY_ASSIGN );
 
-        if( front == SECTION_START )
+        if( line.front() == SECTION_START )
         {
             if( line.back() == SECTION_END )
-                section = line.substr( 1, length - 2 );
+                section = line.substr( 1, line.length() - 2 );
         }
-        else if( pos != 0 && pos != string::npos )
+        else if( pos_assign != 0 && pos_assign != string_view::npos )
         {
-            string key( line.substr( 0, pos ) );
-            string value( line.substr( pos + 1, length ) );
-
-            TrimRight( key );
-            TrimLeft( value );
+            string_view key = TrimRight( line.substr( 0, pos_assign ) );
+            string_view value = TrimLeft( line.substr( pos_assign + 1 ) );
 
-            if( !IsSectionKey( section, key ) )
-                SetStr( section, key, value );
+            // first value wins
+            if( !FindKey( section, key ) )
+                AddKey( section, key, value );
 
             if( KeepSectionsRaw )
-                AddSectionRaw( section, line );
+                AddSectionRaw( string( section ), string( line ) );
         }
         else if( KeepSectionsRaw )
-            AddSectionRaw( section, line );
+            AddSectionRaw( string( section ), string( line ) );
     }
 }
 
-void Ini::ParseString( const string& str )
+string_view Ini::Store( string_view str )
+{
+    Arena.emplace_back( new char[str.size() + 1] );
+    memcpy( Arena.back().get(), str.data(), str.size() );
+
+    return string_view( Arena.back().get(), str.size() );
+}
+
+Ini::IniSection* Ini::FindSection( string_view section )
+{
+    auto it = Sections.find( section );
+    if( it == Sections.end() )
+        return nullptr;
+
+    return &it->second;
+}
+
+const Ini::IniKey* Ini::FindKey( string_view section, string_view key )
+{
+    IniSection* ini_section = FindSection( section );
+    if( !ini_section )
+        return nullptr;
+
+    auto it = ini_section->Index.find( key );
+    if( it == ini_section->Index.end() )
+        return nullptr;
+
+    return &ini_section->Keys[it->second];
+}
+
+// all arguments must point to arena
+void Ini::AddKey( string_view section, string_view key, string_view value )
 {
-    stringstream buf;
-    buf << str;
+    auto it = Sections.find( section );
+    if( it == Sections.end() )
+    {
+        it = Sections.emplace( section, IniSection() ).first;
+        SectionsOrder.push_back( section );
+    }
 
-    Parse( buf );
+    IniSection& ini_section = it->second;
+
+    ini_section.Index.emplace( key, ini_section.Keys.size() );
+    ini_section.Keys.push_back( { key, value } );
 }
 
 //
 
 bool Ini::IsSection( const string& section )
 {
-    return Sections.find( section ) != Sections.end();
+    return FindSection( section ) != nullptr;
 }
 
 bool Ini::IsSectionKey( const string& section, const string& key )
 {
-    if( !IsSection( section ) )
-        return false;
-
-    return Sections[section].find( key ) != Sections[section].end();
+    return FindKey( section, key ) != nullptr;
 }
 
 bool Ini::IsSectionKeyEmpty( const string& section, const string& key )
 {
-    if( !IsSectionKey( section, key ) )
-        return true;
+    const IniKey* ini_key = FindKey( section, key );
 
-    return Sections[section][key].empty();
+    return !ini_key || ini_key->Value.empty();
 }
 
-unsigned int Ini::GetSections( vector<string>& sections )
+unsigned int Ini::GetSections( vector<string>& sections, bool ordered /* = false */ )
 {
-    unsigned int count = 0;
+    vector<string_view> names = SectionsOrder;
+
+    // sections are returned in alphabetical order, unless requested otherwise
+    if( !ordered )
+        sort( names.begin(), names.end() );
 
-    for( IniSections::iterator it = Sections.begin(); it != Sections.end(); ++it, count++ )
+    for( const auto& name : names )
     {
-        sections.push_back( it->first );
+        sections.emplace_back( name );
     }
 
-    return count;
+    return static_cast<unsigned int>(names.size() );
 }
 
 unsigned int Ini::GetSectionKeys( const string& section, vector<string>& keys, bool ordered /* = false */ )
 {
-    unsigned int count = 0;
+    IniSection* ini_section = FindSection( section );
+    if( !ini_section )
+        return 0;
 
-    if( IsSection( section ) )
+    if( ordered )
     {
-        if( ordered )
+        for( const IniKey& ini_key : ini_section->Keys )
         {
-            for( vector<string>::iterator it = SectionsOrder[section].begin(); it != SectionsOrder[section].end(); ++it )
-            {
-                keys.push_back( *it );
-                count++;
-            }
+            keys.emplace_back( ini_key.Name );
         }
-        else
+    }
+    else
+    {
+        vector<string_view> names;
+        names.reserve( ini_section->Keys.size() );
+
+        for( const IniKey& ini_key : ini_section->Keys )
+        {
+            names.push_back( ini_key.Name );
+        }
+
+        sort( names.begin(), names.end() );
+
+        for( const auto& name : names )
         {
-            for( IniSection::iterator it = Sections[section].begin(); it != Sections[section].end(); ++it )
-            {
-                keys.push_back( it->first );
-                count++;
-            }
+            keys.emplace_back( name );
         }
     }
 
-    return count;
+    return static_cast<unsigned int>(ini_section->Keys.size() );
 }
 
 //
 
 bool Ini::MergeSections( const string& to, const string& from, bool overwrite /* = false */ )
 {
-    if( from == to || !IsSection( from ) )
+    IniSection* ini_from = FindSection( from );
+    if( from == to || !ini_from )
         return false;
 
-    vector<string> keys;
-    for( unsigned int k = 0, kLen = GetSectionKeys( from, keys ); k < kLen; k++ )
+    for( const IniKey& ini_key : ini_from->Keys )
     {
-        if( overwrite || !IsSectionKey( to, keys[k] ) )
-        {
-            string key = keys[k];
-            SetStr( to, key, Sections[from][key] );
-        }
+        if( overwrite || !FindKey( to, ini_key.Name ) )
+            SetStr( to, string( ini_key.Name ), string( ini_key.Value ) );
     }
 
     RemoveSection( from );
@@ -290,13 +342,14 @@ bool Ini::MergeSections( const string& to, const string& from, bool overwrite /*
 
 bool Ini::RemoveSection( const string& section )
 {
-    if( !IsSection( section ) )
+    auto it = Sections.find( section );
+    if( it == Sections.end() )
         return false;
 
-    Sections.erase( section );
+    SectionsOrder.erase( find( SectionsOrder.begin(), SectionsOrder.end(), it->first ) );
+    Sections.erase( it );
 
     RemoveSectionRaw( section );
-    RemoveSectionOrder( section );
 
     return true;
 }
@@ -342,13 +395,7 @@ void Ini::AddSectionRaw( const string& section, const string& line )
     if( line.empty() )
         return;
 
-    if( !IsSectionRaw( section ) )
-    {
-        vector<string>& raw = SectionsRaw[section];
-        raw.push_back( line );
-    }
-    else
-        SectionsRaw[section].push_back( line );
+    SectionsRaw[section].push_back( line );
 }
 
 bool Ini::RemoveSectionRaw( const string& section )
@@ -363,41 +410,13 @@ bool Ini::RemoveSectionRaw( const string& section )
 
 //
 
-bool Ini::IsSectionOrder( const string& section )
-{
-    return SectionsOrder.find( section ) != SectionsOrder.end();
-}
-
-void Ini::AddSectionOrder( const string& section, const string& key )
-{
-    if( !IsSectionOrder( section ) )
-    {
-        vector<string>& ini_section = SectionsOrder[section];
-        ini_section.push_back( key );
-    }
-    else
-        SectionsOrder[section].push_back( key );
-}
-
-bool Ini::RemoveSectionOrder( const string& section )
-{
-    if( !IsSectionOrder( section ) )
-        return false;
-
-    SectionsOrder.erase( section );
-
-    return true;
-}
-
-//
-
 bool Ini::GetBool( const string& section, const string& key, const bool& default_value )
 {
     bool result = default_value;
 
     if( !IsSectionKeyEmpty( section, key ) )
     {
-        string str = Sections[section][key];
+        string str( GetStrView( section, key ) );
         transform( str.begin(), str.end(), str.begin(), ::tolower );
 
         result = (str == "1" || str == "yes" || str == "true" || str == "on" || str == "enable");
@@ -412,7 +431,7 @@ int Ini::GetInt( const string& section, const string& key, const int& default_va
 
     if( !IsSectionKeyEmpty( section, key ) )
     {
-        string str = Sections[section][key];
+        string str( GetStrView( section, key ) );
 
         // https://stackoverflow.com/a/6154614
         const char* cstr = str.c_str();
@@ -443,57 +462,70 @@ int Ini::GetHex( const string& section, const string& key, const int& default_va
 
 string Ini::GetStr( const string& section, const string& key )
 {
-    if( !IsSectionKeyEmpty( section, key ) )
-        return string( Sections[section][key] );
-
-    static const string empty;
-    return empty;
+    return string( GetStrView( section, key ) );
 }
 
 string Ini::GetStr( const string& section, const string& key, const string& default_value )
 {
     if( !IsSectionKeyEmpty( section, key ) )
-        return string( Sections[section][key] );
+        return string( GetStrView( section, key ) );
 
     return string( default_value );
 }
 
 vector<string> Ini::GetStrVec( const string& section, const string& key, char separator /* = ' ' */ )
 {
-    string         value = GetStr( section, key );
+    string_view    value = GetStrView( section, key );
     vector<string> result;
 
-    if( !value.empty() )
+    while( !value.empty() )
     {
-        string        tmp;
-        istringstream f( value );
-        while( getline( f, tmp, separator ) )
-        {
-            Cleanup( tmp );
-            if( separator != ' ' )
-            {
-                TrimLeft( tmp );
-                TrimRight( tmp );
-            }
-            result.push_back( tmp );
-        }
+        const size_t pos = value.find( separator );
+        string       tmp( value.substr( 0, pos ) );
+
+        // value set with SetStr() might not be cleaned yet
+        tmp.resize( Cleanup( tmp.data(), tmp.size() ) );
+        if( separator != ' ' )
+            tmp = string( TrimRight( TrimLeft( tmp ) ) );
+
+        result.push_back( move( tmp ) );
+
+        // separator at end of value doesn't add empty element
+        if( pos == string_view::npos )
+            break;
+
+        value.remove_prefix( pos + 1 );
     }
 
     return result;
 }
 
+string_view Ini::GetStrView( const string& section, const string& key )
+{
+    const IniKey* ini_key = FindKey( section, key );
+    if( !ini_key )
+        return string_view();
+
+    return ini_key->Value;
+}
+
 //
 
 void Ini::SetStr( const string& section, const string& key, string value )
 {
-    if( IsSectionKey( section, key ) )
-        Sections[section][key] = value;
-    else
+    IniSection* ini_section = FindSection( section );
+    if( ini_section )
     {
-        IniSection& ini_section = Sections[section];
-        ini_section.insert( make_pair( key, value ) );
+        auto it = ini_section->Index.find( key );
+        if( it != ini_section->Index.end() )
+        {
+            ini_section->Keys[it->second].Value = Store( value );
+            return;
+        }
     }
 
-    if( KeepKeysOrder )
-        AddSectionOrder( section, key );
+    // reuse section name if possible
+    string_view name = ini_section ? Sections.find( section )->first : Store( section );
+
+    AddKey( name, Store( key ), Store( value ) );
 }
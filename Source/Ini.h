@@ -29,22 +29,37 @@
 #ifndef __INI__
 #define __INI__
 
-#include <istream>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
-typedef std::map<std::string, std::string>              IniSection;
-typedef std::map<std::string, IniSection>               IniSections;
-
 typedef std::map<std::string, std::vector<std::string>> IniSectionsData;
 
 class Ini
 {
 protected:
-    IniSections     Sections;
-    IniSectionsData SectionsRaw;
-    IniSectionsData SectionsOrder;
+    // all strings are kept in arena, and referenced with string_view everywhere else
+    // LoadFile()/LoadStr() keeps whole content in single block, parsed in place; SetStr() adds new block for each string
+    std::vector<std::unique_ptr<char[]>> Arena;
+
+    struct IniKey
+    {
+        std::string_view Name;
+        std::string_view Value;
+    };
+
+    struct IniSection
+    {
+        std::vector<IniKey>                          Keys;  // in order of appearance
+        std::unordered_map<std::string_view, size_t> Index; // <name, Keys index>
+    };
+
+    std::unordered_map<std::string_view, IniSection> Sections;
+    std::vector<std::string_view>                    SectionsOrder; // in order of appearance
+    IniSectionsData                                  SectionsRaw;
 
 public:
     // Any comments present are not removed when parsing file/string
@@ -55,8 +70,7 @@ public:
     // Default: false
     bool KeepSectionsRaw;
 
-    // If order of all sections should be stored, value should be set to true before LoadFile() call
-    // Otherwise, value should be set to true before calling SetStr()
+    // Order of keys is always stored, setting is kept for compatibility only
     // Default: false
     bool KeepKeysOrder;
 
@@ -68,14 +82,18 @@ public:
     virtual void Unload();
 
 protected:
-    virtual void Parse( std::basic_istream<char>& is );
-    virtual void ParseString( const std::string& str );
+    virtual void Parse( char* data, size_t size );
+
+    std::string_view Store( std::string_view str );
+    IniSection*      FindSection( std::string_view section );
+    const IniKey*    FindKey( std::string_view section, std::string_view key );
+    void             AddKey( std::string_view section, std::string_view key, std::string_view value );
 
 public:
     virtual bool         IsSection( const std::string& section );
     virtual bool         IsSectionKey( const std::string& section, const std::string& key );
     virtual bool         IsSectionKeyEmpty( const std::string& section, const std::string& key );
-    virtual unsigned int GetSections( std::vector<std::string>& sections );
+    virtual unsigned int GetSections( std::vector<std::string>& sections, bool ordered = false );
     virtual unsigned int GetSectionKeys( const std::string& section, std::vector<std::string>& keys, bool ordered = false );
 
     virtual bool MergeSections( const std::string& to, const std::string& from, bool overwrite = false );
@@ -90,12 +108,6 @@ protected:
     virtual void AddSectionRaw( const std::string& section, const std::string& line );
     virtual bool RemoveSectionRaw( const std::string& section );
 
-protected:
-    // KeepKeysOrder handling
-    virtual bool IsSectionOrder( const std::string& section );
-    virtual void AddSectionOrder( const std::string& section, const std::string& key );
-    virtual bool RemoveSectionOrder( const std::string& section );
-
 public:
     virtual bool                     GetBool( const std::string& section, const std::string& key, const bool& default_value );
     virtual int                      GetInt( const std::string& section, const std::string& key, const int& default_value, const unsigned char& base = 10 );
@@ -105,6 +117,9 @@ public:
     virtual std::string              GetStr( const std::string& section, const std::string& key, const std::string& default_value );
     virtual std::vector<std::string> GetStrVec( const std::string& section, const std::string& key, char separator = ' ' );
 
+    // returned value stays valid until Unload() call
+    virtual std::string_view GetStrView( const std::string& section, const std::string& key );
+
     virtual void SetStr( const std::string& section, const std::string& key, std::string value );
 };
 
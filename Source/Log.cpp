@@ -1,3 +1,4 @@
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
@@ -6,7 +7,69 @@
 
 #include "ReDefine.h"
 
-static void Print( ReDefine* redefine, const std::string& log, const char* prefix, const char* caller, const char* format, va_list& args, bool lineInfo )
+// committed messages are passed to writer thread using lock-free stack, and reordered by writer
+struct ReDefine::LogQueue
+{
+    struct Batch
+    {
+        uint64_t                Sequence;
+        std::vector<LogMessage> Messages;
+        Batch*                  Next;
+    };
+
+    std::atomic<Batch*>   Head { nullptr };
+    std::atomic<uint32_t> Signal { 0 }; // changed whenever there's something to do for writer
+    std::atomic<bool>     Stop { false };
+    std::thread           Thread;
+};
+
+// buffer used by current thread; see LogCapture()
+static thread_local const ReDefine*                    CaptureOwner = nullptr;
+static thread_local std::vector<ReDefine::LogMessage>* CaptureBuffer = nullptr;
+
+static void Output( const std::string& log, const std::string& full )
+{
+    // show...
+    std::printf( "%s\n", full.c_str() );
+
+    // ...and save
+    if( !log.empty() )
+    {
+        std::ofstream flog;
+        flog.open( log, std::ios::out | std::ios::app );
+        if( flog.is_open() )
+        {
+            flog << full;
+            flog << std::endl;
+
+            flog.close();
+        }
+        // else
+        //     std::printf( "Cannot write: %s\n", log.c_str() );
+    }
+}
+
+static const std::string& GetLog( ReDefine* redefine, ReDefine::LogType type )
+{
+    static const std::string none;
+
+    if( !redefine )
+        return none;
+
+    switch( type )
+    {
+        case ReDefine::LogType::LOG:
+            return redefine->LogFile;
+        case ReDefine::LogType::WARNING:
+            return redefine->LogWarning;
+        case ReDefine::LogType::DEBUG:
+            return redefine->LogDebug;
+        default:
+            return none;
+    }
+}
+
+static void Print( ReDefine* redefine, ReDefine::LogType type, const char* prefix, const char* caller, const char* format, va_list& args, bool lineInfo )
 {
     static constexpr uint32_t textSize = 4096;
     std::string               full;
@@ -59,31 +122,20 @@ static void Print( ReDefine* redefine, const std::string& log, const char* prefi
         full += redefine->TextGetTrimmed( redefine->Status.Current.Line );
     }
 
-    // show...
-    std::printf( "%s\n", full.c_str() );
-
-    // ...and save
-    if( !log.empty() )
-    {
-        std::ofstream flog;
-        flog.open( log, std::ios::out | std::ios::app );
-        if( flog.is_open() )
-        {
-            flog << full;
-            flog << std::endl;
+    if( redefine && CaptureOwner == redefine && CaptureBuffer )
+        CaptureBuffer->push_back( { type, full } );
+    else
+        Output( GetLog( redefine, type ), full );
 
-            flog.close();
-        }
-        // else
-        //     std::printf( "Cannot write: %s\n", log.c_str() );
-    }
+    if( redefine && redefine->LogRecord )
+        redefine->LogRecord->push_back( { type, full } );
 }
 
 void ReDefine::DEBUG( const char* caller, const char* format, ... )
 {
     va_list list;
     va_start( list, format );
-    Print( this, LogDebug, "DEBUG", caller, format, list, true );
+    Print( this, LogType::DEBUG, "DEBUG", caller, format, list, true );
     va_end( list );
 }
 
@@ -91,7 +143,7 @@ void ReDefine::WARNING( const char* caller, const char* format, ... )
 {
     va_list list;
     va_start( list, format );
-    Print( this, LogWarning, "WARNING", caller, format, list, true );
+    Print( this, LogType::WARNING, "WARNING", caller, format, list, true );
     va_end( list );
 }
 
@@ -99,7 +151,7 @@ void ReDefine::ILOG( const char* format, ... )
 {
     va_list list;
     va_start( list, format );
-    Print( this, LogFile, nullptr, nullptr, format, list, true );
+    Print( this, LogType::LOG, nullptr, nullptr, format, list, true );
     va_end( list );
 }
 
@@ -107,7 +159,7 @@ void ReDefine::LOG( const char* format, ... )
 {
     va_list list;
     va_start( list, format );
-    Print( this, LogFile, nullptr, nullptr, format, list, false );
+    Print( this, LogType::LOG, nullptr, nullptr, format, list, false );
     va_end( list );
 }
 
@@ -115,6 +167,138 @@ void ReDefine::SHOW( const char* format, ... )
 {
     va_list list;
     va_start( list, format );
-    Print( this, std::string(), nullptr, nullptr, format, list, false );
+    Print( this, LogType::SHOW, nullptr, nullptr, format, list, false );
     va_end( list );
 }
+
+void ReDefine::LogReplay( const std::vector<LogMessage>& messages )
+{
+    for( const LogMessage& message : messages )
+    {
+        if( CaptureOwner == this && CaptureBuffer )
+            CaptureBuffer->push_back( message );
+        else
+            Output( GetLog( this, message.Type ), message.Text );
+
+        if( LogRecord )
+            LogRecord->push_back( message );
+    }
+}
+
+// all messages logged by current thread are added to buffer instead of being written; nullptr stops capturing
+// returns buffer used before, so capturing can be restored
+std::vector<ReDefine::LogMessage>* ReDefine::LogCapture( std::vector<LogMessage>* buffer )
+{
+    std::vector<LogMessage>* previous = CaptureOwner == this ? CaptureBuffer : nullptr;
+
+    CaptureOwner = buffer ? this : nullptr;
+    CaptureBuffer = buffer;
+
+    return previous;
+}
+
+// same as Output(), but logfiles are kept open until all given messages are written
+static void OutputBatch( ReDefine* redefine, const std::vector<ReDefine::LogMessage>& messages, std::map<std::string, std::ofstream>& files )
+{
+    for( const ReDefine::LogMessage& message : messages )
+    {
+        std::printf( "%s\n", message.Text.c_str() );
+
+        const std::string& log = GetLog( redefine, message.Type );
+        if( log.empty() )
+            continue;
+
+        auto it = files.find( log );
+        if( it == files.end() )
+            it = files.emplace( log, std::ofstream( log, std::ios::out | std::ios::app ) ).first;
+
+        if( it->second.is_open() )
+            it->second << message.Text << '\n';
+    }
+}
+
+// writes batches in order of sequence numbers; batch is kept until all batches before it are written
+// after stop is requested, everything left is written as-is
+static void LogWrite( ReDefine* redefine, ReDefine::LogQueue* queue )
+{
+    std::map<uint64_t, ReDefine::LogQueue::Batch*> pending;
+    uint64_t                                       next = 0;
+
+    while( true )
+    {
+        const uint32_t signal = queue->Signal.load( std::memory_order_acquire );
+        const bool     stop = queue->Stop.load( std::memory_order_acquire );
+
+        for( ReDefine::LogQueue::Batch* batch = queue->Head.exchange( nullptr, std::memory_order_acquire ); batch;)
+        {
+            ReDefine::LogQueue::Batch* nextBatch = batch->Next;
+            pending[batch->Sequence] = batch;
+            batch = nextBatch;
+        }
+
+        std::map<std::string, std::ofstream> files;
+        for( auto it = pending.begin(); it != pending.end() && (it->first == next || stop); it = pending.erase( it ) )
+        {
+            OutputBatch( redefine, it->second->Messages, files );
+            next = it->first + 1;
+
+            delete it->second;
+        }
+
+        files.clear();
+
+        if( stop )
+            break;
+
+        queue->Signal.wait( signal, std::memory_order_acquire );
+    }
+}
+
+// messages committed without running writer are written immediately
+void ReDefine::LogCommit( const uint64_t sequence, std::vector<LogMessage>& messages )
+{
+    if( !LogWriter )
+    {
+        for( const LogMessage& message : messages )
+        {
+            Output( GetLog( this, message.Type ), message.Text );
+        }
+
+        messages.clear();
+        return;
+    }
+
+    LogQueue::Batch* batch = new LogQueue::Batch { sequence, std::move( messages ), nullptr };
+    messages.clear();
+
+    batch->Next = LogWriter->Head.load( std::memory_order_relaxed );
+    while( !LogWriter->Head.compare_exchange_weak( batch->Next, batch, std::memory_order_release, std::memory_order_relaxed ) )
+    {}
+
+    LogWriter->Signal.fetch_add( 1, std::memory_order_release );
+    LogWriter->Signal.notify_one();
+}
+
+// sequence numbers of committed messages must start from 0
+void ReDefine::LogWriterStart()
+{
+    LogWriterStop();
+
+    LogWriter = new LogQueue();
+    LogWriter->Thread = std::thread( LogWrite, this, LogWriter );
+}
+
+// waits until all committed messages are written
+void ReDefine::LogWriterStop()
+{
+    if( !LogWriter )
+        return;
+
+    LogWriter->Stop.store( true, std::memory_order_release );
+    LogWriter->Signal.fetch_add( 1, std::memory_order_release );
+    LogWriter->Signal.notify_one();
+    LogWriter->Thread.join();
+
+    delete LogWriter;
+    LogWriter = nullptr;
+}
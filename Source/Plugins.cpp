@@ -0,0 +1,187 @@
+#if defined (_WIN32)
+# include <windows.h>
+#else
+# include <dlfcn.h>
+#endif
+
+#include "Ini.h"
+
+#include "ReDefine.h"
+
+typedef uint32_t (* PluginVersionFunc)();
+typedef bool (* PluginInitFunc)( ReDefine* );
+
+static void* PluginOpen( const std::string& filename )
+{
+    #if defined (_WIN32)
+    return reinterpret_cast<void*>(LoadLibraryA( filename.c_str() ) );
+    #else
+    return dlopen( filename.c_str(), RTLD_NOW | RTLD_LOCAL );
+    #endif
+}
+
+static void* PluginSymbol( void* handle, const char* name )
+{
+    #if defined (_WIN32)
+    return reinterpret_cast<void*>(GetProcAddress( reinterpret_cast<HMODULE>(handle), name ) );
+    #else
+    return dlsym( handle, name );
+    #endif
+}
+
+static void PluginClose( void* handle )
+{
+    #if defined (_WIN32)
+    FreeLibrary( reinterpret_cast<HMODULE>(handle) );
+    #else
+    dlclose( handle );
+    #endif
+}
+
+static std::string PluginError()
+{
+    #if defined (_WIN32)
+    return std::to_string( GetLastError() );
+    #else
+    const char* error = dlerror();
+    return error ? error : "";
+    #endif
+}
+
+//
+
+ReDefine::Plugin::Plugin() :
+    Handle( nullptr ),
+    Restore( false )
+{}
+
+//
+
+void ReDefine::FinishPlugins()
+{
+    // actions added by plugins must be removed before unloading, as they point to plugin code
+
+    for( auto it = Plugins.rbegin(); it != Plugins.rend(); ++it )
+    {
+        UnloadPlugin( *it );
+    }
+
+    Plugins.clear();
+}
+
+bool ReDefine::ReadConfigPlugins( const std::string& section )
+{
+    FinishPlugins();
+
+    std::vector<std::string> keys;
+    if( !Config->GetSectionKeys( section, keys, true ) )
+        return true;
+
+    for( const auto& name : keys )
+    {
+        const std::string filename = Config->GetStr( section, name );
+
+        if( filename.empty() )
+            continue;
+
+        if( !LoadPlugin( name, filename ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool ReDefine::LoadPlugin( const std::string& name, const std::string& filename )
+{
+    Plugin plugin;
+    plugin.Name = name;
+    plugin.Filename = filename;
+    plugin.Handle = PluginOpen( filename );
+
+    if( !plugin.Handle )
+    {
+        WARNING( __FUNCTION__, "plugin<%s> cannot load file<%s> : %s", name.c_str(), filename.c_str(), PluginError().c_str() );
+        return false;
+    }
+
+    PluginVersionFunc version = reinterpret_cast<PluginVersionFunc>(PluginSymbol( plugin.Handle, "ReDefinePluginVersion" ) );
+    PluginInitFunc    init = reinterpret_cast<PluginInitFunc>(PluginSymbol( plugin.Handle, "ReDefinePluginInit" ) );
+
+    if( !version || !init )
+    {
+        WARNING( __FUNCTION__, "plugin<%s> does not export ReDefinePluginVersion() and/or ReDefinePluginInit()", name.c_str() );
+        UnloadPlugin( plugin );
+        return false;
+    }
+
+    if( version() != REDEFINE_PLUGIN_VERSION )
+    {
+        WARNING( __FUNCTION__, "plugin<%s> version<%u> does not match expected version<%u>", name.c_str(), version(), REDEFINE_PLUGIN_VERSION );
+        UnloadPlugin( plugin );
+        return false;
+    }
+
+    // remember actions state, so anything added or replaced by plugin can be reverted when it's unloaded
+
+    plugin.PreviousEditIf = EditIf;
+    plugin.PreviousEditDo = EditDo;
+    plugin.PreviousEditCache = EditCache;
+    plugin.PreviousEditCounter = EditCounter;
+    plugin.PreviousEditIfPure = EditIfPure;
+    plugin.PreviousEditIfUnordered = EditIfUnordered;
+    plugin.Restore = true;
+
+    if( !init( this ) )
+    {
+        WARNING( __FUNCTION__, "plugin<%s> initialization failed", name.c_str() );
+        UnloadPlugin( plugin );
+        return false;
+    }
+
+    for( const auto& it : EditIf )
+    {
+        if( plugin.PreviousEditIf.find( it.first ) == plugin.PreviousEditIf.end() )
+            plugin.EditIf.push_back( it.first );
+    }
+
+    for( const auto& it : EditDo )
+    {
+        if( plugin.PreviousEditDo.find( it.first ) == plugin.PreviousEditDo.end() )
+            plugin.EditDo.push_back( it.first );
+    }
+
+    LOG( "Added plugin ... %s%s%s", name.c_str(),
+         plugin.EditIf.empty() ? "" : (" : " + TextGetJoined( plugin.EditIf, ", " ) ).c_str(),
+         plugin.EditDo.empty() ? "" : (" : " + TextGetJoined( plugin.EditDo, ", " ) ).c_str() );
+
+    Plugins.push_back( plugin );
+
+    return true;
+}
+
+void ReDefine::UnloadPlugin( Plugin& plugin )
+{
+    // actions added or replaced by plugin are dropped together with their flags;
+    // plugins are unloaded in reverse order, so each one restores state left by previous plugin
+
+    if( plugin.Restore )
+    {
+        EditIf = std::move( plugin.PreviousEditIf );
+        EditDo = std::move( plugin.PreviousEditDo );
+        EditCache = std::move( plugin.PreviousEditCache );
+        EditCounter = std::move( plugin.PreviousEditCounter );
+        EditIfPure = std::move( plugin.PreviousEditIfPure );
+        EditIfUnordered = std::move( plugin.PreviousEditIfUnordered );
+
+        plugin.Restore = false;
+    }
+
+    plugin.EditIf.clear();
+    plugin.EditDo.clear();
+
+    if( plugin.Handle )
+    {
+        PluginClose( plugin.Handle );
+        plugin.Handle = nullptr;
+    }
+}
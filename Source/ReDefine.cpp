@@ -1,9 +1,27 @@
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#if defined (_WIN32)
+# include <io.h>
+#else
+# include <dirent.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
 
 #include "Ini.h"
+#include "Uring.h"
 
 #include "ReDefine.h"
 
@@ -34,6 +52,22 @@ void ReDefine::SStatus::SProcess::Clear()
     Counters.clear();
 }
 
+void ReDefine::SStatus::SProcess::Add( const SProcess& other )
+{
+    Files += other.Files;
+    Lines += other.Lines;
+    FilesChanges += other.FilesChanges;
+    LinesChanges += other.LinesChanges;
+
+    for( const auto& counter : other.Counters )
+    {
+        for( const auto& value : counter.second )
+        {
+            Counters[counter.first][value.first] += value.second;
+        }
+    }
+}
+
 //
 
 void ReDefine::SStatus::Clear()
@@ -44,13 +78,29 @@ void ReDefine::SStatus::Clear()
 
 //
 
+static std::atomic<uint64_t> Instances( 0 );
+
 ReDefine::ReDefine() :
     Config( nullptr ),
     Dev( false ),
     LogFile( "ReDefine.log" ),
     LogWarning( "ReDefine.WARNING.log" ),
     LogDebug( "ReDefine.DEBUG.log" ),
+    ScriptsPipeline( 16 ),
+    ScriptsExtensions( { ".ssl" } ),
+    ScriptsShard( 0 ),
+    ScriptsShards( 0 ),
+    ScriptsShardBySize( false ),
+    Instance( ++Instances ),
+    FunctionsLookup( nullptr ),
+    LogRecord( nullptr ),
+    LogWriter( nullptr ),
+    EditSharedSlots( 0 ),
+    EditAdaptive( false ),
+    EditBatchSlots( 0 ),
+    EditBatch( false ),
     DebugChanges( ScriptDebugChanges::NONE ),
+    Durability( ScriptDurability::NONE ),
     UseParser( false ),
     ScriptFormattingForced( false ),
     ScriptFormattingUnix( false ),
@@ -83,12 +133,14 @@ void ReDefine::Finish()
         Config = nullptr;
     }
 
+    LogWriterStop();
     Status.Clear();
 
     // extern cleanup
     FinishDefines();
     FinishFunctions();
     FinishOperators();
+    FinishPlugins();
     FinishRaw();
     FinishScript();
     FinishVariables();
@@ -108,6 +160,97 @@ void ReDefine::RemoveLogs()
         std::filesystem::remove( LogDebug );
 }
 
+// counters
+
+int32_t ReDefine::GetCounterSlot( const std::string& name )
+{
+    auto it = std::find( CounterSlots.begin(), CounterSlots.end(), name );
+    if( it == CounterSlots.end() )
+        it = CounterSlots.insert( CounterSlots.end(), name );
+
+    return static_cast<int32_t>(std::distance( CounterSlots.begin(), it ) );
+}
+
+// each thread uses own store, so counting never waits for other threads
+// stores are kept until object is destroyed, as thread might want to count again after flushing
+ReDefine::CountersStore& ReDefine::GetCountersStore()
+{
+    thread_local uint64_t       owner = 0;
+    thread_local CountersStore* store = nullptr;
+
+    if( owner != Instance )
+    {
+        std::lock_guard<std::mutex> lock( CountersLock );
+
+        store = &CountersStores[std::this_thread::get_id()];
+        owner = Instance;
+    }
+
+    return *store;
+}
+
+// name is used only if slot is not valid (for example, counters used by plugins)
+void ReDefine::Count( const int32_t slot, const std::string& name, const std::string& value )
+{
+    CountersStore& store = GetCountersStore();
+
+    if( slot >= 0 && static_cast<size_t>(slot) < CounterSlots.size() )
+    {
+        if( store.Slots.size() < CounterSlots.size() )
+            store.Slots.resize( CounterSlots.size() );
+
+        store.Slots[slot][value]++;
+    }
+    else
+        store.Names[name][value]++;
+
+    store.Dirty = true;
+}
+
+void ReDefine::CountUnknown( const std::string& type, const std::string& value )
+{
+    auto it = CounterUnknownSlots.find( type );
+    if( it != CounterUnknownSlots.end() )
+        Count( it->second, std::string(), value );
+    else
+        Count( -1, "!Unknown " + type + "!", value );
+}
+
+// adds counters of current thread to status
+void ReDefine::FlushCounters()
+{
+    CountersStore& store = GetCountersStore();
+
+    if( !store.Dirty )
+        return;
+
+    for( size_t slot = 0; slot < store.Slots.size(); slot++ )
+    {
+        if( store.Slots[slot].empty() )
+            continue;
+
+        auto& counter = Status.Process.Counters[CounterSlots[slot]];
+        for( const auto& value : store.Slots[slot] )
+        {
+            counter[value.first] += value.second;
+        }
+
+        store.Slots[slot].clear();
+    }
+
+    for( const auto& name : store.Names )
+    {
+        auto& counter = Status.Process.Counters[name.first];
+        for( const auto& value : name.second )
+        {
+            counter[value.first] += value.second;
+        }
+    }
+
+    store.Names.clear();
+    store.Dirty = false;
+}
+
 // files reading
 
 bool ReDefine::ReadFile( const std::string& filename, std::vector<std::string>& lines )
@@ -164,6 +307,60 @@ bool ReDefine::ReadFile( const std::string& filename, std::vector<std::string>&
     return result;
 }
 
+// removes bom from file content
+static void SkipBom( std::vector<char>& data )
+{
+    if( data.size() >= 3 && data[0] == static_cast<char>(0xEF) && data[1] == static_cast<char>(0xBB) && data[2] == static_cast<char>(0xBF) )
+        data.erase( data.begin(), data.begin() + 3 );
+}
+
+// reads whole file, skipping bom
+// does not report any problems, so it can be used outside of main thread
+static bool LoadFile( const std::string& filename, std::vector<char>& data )
+{
+    data.clear();
+
+    std::error_code error;
+    if( !std::filesystem::exists( filename, error ) )
+        return false;
+
+    // don't waste time on empty files
+    if( std::filesystem::is_empty( filename, error ) && !error )
+        return true;
+
+    std::ifstream fstream;
+    fstream.open( filename, std::ios_base::in | std::ios_base::binary );
+
+    if( !fstream.is_open() )
+        return false;
+
+    // https://stackoverflow.com/a/22986486/11998612
+    fstream.ignore( std::numeric_limits<std::streamsize>::max() );
+    std::streamsize size = fstream.gcount();
+    fstream.clear();
+    fstream.seekg( 0, std::ios_base::beg );
+
+    if( size >= 3 )
+    {
+        // skip bom
+        char bom[3] = { 0, 0, 0 };
+        fstream.read( bom, sizeof(bom) );
+        if( bom[0] != static_cast<char>(0xEF) || bom[1] != static_cast<char>(0xBB) || bom[2] != static_cast<char>(0xBF) )
+            fstream.seekg( 0, std::ifstream::beg );
+        else
+        {
+            size -= 3;
+            if( !size )
+                return true;
+        }
+    }
+
+    data.resize( size );
+    fstream.read( &data[0], size );
+
+    return true;
+}
+
 bool ReDefine::ReadFile( const std::string& filename, std::vector<char>& data )
 {
     data.clear();
@@ -175,48 +372,127 @@ bool ReDefine::ReadFile( const std::string& filename, std::vector<char>& data )
         return false;
     }
 
-    // don't waste time on empty files
-    if( std::filesystem::is_empty( file ) )
-        return true;
+    bool result = LoadFile( file, data );
+    if( !result )
+        WARNING( nullptr, "cannot read file<%s>", file.c_str() );
 
-    std::ifstream fstream;
-    fstream.open( file, std::ios_base::in | std::ios_base::binary );
+    return result;
+}
+
+// flushes file content to disk
+static bool SyncFile( std::FILE* file )
+{
+    if( std::fflush( file ) != 0 )
+        return false;
+
+    #if defined (_WIN32)
+    return _commit( _fileno( file ) ) == 0;
+    #else
+    return fsync( fileno( file ) ) == 0;
+    #endif
+}
+
+// flushes directory entries to disk, so renamed file is not lost after crash
+// not needed (nor possible) on Windows
+static void SyncDirectory( const std::string& directory )
+{
+    #if !defined (_WIN32)
+    int fd = open( directory.empty() ? "." : directory.c_str(), O_RDONLY );
+    if( fd >= 0 )
+    {
+        fsync( fd );
+        close( fd );
+    }
+    #else
+    (void)directory;
+    #endif
+}
+
+// shards running at same time can write same file (config cache, scripts manifest, etc.), and each one uses own temporary file
+std::string ReDefine::GetTemporaryFilename( const std::string& filename )
+{
+    if( ScriptsShards > 1 )
+        return filename + ".shard" + std::to_string( ScriptsShard ) + ".tmp";
+
+    return filename + ".tmp";
+}
+
+// replaces file in one go, so interrupted run never leaves broken file
+// if sync is set, new content is flushed to disk before returning
+bool ReDefine::WriteFile( const std::string& filename, const char* data, const size_t size, const bool sync /* = false */ )
+{
+    const std::string temporary = GetTemporaryFilename( filename );
+    std::error_code   error;
+
+    std::FILE*        file = std::fopen( temporary.c_str(), "wb" );
+    if( !file )
+        return false;
+
+    bool result = (!size || std::fwrite( data, 1, size, file ) == size) && std::fflush( file ) == 0;
+    if( result && sync )
+        result = SyncFile( file );
+
+    result = std::fclose( file ) == 0 && result;
 
-    bool result = fstream.is_open();
     if( result )
     {
-        // https://stackoverflow.com/a/22986486/11998612
-        fstream.ignore( std::numeric_limits<std::streamsize>::max() );
-        std::streamsize size = fstream.gcount();
-        fstream.clear();
-        fstream.seekg( 0, std::ios_base::beg );
+        std::filesystem::rename( temporary, filename, error );
+        result = !error;
+    }
 
-        if( size >= 3 )
-        {
-            // skip bom
-            char bom[3] = { 0, 0, 0 };
-            fstream.read( bom, sizeof(bom) );
-            if( bom[0] != static_cast<char>(0xEF) || bom[1] != static_cast<char>(0xBB) || bom[2] != static_cast<char>(0xBF) )
-                fstream.seekg( 0, std::ifstream::beg );
-            else
-            {
-                size -= 3;
-                if( !size )
-                    return true;
-            }
-        }
+    if( !result )
+    {
+        std::filesystem::remove( temporary, error );
+        return false;
+    }
+
+    if( sync )
+        SyncDirectory( std::filesystem::path( filename ).parent_path().string() );
+
+    return true;
+}
+
+// flushes all scripts written without syncing; see ScriptDurability::BATCH
+void ReDefine::SyncScripts()
+{
+    std::set<std::string> directories;
 
-        data.resize( size );
-        fstream.read( &data[0], size );
+    for( const std::string& filename : ScriptsUnsynced )
+    {
+        std::FILE* file = std::fopen( filename.c_str(), "r+b" );
+        if( !file || !SyncFile( file ) )
+            WARNING( __FUNCTION__, "cannot sync file<%s>", filename.c_str() );
+
+        if( file )
+            std::fclose( file );
+
+        directories.insert( std::filesystem::path( filename ).parent_path().string() );
     }
-    else
-        WARNING( nullptr, "cannot read file<%s>", file.c_str() );
 
-    return result;
+    for( const std::string& directory : directories )
+    {
+        SyncDirectory( directory );
+    }
+
+    ScriptsUnsynced.clear();
 }
 
-bool ReDefine::ReadConfig( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script )
+bool ReDefine::ReadConfig( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script, const std::string& plugins )
 {
+    // plugins needs to be loaded before reading script edits, as they can add new actions
+    if( !plugins.empty() && !ReadConfigPlugins( plugins ) )
+        return false;
+
+    // validated config is reused as long as config content, and actions added by plugins, didn't change since cache was saved
+    // note that warnings about invalid settings are only shown when cache is rebuilt
+    uint64_t hash = 0;
+    if( !ConfigCache.empty() )
+    {
+        hash = GetConfigHash( defines, variablePrefix, functionPrefix, raw, script );
+        if( ReadConfigCache( defines, variablePrefix, functionPrefix, raw, script, hash ) )
+            return true;
+    }
+
     if( !defines.empty() && !ReadConfigDefines( defines ) )
         return false;
 
@@ -232,183 +508,1327 @@ bool ReDefine::ReadConfig( const std::string& defines, const std::string& variab
     if( !script.empty() && !ReadConfigScript( script ) )
         return false;
 
+    if( !ConfigCache.empty() && !SaveConfigCache( defines, variablePrefix, functionPrefix, raw, script, hash ) )
+        WARNING( __FUNCTION__, "cannot save config cache<%s>", ConfigCache.c_str() );
+
     return true;
 }
 
-// files processing
+//
+// config cache
+//
+// keeps internal structures created by ReadConfig*(), so config doesn't need to be validated again if it didn't change since previous run
+// only sections which are read by ReadConfig() are stored; all numbers are stored in native byte order
+//
+// format:
+//   char     magic[8]
+//   uint32_t version
+//   uint64_t hash      ; GetConfigHash()
+//   ...                ; content of sections in same order as ReadConfig() reads them
+//
 
-void ReDefine::ProcessHeaders( const std::string& path )
+static constexpr char     ConfigCacheMagic[8] = { 'R', 'e', 'D', 'e', 'f', 'C', 'f', 'g' };
+static constexpr uint32_t ConfigCacheVersion = 2;
+
+// used by config cache and scripts manifest
+struct CacheWriter
 {
-    // move program defines to function scope
-    DefinesMap programDefines = ProgramDefines;
-    ProgramDefines.clear();
+    std::string Data;
 
-    // don't give up if there's something wrong with path - defines can be added via config, and replacements might still work
-    // additionally, it allows config-only setup, which might be a good idea in case main application wants to parse headers on its own and add them to config
-    // (which isn't such a bad idea - current headers reader is quite bad, as it doesn't understand /* long comments */ yet)
-    if( path.empty() )
-        WARNING( __FUNCTION__, "headers path is empty" );
-    else if( !std::filesystem::exists( path ) )
-        WARNING( __FUNCTION__, "headers path<%s> does not exists", path.c_str() );
-    else if( !std::filesystem::is_directory( path ) )
-        WARNING( __FUNCTION__, "headers path<%s> is not a directory", path.c_str() );
-    else
+    template<typename T>
+    void Put( const T value )
+    {
+        static_assert( std::is_arithmetic_v<T>);
+        Data.append( reinterpret_cast<const char*>(&value), sizeof(value) );
+    }
+
+    void PutStr( const std::string& value )
+    {
+        Put<uint32_t>( static_cast<uint32_t>(value.size() ) );
+        Data.append( value );
+    }
+
+    void PutStrVec( const std::vector<std::string>& values )
     {
-        for( const auto& header : Headers )
+        Put<uint32_t>( static_cast<uint32_t>(values.size() ) );
+        for( const auto& value : values )
         {
-            ProcessHeader( path, header );
+            PutStr( value );
         }
     }
 
-    // won't need that until next ReadConfig()/ReadConfigDefines() call
-    Headers.clear();
-
-    // restore program defines
-    // if type has been added by header, put it in RegularDefines (possibly overriding value from header),
-    // otherwise, use ProgramDefines
-    for( const auto& itProg : programDefines )
+    void PutStrMap( const std::map<std::string, std::string>& values )
     {
-        std::string            type = itProg.first, group;
-        std::string::size_type pos = type.find_first_of( ':' );
-        if( pos != std::string::npos )
+        Put<uint32_t>( static_cast<uint32_t>(values.size() ) );
+        for( const auto& value : values )
         {
-            group = type.substr( pos + 1 );
-            type.erase( pos );
+            PutStr( value.first );
+            PutStr( value.second );
         }
+    }
 
-        auto itRegular = RegularDefines.find( type );
-        bool isRegular = IsRegularDefineType( type );
+    void PutStrVecMap( const ReDefine::StringVectorMap& values )
+    {
+        Put<uint32_t>( static_cast<uint32_t>(values.size() ) );
+        for( const auto& value : values )
+        {
+            PutStr( value.first );
+            PutStrVec( value.second );
+        }
+    }
 
-        if( !isRegular && !group.empty() )
+    void PutDefines( const ReDefine::DefinesMap& defines )
+    {
+        Put<uint32_t>( static_cast<uint32_t>(defines.size() ) );
+        for( const auto& type : defines )
         {
-            auto itVirtual = VirtualDefines.find( group );
-            if( itVirtual != VirtualDefines.end() )
-            {
-                if( std::find( itVirtual->second.begin(), itVirtual->second.end(), type ) == itVirtual->second.end() )
-                {
-                    LOG( "Added %s +> %s", type.c_str(), group.c_str() ); // existing
-                    itVirtual->second.push_back( type );
-                }
-            }
-            else
+            PutStr( type.first );
+            Put<uint32_t>( static_cast<uint32_t>(type.second.size() ) );
+            for( const auto& define : type.second )
             {
-                LOG( "Added %s +> %s", type.c_str(), group.c_str() ); // new
-                VirtualDefines[group].push_back( type );
+                Put<int32_t>( define.first );
+                PutStr( define.second );
             }
         }
+    }
 
-        for( const auto& itVal : itProg.second )
+    void PutFunctions( const std::map<std::string, ReDefine::FunctionProto>& functions )
+    {
+        Put<uint32_t>( static_cast<uint32_t>(functions.size() ) );
+        for( const auto& function : functions )
         {
-            if( isRegular )
-                itRegular->second[itVal.first] = itVal.second;
-            else
-                ProgramDefines[type][itVal.first] = itVal.second;
-
-            LOG( "Added %s define ... %s = %d", type.c_str(), itVal.second.c_str(), itVal.first );
+            PutStr( function.first );
+            PutStr( function.second.ReturnType );
+            PutStrVec( function.second.ArgumentsTypes );
         }
     }
 
-    std::map<std::string, std::string>   validVariables;
-    std::map<std::string, FunctionProto> validFunctions;
-
-    // validate variables configuration
-    // virtual ? types are not valid for variables
-
-    for( const auto& var : VariablesPrototypes )
+    void PutActions( const std::vector<ReDefine::ScriptEdit::Action>& actions )
     {
-        if( !IsDefineType( var.second ) )
+        Put<uint32_t>( static_cast<uint32_t>(actions.size() ) );
+        for( const auto& action : actions )
         {
-            WARNING( __FUNCTION__, "unknown define type<%s> : variable<%s>", var.second.c_str(), var.first.c_str() );
-            continue;
+            PutStr( action.Name );
+            PutStrVec( action.Values );
+            Put<uint8_t>( action.Negate );
+            Put<int32_t>( action.CacheSlot );
+            Put<int32_t>( action.CounterSlot );
+            Put<int32_t>( action.SharedSlot );
         }
-
-        LOG( "Added variable ... [%s] %s", var.second.c_str(), var.first.c_str() );
-        validVariables[var.first] = var.second;
     }
 
-
-    // validate functions configuration
-    // virtual ? types are valid for functions
-
-    for( const auto& func : FunctionsPrototypes )
+    void PutEdits( const std::map<uint32_t, std::vector<ReDefine::ScriptEdit>>& edits )
     {
-        bool     valid = true;
-        uint32_t argument = 0;
-
-        if( !IsMysteryDefineType( func.second.ReturnType ) && !IsDefineType( func.second.ReturnType ) )
+        Put<uint32_t>( static_cast<uint32_t>(edits.size() ) );
+        for( const auto& priority : edits )
         {
-            WARNING( __FUNCTION__, "unknown define type<%s> : function<%s> return type", func.second.ReturnType.c_str(), func.first.c_str() );
-            valid = false;
+            Put<uint32_t>( priority.first );
+            Put<uint32_t>( static_cast<uint32_t>(priority.second.size() ) );
+            for( const auto& edit : priority.second )
+            {
+                Put<uint8_t>( edit.Debug );
+                PutStr( edit.Name );
+                Put<int32_t>( edit.BatchSlot );
+                PutActions( edit.Conditions );
+                PutActions( edit.Results );
+            }
         }
+    }
 
-        for( const auto& type : func.second.ArgumentsTypes )
+    void PutCounters( const ReDefine::CountersMap& counters )
+    {
+        Put<uint32_t>( static_cast<uint32_t>(counters.size() ) );
+        for( const auto& counter : counters )
         {
-            argument++;
-            if( !IsMysteryDefineType( type ) && !IsDefineType( type ) )
+            PutStr( counter.first );
+            Put<uint32_t>( static_cast<uint32_t>(counter.second.size() ) );
+            for( const auto& value : counter.second )
             {
-                WARNING( __FUNCTION__, "unknown define type<%s> : function<%s> argument<%u>", type.c_str(), func.first.c_str(), argument );
-                valid = false;
+                PutStr( value.first );
+                Put<uint32_t>( value.second );
             }
         }
+    }
+
+    void PutMessages( const std::vector<ReDefine::LogMessage>& messages )
+    {
+        Put<uint32_t>( static_cast<uint32_t>(messages.size() ) );
+        for( const auto& message : messages )
+        {
+            Put<uint8_t>( static_cast<uint8_t>(message.Type) );
+            PutStr( message.Text );
+        }
+    }
+};
+
+// every Get*() returns false if data is truncated
+struct CacheReader
+{
+    const std::vector<char>& Data;
+    size_t                   Pos = 0;
+
+    CacheReader( const std::vector<char>& data ) : Data( data )
+    {}
+
+    template<typename T>
+    bool Get( T& value )
+    {
+        static_assert( std::is_arithmetic_v<T>);
+        if( Data.size() - Pos < sizeof(value) )
+            return false;
+
+        std::memcpy( &value, &Data[Pos], sizeof(value) );
+        Pos += sizeof(value);
+
+        return true;
+    }
+
+    bool GetBool( bool& value )
+    {
+        uint8_t val = 0;
+        if( !Get( val ) )
+            return false;
+
+        value = val != 0;
+        return true;
+    }
+
+    // minimum is number of bytes used by single element; sizes which cannot fit in remaining data are rejected,
+    // so broken file never causes huge allocations
+    bool GetSize( size_t& size, const size_t minimum = 1 )
+    {
+        uint32_t val = 0;
+        if( !Get( val ) || (minimum && val > (Data.size() - Pos) / minimum) )
+            return false;
+
+        size = val;
+        return true;
+    }
+
+    bool GetStr( std::string& value )
+    {
+        size_t size = 0;
+        if( !GetSize( size ) || Data.size() - Pos < size )
+            return false;
+
+        value.assign( Data.data() + Pos, size );
+        Pos += size;
+
+        return true;
+    }
+
+    bool GetStrVec( std::vector<std::string>& values )
+    {
+        size_t size = 0;
+        if( !GetSize( size, sizeof(uint32_t) ) )
+            return false;
+
+        values.resize( size );
+        for( auto& value : values )
+        {
+            if( !GetStr( value ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetStrMap( std::map<std::string, std::string>& values )
+    {
+        size_t size = 0;
+        if( !GetSize( size, sizeof(uint32_t) * 2 ) )
+            return false;
+
+        for( size_t v = 0; v < size; v++ )
+        {
+            std::string name;
+            if( !GetStr( name ) || !GetStr( values[name] ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetDefines( ReDefine::DefinesMap& defines )
+    {
+        size_t types = 0;
+        if( !GetSize( types, sizeof(uint32_t) * 2 ) )
+            return false;
+
+        for( size_t t = 0; t < types; t++ )
+        {
+            std::string type;
+            size_t      size = 0;
+            if( !GetStr( type ) || !GetSize( size, sizeof(int32_t) + sizeof(uint32_t) ) )
+                return false;
+
+            auto& map = defines[type];
+            for( size_t d = 0; d < size; d++ )
+            {
+                int32_t value = 0;
+                if( !Get( value ) || !GetStr( map[value] ) )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool GetFunctions( std::map<std::string, ReDefine::FunctionProto>& functions )
+    {
+        size_t size = 0;
+        if( !GetSize( size, sizeof(uint32_t) * 3 ) )
+            return false;
+
+        for( size_t f = 0; f < size; f++ )
+        {
+            std::string name;
+            if( !GetStr( name ) )
+                return false;
+
+            ReDefine::FunctionProto& function = functions[name];
+            if( !GetStr( function.ReturnType ) || !GetStrVec( function.ArgumentsTypes ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetActions( std::vector<ReDefine::ScriptEdit::Action>& actions )
+    {
+        size_t size = 0;
+        if( !GetSize( size, sizeof(uint32_t) * 2 + sizeof(uint8_t) + sizeof(int32_t) * 3 ) )
+            return false;
+
+        actions.resize( size );
+        for( auto& action : actions )
+        {
+            if( !GetStr( action.Name ) || !GetStrVec( action.Values ) || !GetBool( action.Negate ) || !Get( action.CacheSlot ) || !Get( action.CounterSlot ) || !Get( action.SharedSlot ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    bool GetEdits( std::map<uint32_t, std::vector<ReDefine::ScriptEdit>>& edits )
+    {
+        size_t priorities = 0;
+        if( !GetSize( priorities, sizeof(uint32_t) * 2 ) )
+            return false;
+
+        for( size_t p = 0; p < priorities; p++ )
+        {
+            uint32_t priority = 0;
+            size_t   size = 0;
+            if( !Get( priority ) || !GetSize( size, sizeof(uint8_t) + sizeof(uint32_t) + sizeof(int32_t) + sizeof(uint32_t) * 2 ) )
+                return false;
+
+            auto& vec = edits[priority];
+            vec.resize( size );
+            for( auto& edit : vec )
+            {
+                if( !GetBool( edit.Debug ) || !GetStr( edit.Name ) || !Get( edit.BatchSlot ) || !GetActions( edit.Conditions ) || !GetActions( edit.Results ) )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool GetCounters( ReDefine::CountersMap& counters )
+    {
+        size_t names = 0;
+        if( !GetSize( names, sizeof(uint32_t) * 2 ) )
+            return false;
+
+        for( size_t n = 0; n < names; n++ )
+        {
+            std::string name;
+            size_t      size = 0;
+            if( !GetStr( name ) || !GetSize( size, sizeof(uint32_t) * 2 ) )
+                return false;
+
+            auto& map = counters[name];
+            for( size_t v = 0; v < size; v++ )
+            {
+                std::string value;
+                if( !GetStr( value ) || !Get( map[value] ) )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool GetMessages( std::vector<ReDefine::LogMessage>& messages )
+    {
+        size_t size = 0;
+        if( !GetSize( size, sizeof(uint8_t) + sizeof(uint32_t) ) )
+            return false;
+
+        messages.resize( size );
+        for( auto& message : messages )
+        {
+            uint8_t type = 0;
+            if( !Get( type ) || type > static_cast<uint8_t>(ReDefine::LogType::DEBUG) || !GetStr( message.Text ) )
+                return false;
+
+            message.Type = static_cast<ReDefine::LogType>(type);
+        }
+
+        return true;
+    }
+};
+
+uint64_t ReDefine::GetConfigHash( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script )
+{
+    CacheWriter key;
+    key.Put( ConfigCacheVersion );
+
+    for( const auto& name : { defines, variablePrefix, functionPrefix, raw, script } )
+    {
+        key.PutStr( name );
+    }
+
+    // whole config is used, as sections read by ReadConfig*() are selected by prefix
+    std::vector<std::string> sections;
+    Config->GetSections( sections );
+    for( const auto& section : sections )
+    {
+        std::vector<std::string> keys, ordered;
+        Config->GetSectionKeys( section, keys );
+        Config->GetSectionKeys( section, ordered, true );
+
+        key.PutStr( section );
+        key.PutStrVec( ordered );
+        for( const auto& name : keys )
+        {
+            key.PutStr( name );
+            key.PutStr( Config->GetStr( section, name ) );
+        }
+    }
+
+    // actions added by plugins can change the way edits are stored
+    for( const auto& it : EditIf )
+    {
+        key.PutStr( it.first );
+    }
+    for( const auto& it : EditDo )
+    {
+        key.PutStr( it.first );
+    }
+    for( const auto& it : EditCache )
+    {
+        key.PutStr( it.first );
+        key.Put( it.second );
+    }
+    for( const auto& it : EditCounter )
+    {
+        key.PutStr( it.first );
+        key.Put( it.second );
+    }
+    for( const auto& name : EditIfPure )
+    {
+        key.PutStr( name );
+    }
+
+    return TextGetHash( key.Data );
+}
+
+bool ReDefine::ReadConfigCache( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script, const uint64_t hash )
+{
+    if( !std::filesystem::exists( ConfigCache ) )
+        return false;
+
+    std::vector<char> data;
+    if( !ReadFile( ConfigCache, data ) || data.size() < sizeof(ConfigCacheMagic) || std::memcmp( data.data(), ConfigCacheMagic, sizeof(ConfigCacheMagic) ) != 0 )
+        return false;
+
+    CacheReader reader( data );
+    reader.Pos = sizeof(ConfigCacheMagic);
+
+    uint32_t version = 0;
+    uint64_t cacheHash = 0;
+    if( !reader.Get( version ) || version != ConfigCacheVersion || !reader.Get( cacheHash ) || cacheHash != hash )
+        return false;
+
+    // read everything into temporary object, so broken cache doesn't leave any traces
+    ReDefine cache;
+    bool     result = true;
+
+    if( result && !defines.empty() )
+    {
+        size_t headers = 0;
+        result = reader.GetSize( headers, sizeof(uint32_t) * 6 );
+        for( size_t h = 0; result && h < headers; h++ )
+        {
+            std::vector<std::string> values;
+            result = reader.GetStrVec( values ) && values.size() == 5;
+            if( result )
+                cache.Headers.emplace_back( values[0], values[1], values[2], values[3], values[4] );
+        }
+
+        result = result && reader.GetDefines( cache.ProgramDefines );
+    }
+
+    if( result && !variablePrefix.empty() )
+    {
+        result = reader.GetStrMap( cache.VariablesPrototypes ) && reader.GetStrVec( cache.VariablesGuessing );
+    }
+
+    if( result && !functionPrefix.empty() )
+    {
+        result = reader.GetFunctions( cache.FunctionsPrototypes );
+    }
+
+    if( result && !raw.empty() )
+    {
+        result = reader.GetStrMap( cache.Raw );
+    }
+
+    if( result && !script.empty() )
+    {
+        result = reader.GetStrVec( cache.EditCacheSlots ) && reader.GetStrVec( cache.CounterSlots ) && reader.Get( cache.EditSharedSlots ) && reader.Get( cache.EditBatchSlots ) &&
+                 reader.GetEdits( cache.EditBefore ) && reader.GetEdits( cache.EditAfter ) && reader.GetEdits( cache.EditOnDemand );
+    }
+
+    if( !result || reader.Pos != data.size() )
+    {
+        WARNING( __FUNCTION__, "config cache<%s> is broken", ConfigCache.c_str() );
+        return false;
+    }
+
+    // same cleanup as done by ReadConfig*()
+
+    if( !defines.empty() )
+    {
+        FinishDefines();
+        Headers.swap( cache.Headers );
+        ProgramDefines.swap( cache.ProgramDefines );
+    }
+
+    if( !variablePrefix.empty() )
+    {
+        FinishVariables();
+        VariablesPrototypes.swap( cache.VariablesPrototypes );
+        VariablesGuessing.swap( cache.VariablesGuessing );
+    }
+
+    if( !functionPrefix.empty() )
+    {
+        FinishFunctions();
+        FunctionsPrototypes.swap( cache.FunctionsPrototypes );
+    }
+
+    if( !raw.empty() )
+    {
+        FinishRaw();
+        Raw.swap( cache.Raw );
+    }
+
+    if( !script.empty() )
+    {
+        FinishScript( false );
+        EditCacheSlots.swap( cache.EditCacheSlots );
+        CounterSlots.swap( cache.CounterSlots );
+        EditSharedSlots = cache.EditSharedSlots;
+        EditBatchSlots = cache.EditBatchSlots;
+        EditBefore.swap( cache.EditBefore );
+        EditAfter.swap( cache.EditAfter );
+        EditOnDemand.swap( cache.EditOnDemand );
+    }
+
+    LOG( "Config loaded from cache<%s>", ConfigCache.c_str() );
+
+    return true;
+}
+
+bool ReDefine::SaveConfigCache( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script, const uint64_t hash )
+{
+    CacheWriter writer;
+    writer.Data.append( ConfigCacheMagic, sizeof(ConfigCacheMagic) );
+    writer.Put( ConfigCacheVersion );
+    writer.Put( hash );
+
+    if( !defines.empty() )
+    {
+        writer.Put<uint32_t>( static_cast<uint32_t>(Headers.size() ) );
+        for( const Header& header : Headers )
+        {
+            writer.PutStrVec( { header.Filename, header.Type, header.Prefix, header.Suffix, header.Group } );
+        }
+
+        writer.PutDefines( ProgramDefines );
+    }
+
+    if( !variablePrefix.empty() )
+    {
+        writer.PutStrMap( VariablesPrototypes );
+        writer.PutStrVec( VariablesGuessing );
+    }
+
+    if( !functionPrefix.empty() )
+    {
+        writer.PutFunctions( FunctionsPrototypes );
+    }
+
+    if( !raw.empty() )
+    {
+        writer.PutStrMap( Raw );
+    }
+
+    if( !script.empty() )
+    {
+        writer.PutStrVec( EditCacheSlots );
+        writer.PutStrVec( CounterSlots );
+        writer.Put( EditSharedSlots );
+        writer.Put( EditBatchSlots );
+        writer.PutEdits( EditBefore );
+        writer.PutEdits( EditAfter );
+        writer.PutEdits( EditOnDemand );
+    }
+
+    return WriteFile( ConfigCache, writer.Data.data(), writer.Data.size() );
+}
+
+// files processing
+
+void ReDefine::ProcessHeaders( const std::string& path )
+{
+    // move program defines to function scope
+    DefinesMap programDefines = ProgramDefines;
+    ProgramDefines.clear();
+
+    // don't give up if there's something wrong with path - defines can be added via config, and replacements might still work
+    // additionally, it allows config-only setup, which might be a good idea in case main application wants to parse headers on its own and add them to config
+    // (which isn't such a bad idea - current headers reader is quite bad, as it doesn't understand /* long comments */ yet)
+    if( path.empty() )
+        WARNING( __FUNCTION__, "headers path is empty" );
+    else if( !std::filesystem::exists( path ) )
+        WARNING( __FUNCTION__, "headers path<%s> does not exists", path.c_str() );
+    else if( !std::filesystem::is_directory( path ) )
+        WARNING( __FUNCTION__, "headers path<%s> is not a directory", path.c_str() );
+    else
+    {
+        ProcessHeadersDefines( path );
+    }
+
+    // won't need that until next ReadConfig()/ReadConfigDefines() call
+    Headers.clear();
+
+    // restore program defines
+    // if type has been added by header, put it in RegularDefines (possibly overriding value from header),
+    // otherwise, use ProgramDefines
+    for( const auto& itProg : programDefines )
+    {
+        std::string            type = itProg.first, group;
+        std::string::size_type pos = type.find_first_of( ':' );
+        if( pos != std::string::npos )
+        {
+            group = type.substr( pos + 1 );
+            type.erase( pos );
+        }
+
+        auto itRegular = RegularDefines.find( type );
+        bool isRegular = IsRegularDefineType( type );
+
+        if( !isRegular && !group.empty() )
+        {
+            auto itVirtual = VirtualDefines.find( group );
+            if( itVirtual != VirtualDefines.end() )
+            {
+                if( std::find( itVirtual->second.begin(), itVirtual->second.end(), type ) == itVirtual->second.end() )
+                {
+                    LOG( "Added %s +> %s", type.c_str(), group.c_str() ); // existing
+                    itVirtual->second.push_back( type );
+                }
+            }
+            else
+            {
+                LOG( "Added %s +> %s", type.c_str(), group.c_str() ); // new
+                VirtualDefines[group].push_back( type );
+            }
+        }
+
+        for( const auto& itVal : itProg.second )
+        {
+            if( isRegular )
+                itRegular->second[itVal.first] = itVal.second;
+            else
+                ProgramDefines[type][itVal.first] = itVal.second;
+
+            LOG( "Added %s define ... %s = %d", type.c_str(), itVal.second.c_str(), itVal.first );
+        }
+    }
+
+    std::map<std::string, std::string>   validVariables;
+    std::map<std::string, FunctionProto> validFunctions;
+
+    // validate variables configuration
+    // virtual ? types are not valid for variables
+
+    for( const auto& var : VariablesPrototypes )
+    {
+        if( !IsDefineType( var.second ) )
+        {
+            WARNING( __FUNCTION__, "unknown define type<%s> : variable<%s>", var.second.c_str(), var.first.c_str() );
+            continue;
+        }
+
+        LOG( "Added variable ... [%s] %s", var.second.c_str(), var.first.c_str() );
+        validVariables[var.first] = var.second;
+    }
+
+
+    // validate functions configuration
+    // virtual ? types are valid for functions
+
+    for( const auto& func : FunctionsPrototypes )
+    {
+        bool     valid = true;
+        uint32_t argument = 0;
+
+        if( !IsMysteryDefineType( func.second.ReturnType ) && !IsDefineType( func.second.ReturnType ) )
+        {
+            WARNING( __FUNCTION__, "unknown define type<%s> : function<%s> return type", func.second.ReturnType.c_str(), func.first.c_str() );
+            valid = false;
+        }
+
+        for( const auto& type : func.second.ArgumentsTypes )
+        {
+            argument++;
+            if( !IsMysteryDefineType( type ) && !IsDefineType( type ) )
+            {
+                WARNING( __FUNCTION__, "unknown define type<%s> : function<%s> argument<%u>", type.c_str(), func.first.c_str(), argument );
+                valid = false;
+            }
+        }
+
+        if( !valid )
+            continue;
 
-        if( !valid )
-            continue;
-
         LOG( "Added function ... [%s] %s(%s)", func.second.ReturnType.c_str(), func.first.c_str(), std::string( func.second.ArgumentsTypes.empty() ? "" : " " + TextGetJoined( func.second.ArgumentsTypes, ", " ) + " " ).c_str() );
         validFunctions[func.first] = func.second;
     }
 
-    for( const auto& type : VariablesGuessing )
+    for( const auto& type : VariablesGuessing )
+    {
+        if( !IsDefineType( type ) )
+        {
+            WARNING( __FUNCTION__, "unknown define type<%s> : guessing", type.c_str() );
+            VariablesGuessing.clear(); // zero tolerance policy
+            break;
+        }
+    }
+
+    if( !VariablesGuessing.empty() )
+        LOG( "Added guessing ... %s", TextGetJoined( VariablesGuessing, ", " ).c_str() );
+
+    // keep valid settings only
+    VariablesPrototypes = validVariables;
+    FunctionsPrototypes = validFunctions;
+
+    // log raw replacement
+    for( const auto& from : Raw )
+    {
+        LOG( "Added raw ... %s", from.first.c_str() );
+    }
+
+    // counters of unknown values are using same slots for all scripts
+    CounterUnknownSlots.clear();
+    for( const auto& type : RegularDefines )
+    {
+        CounterUnknownSlots[type.first] = GetCounterSlot( "!Unknown " + type.first + "!" );
+    }
+    for( const auto& type : ProgramDefines )
+    {
+        CounterUnknownSlots[type.first] = GetCounterSlot( "!Unknown " + type.first + "!" );
+    }
+    for( const auto& type : VirtualDefines )
+    {
+        CounterUnknownSlots[type.first] = GetCounterSlot( "!Unknown " + type.first + "!" );
+    }
+
+    // remove script editing which cannot be completed with current functions prototypes and defines
+    ProcessScriptEditDead();
+
+    // log script editing
+
+    for( const auto& it : EditBefore )
+    {
+        for( const ScriptEdit& before : it.second )
+        {
+            LOG( "Added preprocess action ... %s", before.Name.c_str() );
+        }
+    }
+
+    for( const auto& it : EditAfter )
+    {
+        for( const ScriptEdit& after : it.second )
+        {
+            LOG( "Added postprocess action ... %s", after.Name.c_str() );
+        }
+    }
+
+    for( const auto& it : EditOnDemand )
+    {
+        for( const ScriptEdit& demand : it.second )
+        {
+            LOG( "Added on-demand action ... %s", demand.Name.c_str() );
+        }
+    }
+}
+
+//
+// scripts discovery
+//
+// directories are walked by all workers at once; each worker takes single directory from queue, and queues all subdirectories found
+// excluded directories are never queued, so their content is never read
+//
+
+bool ReDefine::IsScript( const std::string& script, const bool directory /* = false */ )
+{
+    const std::string name = TextGetReplaced( script, "\\", "/" );
+
+    for( const auto& glob : ScriptsExclude )
+    {
+        if( TextIsGlobMatch( name, glob ) || (directory && TextIsGlobMatch( name + "/", glob ) ) )
+            return false;
+    }
+
+    // includes are checked against scripts only, as any directory might contain selected scripts
+    if( directory )
+        return true;
+
+    // walking scripts directory never reaches scripts inside excluded directories, but such scripts still can be selected explicitly
+    for( size_t pos = name.find( '/' ); !ScriptsExclude.empty() && pos != std::string::npos; pos = name.find( '/', pos + 1 ) )
     {
-        if( !IsDefineType( type ) )
+        if( !IsScript( name.substr( 0, pos ), true ) )
+            return false;
+    }
+
+    const size_t dot = name.find_last_of( "./" );
+    if( dot == std::string::npos || name[dot] != '.' )
+        return false;
+
+    const std::string extension = TextGetLower( name.substr( dot ) );
+    if( std::find( ScriptsExtensions.begin(), ScriptsExtensions.end(), extension ) == ScriptsExtensions.end() )
+        return false;
+
+    if( ScriptsInclude.empty() )
+        return true;
+
+    for( const auto& glob : ScriptsInclude )
+    {
+        if( TextIsGlobMatch( name, glob ) )
+            return true;
+    }
+
+    return false;
+}
+
+struct ScriptsWalk
+{
+    std::mutex               Lock;
+    std::condition_variable  Wait;
+    std::deque<std::string>  Directories;
+    uint32_t                 Busy = 0;
+    std::vector<std::string> Scripts;
+};
+
+// lists single directory; names are relative to scripts directory, using '/' as separator
+static void ListScripts( ReDefine* root, const std::string& path, const std::string& directory, std::vector<std::string>& directories, std::vector<std::string>& scripts )
+{
+    const std::string full = directory.empty() ? path : path + "/" + directory;
+
+    #if defined (_WIN32)
+    std::error_code ec;
+    for( const auto& entry : std::filesystem::directory_iterator( full, ec ) )
+    {
+        const std::string name = entry.path().filename().string();
+        const std::string relative = directory.empty() ? name : directory + "/" + name;
+
+        // file type is cached by iterator, no extra calls needed
+        if( entry.is_directory( ec ) && !entry.is_symlink( ec ) )
         {
-            WARNING( __FUNCTION__, "unknown define type<%s> : guessing", type.c_str() );
-            VariablesGuessing.clear(); // zero tolerance policy
-            break;
+            if( root->IsScript( relative, true ) )
+                directories.push_back( relative );
         }
+        else if( entry.is_regular_file( ec ) && root->IsScript( relative ) )
+            scripts.push_back( relative );
     }
+    #else
+    DIR* dir = opendir( full.c_str() );
+    if( !dir )
+        return;
 
-    if( !VariablesGuessing.empty() )
-        LOG( "Added guessing ... %s", TextGetJoined( VariablesGuessing, ", " ).c_str() );
+    const int fd = dirfd( dir );
+    while( const dirent* entry = readdir( dir ) )
+    {
+        const std::string name = entry->d_name;
+        if( name == "." || name == ".." )
+            continue;
 
-    // keep valid settings only
-    VariablesPrototypes = validVariables;
-    FunctionsPrototypes = validFunctions;
+        const std::string relative = directory.empty() ? name : directory + "/" + name;
+        bool              isDirectory = entry->d_type == DT_DIR, isFile = entry->d_type == DT_REG;
 
-    // log raw replacement
-    for( const auto& from : Raw )
+        // stat is used only if filesystem doesn't report entry type; symlinks to files are followed, symlinks to directories are not
+        struct stat st;
+        if( entry->d_type == DT_UNKNOWN && fstatat( fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW ) == 0 )
+        {
+            isDirectory = S_ISDIR( st.st_mode );
+            isFile = S_ISREG( st.st_mode );
+        }
+        else if( entry->d_type == DT_LNK && fstatat( fd, entry->d_name, &st, 0 ) == 0 )
+            isFile = S_ISREG( st.st_mode );
+
+        if( isDirectory )
+        {
+            if( root->IsScript( relative, true ) )
+                directories.push_back( relative );
+        }
+        else if( isFile && root->IsScript( relative ) )
+            scripts.push_back( relative );
+    }
+
+    closedir( dir );
+    #endif
+}
+
+static void WalkScripts( ReDefine* root, const std::string* path, ScriptsWalk* walk )
+{
+    std::vector<std::string> directories, scripts;
+
+    while( true )
     {
-        LOG( "Added raw ... %s", from.first.c_str() );
+        std::string directory;
+        {
+            std::unique_lock<std::mutex> lock( walk->Lock );
+
+            // queue can be refilled as long as any worker is still listing directory
+            while( walk->Directories.empty() && walk->Busy )
+            {
+                walk->Wait.wait( lock );
+            }
+
+            if( walk->Directories.empty() )
+                break;
+
+            directory = std::move( walk->Directories.front() );
+            walk->Directories.pop_front();
+            walk->Busy++;
+        }
+
+        directories.clear();
+        ListScripts( root, *path, directory, directories, scripts );
+
+        {
+            std::lock_guard<std::mutex> lock( walk->Lock );
+
+            walk->Directories.insert( walk->Directories.end(), directories.begin(), directories.end() );
+            walk->Busy--;
+        }
+
+        walk->Wait.notify_all();
     }
 
-    // log script editing
+    std::lock_guard<std::mutex> lock( walk->Lock );
+    walk->Scripts.insert( walk->Scripts.end(), scripts.begin(), scripts.end() );
+}
 
-    for( const auto& it : EditBefore )
+void ReDefine::GetScripts( const std::string& path, std::vector<std::string>& scripts )
+{
+    ScriptsWalk walk;
+    walk.Directories.push_back( "" );
+
+    const uint32_t           workers = std::clamp<uint32_t>( std::thread::hardware_concurrency(), 1, 8 );
+    std::vector<std::thread> threads;
+
+    for( uint32_t idx = 1; idx < workers; idx++ )
     {
-        for( const ScriptEdit& before : it.second )
+        threads.emplace_back( WalkScripts, this, &path, &walk );
+    }
+
+    WalkScripts( this, &path, &walk );
+
+    for( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    scripts = std::move( walk.Scripts );
+    std::sort( scripts.begin(), scripts.end() );
+
+    #if defined (_WIN32)
+    for( auto& script : scripts )
+    {
+        std::replace( script.begin(), script.end(), '/', '\\' );
+    }
+    #endif
+}
+
+// selects part of scripts processed by current shard
+// sorted scripts list is split in contiguous ranges, with (nearly) equal number of scripts or, if enabled, equal total size of scripts
+void ReDefine::GetScriptsShard( const std::string& path, const std::vector<std::string>& scripts, std::vector<std::string>& shard )
+{
+    if( ScriptsShards <= 1 || !ScriptsShard || ScriptsShard > ScriptsShards )
+    {
+        shard = scripts;
+        return;
+    }
+
+    shard.clear();
+
+    const uint64_t        shards = ScriptsShards, current = ScriptsShard - 1;
+    std::vector<uint64_t> weights( scripts.size(), 1 );
+    uint64_t              total = 0;
+
+    // empty and missing files still have some weight, so they are always spread between shards
+    if( ScriptsShardBySize )
+    {
+        for( size_t idx = 0; idx < scripts.size(); idx++ )
         {
-            LOG( "Added preprocess action ... %s", before.Name.c_str() );
+            std::error_code ec;
+            const uintmax_t size = std::filesystem::file_size( TextGetFilename( path, scripts[idx] ), ec );
+
+            weights[idx] += ec ? 0 : size;
         }
     }
 
-    for( const auto& it : EditAfter )
+    for( const uint64_t weight : weights )
     {
-        for( const ScriptEdit& after : it.second )
+        total += weight;
+    }
+
+    // script belongs to shard containing its midpoint
+    for( size_t idx = 0, position = 0; idx < scripts.size(); idx++ )
+    {
+        const uint64_t middle = position * 2 + weights[idx];
+
+        if( std::min( middle * shards / (total * 2), shards - 1 ) == current )
+            shard.push_back( scripts[idx] );
+
+        position += weights[idx];
+    }
+}
+
+//
+// scripts manifest
+//
+// keeps result of processing each script, so scripts which didn't change since previous run can be skipped;
+// counters and log messages of skipped scripts are replayed, so summary and logfiles looks same as if scripts were processed
+//
+// whole manifest is ignored if rules (validated config, defines found in headers, settings affecting scripts content) changed;
+// scripts which needed changes are always processed again, unless both runs are using read-only mode
+//
+// format:
+//   char     magic[8]
+//   uint32_t version
+//   uint64_t rules     ; GetScriptsManifestRules()
+//   uint32_t scripts
+//   ...                ; filename + ScriptManifest, for each script
+//
+
+static constexpr char     ScriptsManifestMagic[8] = { 'R', 'e', 'D', 'e', 'f', 'M', 'f', 't' };
+static constexpr uint32_t ScriptsManifestVersion = 1;
+
+struct ScriptManifest
+{
+    uint64_t                          Hash = 0;  // script content
+    bool                              ReadOnly = false;
+    bool                              Changed = false;
+    ReDefine::SStatus::SProcess       Process;   // changes made to ReDefine::Status::Process while processing script
+    std::vector<ReDefine::LogMessage> Messages;
+};
+
+typedef std::map<std::string, ScriptManifest> ScriptsManifestMap;
+
+static uint64_t GetScriptsManifestRules( ReDefine* root, const std::string& path )
+{
+    CacheWriter key;
+    key.Put( ScriptsManifestVersion );
+    key.PutStr( path );
+
+    key.PutDefines( root->RegularDefines );
+    key.PutDefines( root->ProgramDefines );
+    key.PutStrVecMap( root->VirtualDefines );
+    key.PutStrMap( root->VariablesPrototypes );
+    key.PutStrVec( root->VariablesGuessing );
+    key.PutFunctions( root->FunctionsPrototypes );
+    key.PutStrMap( root->Raw );
+    key.PutStrVec( root->EditCacheSlots );
+    key.PutEdits( root->EditBefore );
+    key.PutEdits( root->EditAfter );
+    key.PutEdits( root->EditOnDemand );
+
+    key.Put( static_cast<uint8_t>(root->DebugChanges) );
+    key.Put( static_cast<uint8_t>(root->UseParser) );
+    key.Put( static_cast<uint8_t>(root->ScriptFormatting) );
+    key.Put( static_cast<uint8_t>(root->ScriptFormattingForced) );
+    key.Put( static_cast<uint8_t>(root->ScriptFormattingUnix) );
+
+    // plugins can change behaviour of actions without changing their names
+    for( const ReDefine::Plugin& plugin : root->Plugins )
+    {
+        std::error_code error;
+        key.PutStr( plugin.Filename );
+        key.Put( static_cast<uint64_t>(std::filesystem::file_size( plugin.Filename, error ) ) );
+        key.Put( static_cast<int64_t>(std::filesystem::last_write_time( plugin.Filename, error ).time_since_epoch().count() ) );
+    }
+
+    return root->TextGetHash( key.Data );
+}
+
+static bool LoadScriptsManifest( ReDefine* root, const std::string& filename, const uint64_t rules, ScriptsManifestMap& manifest )
+{
+    if( !std::filesystem::exists( filename ) )
+        return false;
+
+    std::vector<char> data;
+    if( !root->ReadFile( filename, data ) || data.size() < sizeof(ScriptsManifestMagic) || std::memcmp( data.data(), ScriptsManifestMagic, sizeof(ScriptsManifestMagic) ) != 0 )
+        return false;
+
+    CacheReader reader( data );
+    reader.Pos = sizeof(ScriptsManifestMagic);
+
+    uint32_t version = 0;
+    uint64_t manifestRules = 0;
+    size_t   scripts = 0;
+    if( !reader.Get( version ) || version != ScriptsManifestVersion || !reader.Get( manifestRules ) || manifestRules != rules || !reader.GetSize( scripts, sizeof(uint32_t) ) )
+        return false;
+
+    for( size_t s = 0; s < scripts; s++ )
+    {
+        std::string    script;
+        ScriptManifest entry;
+
+        if( !reader.GetStr( script ) || !reader.Get( entry.Hash ) || !reader.GetBool( entry.ReadOnly ) || !reader.GetBool( entry.Changed ) ||
+            !reader.Get( entry.Process.Files ) || !reader.Get( entry.Process.Lines ) || !reader.Get( entry.Process.FilesChanges ) || !reader.Get( entry.Process.LinesChanges ) ||
+            !reader.GetCounters( entry.Process.Counters ) || !reader.GetMessages( entry.Messages ) )
         {
-            LOG( "Added postprocess action ... %s", after.Name.c_str() );
+            manifest.clear();
+            return false;
         }
+
+        manifest[script] = std::move( entry );
     }
 
-    for( const auto& it : EditOnDemand )
+    return true;
+}
+
+static bool SaveScriptsManifest( ReDefine* root, const std::string& filename, const uint64_t rules, const ScriptsManifestMap& manifest )
+{
+    CacheWriter writer;
+    writer.Data.append( ScriptsManifestMagic, sizeof(ScriptsManifestMagic) );
+    writer.Put( ScriptsManifestVersion );
+    writer.Put( rules );
+    writer.Put<uint32_t>( static_cast<uint32_t>(manifest.size() ) );
+
+    for( const auto& it : manifest )
     {
-        for( const ScriptEdit& demand : it.second )
+        const ScriptManifest& entry = it.second;
+
+        writer.PutStr( it.first );
+        writer.Put( entry.Hash );
+        writer.Put<uint8_t>( entry.ReadOnly );
+        writer.Put<uint8_t>( entry.Changed );
+        writer.Put( entry.Process.Files );
+        writer.Put( entry.Process.Lines );
+        writer.Put( entry.Process.FilesChanges );
+        writer.Put( entry.Process.LinesChanges );
+        writer.PutCounters( entry.Process.Counters );
+        writer.PutMessages( entry.Messages );
+    }
+
+    return root->WriteFile( filename, writer.Data.data(), writer.Data.size() );
+}
+
+// processes loaded script, or replays result of processing it in previous run
+static void ProcessScriptManifest( ReDefine* root, const std::string& script, const std::vector<char>& data, const bool readOnly, ScriptsManifestMap& manifest, ScriptsManifestMap& manifestUpdate, const std::function<bool()>& process )
+{
+    ScriptManifest entry;
+
+    entry.Hash = root->TextGetHash( data.data(), data.size() );
+    entry.ReadOnly = readOnly;
+
+    auto it = manifest.find( script );
+    if( it != manifest.end() && it->second.Hash == entry.Hash && (!it->second.Changed || (readOnly && it->second.ReadOnly) ) )
+    {
+        root->Status.Process.Add( it->second.Process );
+        root->LogReplay( it->second.Messages );
+
+        manifestUpdate[script] = std::move( it->second );
+        return;
+    }
+
+    // record everything added by ProcessScript() to status and logs
+    std::vector<ReDefine::LogMessage>* record = root->LogRecord;
+    std::swap( entry.Process, root->Status.Process );
+    root->LogRecord = &entry.Messages;
+
+    entry.Changed = process();
+
+    root->LogRecord = record;
+    std::swap( entry.Process, root->Status.Process );
+
+    root->Status.Process.Add( entry.Process );
+    if( record )
+        record->insert( record->end(), entry.Messages.begin(), entry.Messages.end() );
+
+    manifestUpdate[script] = std::move( entry );
+}
+
+// bounded queue connecting scripts processing stages; Push() waits if queue is full
+// capacity 0 means unbounded queue
+template<typename T>
+class ScriptsQueue
+{
+protected:
+    std::mutex              Lock;
+    std::condition_variable Changed;
+    std::deque<T>           Items;
+    const size_t            Capacity;
+    bool                    Closed;
+
+public:
+    ScriptsQueue( size_t capacity ) : Capacity( capacity ), Closed( false )
+    {}
+
+    void Push( T&& item )
+    {
+        std::unique_lock<std::mutex> lock( Lock );
+        Changed.wait( lock, [this] () { return !Capacity || Items.size() < Capacity || Closed; } );
+
+        Items.push_back( std::move( item ) );
+        Changed.notify_all();
+    }
+
+    // waits for next item; returns false if queue is closed and empty
+    bool Pop( T& item )
+    {
+        std::unique_lock<std::mutex> lock( Lock );
+        Changed.wait( lock, [this] () { return !Items.empty() || Closed; } );
+
+        if( Items.empty() )
+            return false;
+
+        item = std::move( Items.front() );
+        Items.pop_front();
+        Changed.notify_all();
+
+        return true;
+    }
+
+    bool TryPop( T& item )
+    {
+        std::unique_lock<std::mutex> lock( Lock );
+        if( Items.empty() )
+            return false;
+
+        item = std::move( Items.front() );
+        Items.pop_front();
+        Changed.notify_all();
+
+        return true;
+    }
+
+    void Close()
+    {
+        std::unique_lock<std::mutex> lock( Lock );
+        Closed = true;
+        Changed.notify_all();
+    }
+};
+
+struct ScriptRead
+{
+    std::string       Filename; // relative to scripts directory
+    bool              Loaded = false;
+    std::vector<char> Data;
+};
+
+struct ScriptWrite
+{
+    std::string                       Filename; // full path
+    std::string                       Content;
+    uint32_t                          Changes = 0;
+    bool                              Saved = false;
+
+    uint64_t                          Sequence = 0;
+    std::vector<ReDefine::LogMessage> Messages; // captured when processing script; committed after script is saved
+};
+
+// reader stage of scripts pipeline
+// if possible, scripts are read in batches using io_uring; scripts which cannot be read that way are read in usual way
+static void ReadScripts( ReDefine* root, Uring* uring, const std::string& path, const std::vector<std::string>& scripts, ScriptsQueue<ScriptRead>& reads )
+{
+    const size_t                   batch = std::max<size_t>( 1, root->ScriptsPipeline );
+
+    std::vector<std::string>       filenames;
+    std::vector<std::vector<char>> data;
+    std::vector<bool>              loaded;
+
+    for( size_t first = 0; first < scripts.size(); first += batch )
+    {
+        const size_t last = std::min( scripts.size(), first + batch );
+
+        filenames.clear();
+        for( size_t idx = first; idx < last; idx++ )
         {
-            LOG( "Added on-demand action ... %s", demand.Name.c_str() );
+            filenames.push_back( root->TextGetFilename( path, scripts[idx] ) );
+        }
+
+        uring->Read( filenames, data, loaded );
+
+        for( size_t idx = first; idx < last; idx++ )
+        {
+            ScriptRead input;
+            input.Filename = scripts[idx];
+
+            if( loaded[idx - first] )
+            {
+                input.Data = std::move( data[idx - first] );
+                input.Loaded = true;
+                SkipBom( input.Data );
+            }
+            else
+                input.Loaded = LoadFile( filenames[idx - first], input.Data );
+
+            reads.Push( std::move( input ) );
         }
     }
+
+    reads.Close();
+}
+
+// writer stage of scripts pipeline; results are reported back to main thread
+static void WriteScripts( ReDefine* root, ScriptsQueue<ScriptWrite>& writes, ScriptsQueue<ScriptWrite>& saved )
+{
+    ScriptWrite output;
+    while( writes.Pop( output ) )
+    {
+        output.Saved = root->WriteFile( output.Filename, output.Content.data(), output.Content.size(), root->Durability == ReDefine::ScriptDurability::FILE );
+        output.Content.clear();
+
+        saved.Push( std::move( output ) );
+    }
+
+    saved.Close();
 }
 
+//
+
 void ReDefine::ProcessScripts( const std::string& path, const bool readOnly /* = false */ )
+{
+    std::vector<std::string> scripts;
+    if( std::filesystem::is_directory( path ) )
+        GetScripts( path, scripts );
+
+    ProcessScripts( path, scripts, readOnly );
+}
+
+// processes given scripts only; names are relative to scripts directory
+void ReDefine::ProcessScripts( const std::string& path, const std::vector<std::string>& selection, const bool readOnly /* = false */ )
 {
     if( path.empty() )
     {
@@ -426,26 +1846,165 @@ void ReDefine::ProcessScripts( const std::string& path, const bool readOnly /* =
         return;
     }
 
-    LOG( "Process scripts%s ...", readOnly ? " (read only)" : "" );
-
     std::vector<std::string> scripts;
+    GetScriptsShard( path, selection, scripts );
+
+    if( ScriptsShards > 1 )
+        LOG( "Process scripts%s ... shard %u/%u (%u of %u scripts)", readOnly ? " (read only)" : "", ScriptsShard, ScriptsShards, static_cast<uint32_t>(scripts.size() ), static_cast<uint32_t>(selection.size() ) );
+    else
+        LOG( "Process scripts%s ...", readOnly ? " (read only)" : "" );
 
-    for( const auto& file : std::filesystem::recursive_directory_iterator( path ) )
+    uint64_t           rules = 0;
+    ScriptsManifestMap manifest, manifestUpdate;
+    if( !ScriptsManifest.empty() )
     {
-        if( !std::filesystem::is_regular_file( file ) ) // TODO? symlinks
-            continue;
+        rules = GetScriptsManifestRules( this, path );
+        LoadScriptsManifest( this, ScriptsManifest, rules, manifest );
+    }
 
-        if( TextGetLower( file.path().extension().string() ) != ".ssl" )
-            continue;
+    // processes loaded script; returns true if script needs to be written
+    auto process = [&] ( ScriptRead& input, ScriptWrite& output ) -> bool {
+                       ScriptResult result;
+
+                       auto         processLoaded = [&] () {
+                                                        return ProcessScript( path, input.Filename, input.Data, result, readOnly );
+                                                    };
+
+                       // problems with reading script are reported by ProcessScript()
+                       if( !input.Loaded )
+                           ProcessScript( path, input.Filename, readOnly );
+                       else if( ScriptsManifest.empty() )
+                           processLoaded();
+                       else
+                           ProcessScriptManifest( this, input.Filename, input.Data, readOnly, manifest, manifestUpdate, processLoaded );
+
+                       if( EditAdaptive )
+                           ProcessScriptEditAdaptive();
+
+                       if( result.Content.empty() )
+                           return false;
+
+                       output.Filename = TextGetFilename( path, input.Filename );
+                       output.Content = std::move( result.Content );
+                       output.Changes = static_cast<uint32_t>(result.Changes.size() );
+
+                       return true;
+                   };
+
+    // messages about saving script are added to messages of processing it
+    auto save = [&] ( ScriptWrite& output ) {
+                    LogCapture( &output.Messages );
+                    SaveScript( output.Filename, output.Changes, output.Saved );
+                    LogCapture( nullptr );
+                    LogCommit( output.Sequence, output.Messages );
+                };
+
+    // reading and writing scripts is done in separate threads, while main thread keeps processing
+    // messages of each script are written in scripts order, so logs are identical to serial processing
+    if( ScriptsPipeline && !UseParser )
+    {
+        ScriptsQueue<ScriptRead>  reads( ScriptsPipeline );
+        ScriptsQueue<ScriptWrite> writes( ScriptsPipeline ), saved( 0 );
+
+        Uring                     uring;
+        if( uring.Init( ScriptsPipeline * 2 ) && Dev )
+            DEBUG( __FUNCTION__, "using io_uring" );
+
+        LogWriterStart();
+
+        std::thread reader( ReadScripts, this, &uring, std::cref( path ), std::cref( scripts ), std::ref( reads ) );
+        std::thread writer( WriteScripts, this, std::ref( writes ), std::ref( saved ) );
+
+        ScriptRead  input;
+        ScriptWrite output;
+
+        for( uint64_t sequence = 0; reads.Pop( input ); sequence++ )
+        {
+            while( saved.TryPop( output ) )
+            {
+                save( output );
+            }
+
+            std::vector<LogMessage> messages;
 
-        scripts.push_back( file.path().string().substr( path.length(), file.path().string().length() - path.length() ) );
-        scripts.back().erase( 0, scripts.back().find_first_not_of( "\\/" ) );  // trim left
+            LogCapture( &messages );
+            const bool changed = process( input, output );
+            LogCapture( nullptr );
+
+            if( changed )
+            {
+                output.Sequence = sequence;
+                output.Messages = std::move( messages );
+                writes.Push( std::move( output ) );
+            }
+            else
+                LogCommit( sequence, messages );
+        }
+
+        writes.Close();
+
+        reader.join();
+        writer.join();
+
+        while( saved.Pop( output ) )
+        {
+            save( output );
+        }
     }
+    else
+    {
+        LogWriterStart();
 
-    std::sort( scripts.begin(), scripts.end() );
+        for( uint64_t sequence = 0; sequence < scripts.size(); sequence++ )
+        {
+            ScriptRead  input;
+            ScriptWrite output;
 
-    for( auto& script : scripts )
+            input.Filename = scripts[sequence];
+            input.Loaded = LoadFile( TextGetFilename( path, input.Filename ), input.Data );
+
+            LogCapture( &output.Messages );
+            if( process( input, output ) )
+                SaveScript( output.Filename, output.Changes, WriteFile( output.Filename, output.Content.data(), output.Content.size(), Durability == ScriptDurability::FILE ) );
+            LogCapture( nullptr );
+
+            LogCommit( sequence, output.Messages );
+        }
+    }
+
+    LogWriterStop();
+
+    // flush changed scripts before manifest, so manifest never claims unsaved changes
+    SyncScripts();
+
+    // scripts which weren't selected for this run are kept in manifest, unless they no longer exists
+    if( !ScriptsManifest.empty() )
     {
-        ProcessScript( path, script, readOnly );
+        // other shards might save manifest in meantime; their entries replaces ones loaded before processing
+        // entries saved by other shard between loading and replacing manifest are lost, and such scripts are processed again by next run
+        if( ScriptsShards > 1 )
+        {
+            ScriptsManifestMap saved;
+            LoadScriptsManifest( this, ScriptsManifest, rules, saved );
+
+            for( auto& it : saved )
+            {
+                if( manifestUpdate.find( it.first ) == manifestUpdate.end() )
+                    manifest[it.first] = std::move( it.second );
+            }
+        }
+
+        for( auto& it : manifest )
+        {
+            std::error_code error;
+            if( manifestUpdate.find( it.first ) == manifestUpdate.end() && std::filesystem::is_regular_file( TextGetFilename( path, it.first ), error ) )
+                manifestUpdate[it.first] = std::move( it.second );
+        }
+
+        if( !SaveScriptsManifest( this, ScriptsManifest, rules, manifestUpdate ) )
+            WARNING( __FUNCTION__, "cannot save scripts manifest<%s>", ScriptsManifest.c_str() );
     }
+
+    if( EditAdaptive )
+        LogScriptEditAdaptive();
 }
@@ -3,19 +3,53 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <regex>
+#include <set>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 class Ini;
 
+//
+// plugins
+//
+// shared libraries listed in config must export (with C linkage, see REDEFINE_PLUGIN_EXPORT) following functions:
+//
+//   uint32_t ReDefinePluginVersion();            must return REDEFINE_PLUGIN_VERSION used when building plugin
+//   bool     ReDefinePluginInit( ReDefine* );    adds new script edit actions to ReDefine::EditIf / ReDefine::EditDo, and optionally
+//                                               ReDefine::EditCache / ReDefine::EditIfPure; returning false unloads plugin
+//
+// plugins may also replace existing actions; everything changed during ReDefinePluginInit() is reverted when plugin is unloaded
+//
+// plugins are built against same ReDefine.h as executable which loads them;
+// REDEFINE_PLUGIN_VERSION must be increased whenever ReDefine class layout or script edit actions signatures changes
+//
+// 1 - initial version
+// 2 - changed layout of ReDefine class (script batches, edit cache, manifest, defines expressions and others)
+// 3 - added ReDefine::FunctionsLookup
+// 4 - changed layout of ReDefine::ScriptBatch
+//
+
+#define REDEFINE_PLUGIN_VERSION    4
+
+#if defined (_WIN32)
+# define REDEFINE_PLUGIN_EXPORT    extern "C" __declspec( dllexport )
+#else
+# define REDEFINE_PLUGIN_EXPORT    extern "C" __attribute__( (visibility( "default" ) ) )
+#endif
+
 class ReDefine
 {
 public:
 
     struct ScriptCode;
     struct ScriptEditAction;
+    struct ScriptFile;
 
     //
     // misc maps
@@ -39,6 +73,23 @@ public:
     typedef std::function<ScriptEditReturn( ScriptEditAction&, const ScriptCode& )> ScriptEditIf;
     typedef std::function<ScriptEditReturn( ScriptEditAction&, ScriptCode& )>       ScriptEditDo;
 
+    // values stored by edit actions using CACHE
+    // names used in config are resolved to slots by ReadConfigScript(); names passed by other actions at runtime are kept by name
+    struct ScriptEditCache
+    {
+        std::vector<std::string>           Values; // <slot, value>
+        std::vector<uint8_t>               Stored; // <slot, value is set>
+        std::vector<int32_t>               Used;   // slots set since last Clear()
+        std::map<std::string, std::string> Named;  // <name, value>
+
+        void         Resize( const size_t size );
+        void         Clear();
+        bool         IsEmpty() const;
+        bool         IsStored( const int32_t slot, const std::string& name ) const;
+        std::string& Get( const int32_t slot, const std::string& name );
+        void         Set( const int32_t slot, const std::string& name, const std::string& value );
+    };
+
     //
     // ReDefine
     //
@@ -50,6 +101,29 @@ public:
     std::string LogWarning;
     std::string LogDebug;
 
+    // binary file keeping validated configuration between runs; empty filename disables it
+    std::string ConfigCache;
+
+    // binary file keeping results of processing scripts between runs; empty filename disables it
+    std::string ScriptsManifest;
+
+    // number of scripts read ahead and waiting for write when processing scripts; 0 disables reading/writing in separate threads
+    uint32_t ScriptsPipeline;
+
+    // extensions of files treated as scripts; lowercase, with leading dot
+    std::vector<std::string> ScriptsExtensions;
+
+    // glob patterns (relative to scripts directory) of scripts selected for processing; empty list selects all scripts
+    std::vector<std::string> ScriptsInclude;
+
+    // glob patterns (relative to scripts directory) of scripts and directories ignored when processing scripts; excluded directories are never walked into
+    std::vector<std::string> ScriptsExclude;
+
+    // processes only part of scripts (1..ScriptsShards), so single run can be split between multiple processes; 0 or 1 shards disables splitting
+    uint32_t ScriptsShard;
+    uint32_t ScriptsShards;
+    bool     ScriptsShardBySize;
+
     struct SStatus
     {
         struct SCurrent
@@ -80,7 +154,8 @@ public:
 
             SProcess();
 
-            void        Clear();
+            void Clear();
+            void Add( const SProcess& other );
         }
         Process;
 
@@ -96,12 +171,50 @@ public:
     void Finish();
     void RemoveLogs();
 
-    bool ReadFile( const std::string& filename, std::vector<std::string>& lines );
-    bool ReadFile( const std::string& filename, std::vector<char>& data );
-    bool ReadConfig( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script );
+    //
+    // counters
+    //
+
+    // hits are collected in hashed per-thread stores, and merged into (sorted) Status.Process.Counters by FlushCounters()
+    // counters names used by script edits are converted to slots when reading config, so counting doesn't need to create/compare names
+    struct CountersStore
+    {
+        bool                                                                       Dirty = false;
+        std::vector<std::unordered_map<std::string, uint32_t>>                     Slots; // <counter slot, <value, count>>
+        std::unordered_map<std::string, std::unordered_map<std::string, uint32_t>> Names; // <counter name, <value, count>>; counters without slot
+    };
+
+    std::vector<std::string>                 CounterSlots;                                // <slot, counter name>
+    std::unordered_map<std::string, int32_t> CounterUnknownSlots;                         // <define type, slot of "!Unknown TYPE!" counter>
+
+    int32_t GetCounterSlot( const std::string& name );
+    void    Count( const int32_t slot, const std::string& name, const std::string& value );
+    void    CountUnknown( const std::string& type, const std::string& value );
+    void    FlushCounters();
+
+    CountersStore& GetCountersStore();
+
+    uint64_t                                 Instance; // unique for each object; used to find store of current thread
+    std::mutex                               CountersLock;
+    std::map<std::thread::id, CountersStore> CountersStores;
+
+    std::string GetTemporaryFilename( const std::string& filename );
+
+    bool     ReadFile( const std::string& filename, std::vector<std::string>& lines );
+    bool     ReadFile( const std::string& filename, std::vector<char>& data );
+    bool     WriteFile( const std::string& filename, const char* data, const size_t size, const bool sync = false );
+    bool     ReadConfig( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script, const std::string& plugins );
+    bool     ReadConfigCache( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script, const uint64_t hash );
+    bool     SaveConfigCache( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script, const uint64_t hash );
+    uint64_t GetConfigHash( const std::string& defines, const std::string& variablePrefix, const std::string& functionPrefix, const std::string& raw, const std::string& script );
 
     void ProcessHeaders( const std::string& path );
     void ProcessScripts( const std::string& path, const bool readOnly = false );
+    void ProcessScripts( const std::string& path, const std::vector<std::string>& selection, const bool readOnly = false );
+
+    bool IsScript( const std::string& script, const bool directory = false );
+    void GetScripts( const std::string& path, std::vector<std::string>& scripts );
+    void GetScriptsShard( const std::string& path, const std::vector<std::string>& scripts, std::vector<std::string>& shard );
 
     //
     // Defines
@@ -126,6 +239,26 @@ public:
     DefinesMap          ProgramDefines; // <type, <value, names>>
     StringVectorMap     VirtualDefines; // <virtual_type, <types>>
 
+    // binary file keeping defines found in headers between runs; empty filename disables it
+    // implementation details are kept in Defines.cpp
+    struct HeadersSnapshot;
+    std::string DefinesSnapshot;
+
+    // result of evaluating expression used as define value
+    struct DefineExpression
+    {
+        bool    Valid = false;
+        bool    DivisionByZero = false;
+        int32_t Value = 0;
+    };
+
+    std::mutex                                                                         DefineExpressionsLock;
+    std::unordered_map<std::string, std::unordered_map<std::string, DefineExpression>> DefineExpressions; // <type, <expression, result>>
+
+    // defines found in single header, before they're added to maps above
+    // implementation details are kept in Defines.cpp
+    struct HeaderTable;
+
     void FinishDefines();
 
     bool ReadConfigDefines( const std::string& sectionPrefix );
@@ -136,7 +269,10 @@ public:
     bool GetDefineName( const std::string& type, const int value, std::string& result, const bool skipVirtual = false );
     bool GetDefineValue( const std::string& type, const std::string& value, int& result, const bool skipVirtual = false );
 
-    bool ProcessHeader( const std::string& path, const Header& header );
+    DefineExpression GetDefineExpression( const std::string& type, const std::string& expression );
+
+    void ProcessHeadersDefines( const std::string& path );
+    bool ProcessHeader( const std::string& path, const Header& header, HeadersSnapshot* snapshot = nullptr, HeaderTable* table = nullptr );
     bool ProcessValue( const std::string& type, std::string& value, const bool silent = false );
     void ProcessValueGuessing( std::string& value );
 
@@ -150,24 +286,58 @@ public:
         std::vector<std::string> ArgumentsTypes;
     };
 
+    typedef const FunctionProto* (* FunctionsLookupFunc)( const std::string& name );
+
     std::map<std::string, FunctionProto> FunctionsPrototypes;
+    FunctionsLookupFunc                  FunctionsLookup; // used instead of FunctionsPrototypes when searching for prototype, if set; see Generator/Generated.cpp
 
     void FinishFunctions();
 
     bool ReadConfigFunctions( const std::string& section );
 
+    const FunctionProto* GetFunctionProto( const std::string& name );
+
     void ProcessFunctionArguments( ScriptCode& function );
 
     //
     // Log
     //
 
+    enum class LogType : uint8_t
+    {
+        SHOW = 0,
+        LOG,
+        WARNING,
+        DEBUG
+    };
+
+    struct LogMessage
+    {
+        LogType     Type;
+        std::string Text;
+    };
+
+    std::vector<LogMessage>* LogRecord; // if set, all messages are additionally stored there, so they can be shown again with LogReplay()
+
     void DEBUG( const char* caller, const char* format, ... );
     void WARNING( const char* caller, const char* format, ... );
     void ILOG( const char* format, ... );
     void LOG( const char* format, ... );
     void SHOW( const char* format, ... );
 
+    void LogReplay( const std::vector<LogMessage>& messages );
+
+    // messages of each script can be captured by thread processing it, and written by separate thread in order of sequence numbers;
+    // used when processing scripts, so logfiles are identical regardless of which thread processed (or saved) which script
+    struct LogQueue;
+
+    LogQueue* LogWriter;
+
+    std::vector<LogMessage>* LogCapture( std::vector<LogMessage>* buffer );
+    void LogCommit( const uint64_t sequence, std::vector<LogMessage>& messages );
+    void LogWriterStart();
+    void LogWriterStop();
+
     //
     // Operators
     //
@@ -184,6 +354,41 @@ public:
 
     void ProcessOperator( const std::string& type, ScriptCode& code );
 
+    //
+    // Plugins
+    //
+
+    struct Plugin
+    {
+        std::string                         Name;
+        std::string                         Filename;
+        void*                               Handle;
+        bool                                Restore; // Previous* must be restored on unload
+
+        std::vector<std::string>            EditIf;  // names added by plugin
+        std::vector<std::string>            EditDo;  // names added by plugin
+
+        // script edit actions as they were before plugin initialization;
+        // restored when plugin is unloaded, so actions replaced by plugin never points to unloaded code
+        std::map<std::string, ScriptEditIf> PreviousEditIf;
+        std::map<std::string, ScriptEditDo> PreviousEditDo;
+        std::map<std::string, uint32_t>     PreviousEditCache;
+        std::map<std::string, uint32_t>     PreviousEditCounter;
+        std::set<std::string>               PreviousEditIfPure;
+        std::set<std::string>               PreviousEditIfUnordered;
+
+        Plugin();
+    };
+
+    std::vector<Plugin> Plugins;
+
+    void FinishPlugins();
+
+    bool ReadConfigPlugins( const std::string& section );
+
+    bool LoadPlugin( const std::string& name, const std::string& filename );
+    void UnloadPlugin( Plugin& plugin );
+
     //
     // Raw
     //
@@ -206,24 +411,32 @@ public:
         {
             std::string              Name;
             std::vector<std::string> Values;
-            bool                     Negate = false; // used by conditions only
+            bool                     Negate = false;   // used by conditions only
+            int32_t                  CacheSlot = -1;   // used by actions using CACHE only; set by ReadConfigScript()
+            int32_t                  CounterSlot = -1; // used by actions using counters only; set by ReadConfigScript()
+            int32_t                  SharedSlot = -1;  // used by conditions only; set by ReadConfigScript() if same condition is used by multiple edits
+
+            // used by conditions only; updated by ProcessScriptEdit() if adaptive conditions are enabled
+            uint64_t                 StatsCalls = 0;
+            uint64_t                 StatsPassed = 0;
+            uint64_t                 StatsTime = 0; // nanoseconds
         };
 
         struct External
         {
-            const std::string                   Name;
+            const std::string Name;
 
-            const bool                          RunConditions;
-            const bool                          RunResults;
+            const bool        RunConditions;
+            const bool        RunResults;
 
-            ScriptEditReturn                    ReturnConditions;
-            ScriptEditReturn                    ReturnResults;
+            ScriptEditReturn  ReturnConditions;
+            ScriptEditReturn  ReturnResults;
 
-            std::map<std::string, std::string>& Cache;
+            ScriptEditCache&  Cache;
 
 
             External();
-            External( const std::string& name, bool conditions, bool results, std::map<std::string, std::string>& cache );
+            External( const std::string& name, bool conditions, bool results, ScriptEditCache& cache );
 
             bool InUse();
         };
@@ -232,6 +445,7 @@ public:
 
         bool                Debug;
         std::string         Name;
+        int32_t             BatchSlot; // set by ReadConfigScript() for edits running before/after replacements
 
         std::vector<Action> Conditions;
         std::vector<Action> Results;
@@ -252,14 +466,16 @@ public:
             RESTART = 0x10  // set by DoRestart; forces restart of line processing keeping changes already made to code
         };
 
-        const std::string&                  Name;
-        const std::vector<std::string>&     Values;
+        const std::string&              Name;
+        const std::vector<std::string>& Values;
+        const int32_t                   CacheSlot;
+        const int32_t                   CounterSlot;
 
-        ReDefine*                           Root;
-        Flag&                               Flags;
-        std::map<std::string, std::string>& Cache;
+        ReDefine*                       Root;
+        Flag&                           Flags;
+        ScriptEditCache&                Cache;
 
-        ScriptEditAction( void*  root, const ScriptEdit::Action& action, ScriptEditAction::Flag& flags, std::map<std::string, std::string>& cache );
+        ScriptEditAction( void*  root, const ScriptEdit::Action& action, ScriptEditAction::Flag& flags, ScriptEditCache& cache );
 
         //
 
@@ -289,6 +505,12 @@ public:
             return ScriptEditReturn::Success;
         }
 
+        // must be validated with GetCACHE() before use
+        inline std::string& CacheValue( const uint32_t& val )
+        {
+            return Cache.Get( CacheSlot, Values[val] );
+        }
+
         //
 
         bool IsBefore( const char* caller ) const;
@@ -297,6 +519,7 @@ public:
         bool IsValues( const char* caller, const uint32_t& count ) const;
 
         bool GetCACHE( const char* caller, const uint32_t& val ) const;
+        bool SetCACHE( const char* caller, const uint32_t& val, const std::string& value );
         bool GetINDEX( const char* caller, const uint32_t& val, const ReDefine::ScriptCode& code, uint32_t& out ) const;
         bool GetTYPE( const char* caller, const uint32_t& val, bool allowUnknown = false ) const;
         bool GetUINT( const char* caller, const uint32_t& val, uint32_t& out, const std::string& name = "UINT" ) const;
@@ -310,11 +533,6 @@ public:
         ScriptEditReturn CallEditDo( ScriptCode& code, const std::string& name, std::vector<std::string> values = std::vector<std::string>() );
     };
 
-    struct ScriptFile
-    {
-        std::vector<std::string> Defines;
-    };
-
     struct ScriptCode
     {
         enum class Format : uint8_t
@@ -357,6 +575,7 @@ public:
 
         ReDefine*             Parent;
         ScriptFile*           File;
+        int32_t               Batch; // index in ScriptFile::Batch; set only for script code which wasn't changed since extraction
 
         // dynamic
 
@@ -401,6 +620,56 @@ public:
         void ChangeLog();
     };
 
+    // all script code extracted from file before processing, stored as structure of arrays
+    // used to check first condition of each edit for all script code at once
+    struct ScriptBatch
+    {
+        std::vector<std::vector<ScriptCode>> Extracted; // <line index, script code>; moved to ProcessScript() when line is processed
+        std::vector<std::vector<LogMessage>> Messages;  // <line index, messages logged during extraction>; replayed by ProcessScript() when line is processed
+
+        std::map<std::string, uint32_t>      Ids;       // <name/operator, id>
+        std::vector<uint32_t>                Name;      // <script code index, name id>
+        std::vector<uint32_t>                Operator;  // <script code index, operator id>
+        std::vector<uint8_t>                 Type;      // <script code index, ScriptCode::Flag::VARIABLE/FUNCTION>
+        std::vector<uint32_t>                Arity;     // <script code index, arguments count>
+
+        std::vector<std::vector<uint8_t>>    Run;       // <edit batch slot, <script code index, 0 if first condition fails>>
+
+        uint32_t                             GetId( const std::string& text );
+    };
+
+    struct ScriptFile
+    {
+        std::vector<std::string> Defines;
+        ScriptBatch              Batch;
+    };
+
+    struct ScriptChange
+    {
+        uint32_t    LineNumber;
+        std::string Before;
+        std::string After;
+    };
+
+    // result of ProcessBuffer()
+    struct ScriptResult
+    {
+        std::string               Content; // rewritten script; empty if script does not need changes
+        std::vector<ScriptChange> Changes;
+        SStatus::SProcess         Process; // status changes caused by processing script; already added to Status.Process
+    };
+
+    // controls flushing changed scripts to disk
+    enum class ScriptDurability : uint8_t
+    {
+        NONE = 0, // left to operating system
+        BATCH,    // all changed scripts are flushed at end of ProcessScripts()
+        FILE,     // each changed script is flushed right after writing
+
+        MIN  = NONE,
+        MAX  = FILE
+    };
+
     enum class ScriptDebugChanges : uint8_t
     {
         NONE = 0,
@@ -413,11 +682,22 @@ public:
 
     std::map<std::string, ScriptEditIf>         EditIf;
     std::map<std::string, ScriptEditDo>         EditDo;
+    std::map<std::string, uint32_t>             EditCache;       // <action name, CACHE value index>
+    std::vector<std::string>                    EditCacheSlots;  // <slot, cache name>
+    std::map<std::string, uint32_t>             EditCounter;     // <action name, counter name value index>
+    std::set<std::string>                       EditIfPure;      // <condition name>; conditions which results depends on script code only
+    uint32_t                                    EditSharedSlots;
+    std::set<std::string>                       EditIfUnordered; // <condition name>; conditions which can be evaluated in any order
+    bool                                        EditAdaptive;
+    uint32_t                                    EditBatchSlots;
+    bool                                        EditBatch;
     std::map<uint32_t, std::vector<ScriptEdit>> EditBefore;
     std::map<uint32_t, std::vector<ScriptEdit>> EditAfter;
     std::map<uint32_t, std::vector<ScriptEdit>> EditOnDemand;
 
     ScriptDebugChanges                          DebugChanges;
+    ScriptDurability                            Durability;
+    std::vector<std::string>                    ScriptsUnsynced; // <filename>; scripts written, but not flushed yet
     bool                                        UseParser;
     bool                                        ScriptFormattingForced;
     bool                                        ScriptFormattingUnix;
@@ -427,13 +707,25 @@ public:
     void FinishScript( bool finishCallbacks = true );
 
     bool ReadConfigScript( const std::string& sectionPrefix );
+    void ReadConfigScriptShared();
 
+    int32_t GetEditCacheSlot( const std::string& action, const std::vector<std::string>& values );
 
     //
 
-    void ProcessScript( const std::string& path, const std::string& filename, const bool readOnly = false );
+    bool ProcessScript( const std::string& path, const std::string& filename, const bool readOnly = false );                              // returns true if script content needs changes
+    bool ReadScript( const std::string& path, const std::string& filename, std::vector<char>& data );
+    bool ProcessScript( const std::string& path, const std::string& filename, const std::vector<char>& data, ScriptResult& result, const bool readOnly );
+    void SaveScript( const std::string& filename, const uint32_t changes, const bool saved );
+    void SyncScripts();
+    bool ProcessBuffer( const std::string_view& buffer, const std::string& filename, ScriptResult& result, const bool readOnly = false ); // returns true if script content needs changes
+    bool ProcessScriptLine( std::string& line, ScriptFile* file, bool batched = false );
     void ProcessScriptReplacements( ScriptCode& code, bool refresh = false );
-    void ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, const std::map<uint32_t, std::vector<ScriptEdit>>& edits, ScriptCode& code, bool& restart, ScriptEdit::External& external = ScriptEdit::ExternalDummy );
+    void ProcessScriptBatch( const std::vector<std::string>& lines, ScriptBatch& batch );
+    void ProcessScriptEditDead();
+    void ProcessScriptEditAdaptive();
+    void LogScriptEditAdaptive();
+    void ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, std::map<uint32_t, std::vector<ScriptEdit>>& edits, ScriptCode& code, bool& restart, ScriptEditCache& cache, ScriptEdit::External& external = ScriptEdit::ExternalDummy );
 
     //
     // Text
@@ -443,9 +735,14 @@ public:
     bool                     TextIsComment( const std::string& text );
     bool                     TextIsInt( const std::string& text );
     bool                     TextIsConflict( const std::string& text );
+    bool                     TextIsIgnored( const std::string& text );
+    bool                     TextIsGlobMatch( const std::string& text, const std::string& glob );
     std::string              TextGetFilename( const std::string& path, const std::string& filename );
+    uint64_t                 TextGetHash( const char* data, const size_t size );
+    uint64_t                 TextGetHash( const std::string& text );
     bool                     TextGetInt( const std::string& text, int& result, const uint8_t& base = 10 );
     std::string              TextGetJoined( const std::vector<std::string>& text, const std::string& delimeter );
+    std::vector<std::string> TextGetLines( const std::string_view& text );
     std::string              TextGetLower( const std::string& text );
     std::string              TextGetPacked( const std::string& text );
     std::string              TextGetReplaced( const std::string& text, const std::string& from, const std::string& to );
@@ -454,6 +751,8 @@ public:
     std::string TextGetTrimmed( const std::string& text );
 
     bool       TextIsDefine( const std::string& text );
+    bool       TextGetScriptDefine( const std::string& text, std::string& name );
+    bool       TextGetDefine( const std::string_view& text, std::string_view& name, std::string_view& value );
     bool       TextGetDefineInt( const std::string& text, const std::regex& re, std::string& name, int32_t& value );
     bool       TextGetDefineString( const std::string& text, const std::regex& re, std::string& name, std::string& value );
     std::regex TextGetDefineIntRegex( std::string prefix, std::string suffix, bool paren );
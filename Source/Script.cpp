@@ -1,6 +1,7 @@
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
-#include <fstream>
+#include <limits>
 
 #include "Ini.h"
 
@@ -15,12 +16,71 @@ ReDefine::ScriptEdit::External ReDefine::ScriptEdit::ExternalDummy;
 //
 
 ReDefine::ScriptEdit::ScriptEdit() :
-    Debug( false )
+    Debug( false ),
+    BatchSlot( -1 )
 {}
 
 //
 
-static std::map<std::string, std::string> DummyCache;
+static ReDefine::ScriptEditCache DummyCache;
+
+void ReDefine::ScriptEditCache::Resize( const size_t size )
+{
+    Values.assign( size, std::string() );
+    Stored.assign( size, 0 );
+    Used.clear();
+    Named.clear();
+}
+
+// only slots set since previous call are cleared
+void ReDefine::ScriptEditCache::Clear()
+{
+    for( const int32_t slot : Used )
+    {
+        Values[slot].clear();
+        Stored[slot] = 0;
+    }
+
+    Used.clear();
+    Named.clear();
+}
+
+bool ReDefine::ScriptEditCache::IsEmpty() const
+{
+    return Used.empty() && Named.empty();
+}
+
+bool ReDefine::ScriptEditCache::IsStored( const int32_t slot, const std::string& name ) const
+{
+    if( slot >= 0 && static_cast<size_t>(slot) < Stored.size() )
+        return Stored[slot] != 0;
+
+    return Named.find( name ) != Named.end();
+}
+
+std::string& ReDefine::ScriptEditCache::Get( const int32_t slot, const std::string& name )
+{
+    if( slot >= 0 && static_cast<size_t>(slot) < Values.size() )
+        return Values[slot];
+
+    return Named[name];
+}
+
+void ReDefine::ScriptEditCache::Set( const int32_t slot, const std::string& name, const std::string& value )
+{
+    if( slot >= 0 && static_cast<size_t>(slot) < Values.size() )
+    {
+        if( !Stored[slot] )
+        {
+            Stored[slot] = 1;
+            Used.push_back( slot );
+        }
+
+        Values[slot] = value;
+    }
+    else
+        Named[name] = value;
+}
 
 ReDefine::ScriptEdit::External::External() :
     RunConditions( false ),
@@ -30,7 +90,7 @@ ReDefine::ScriptEdit::External::External() :
     Cache( DummyCache )
 {}
 
-ReDefine::ScriptEdit::External::External( const std::string& name, bool conditions, bool results, std::map<std::string, std::string>& cache ) :
+ReDefine::ScriptEdit::External::External( const std::string& name, bool conditions, bool results, ScriptEditCache& cache ) :
     Name( name ),
     RunConditions( conditions ),
     RunResults( results ),
@@ -46,9 +106,11 @@ bool ReDefine::ScriptEdit::External::InUse()
 
 //
 
-ReDefine::ScriptEditAction::ScriptEditAction( void* root, const ScriptEdit::Action& action, ScriptEditAction::Flag& flags, std::map<std::string, std::string>& cache ) :
+ReDefine::ScriptEditAction::ScriptEditAction( void* root, const ScriptEdit::Action& action, ScriptEditAction::Flag& flags, ScriptEditCache& cache ) :
     Name( action.Name ),
     Values( action.Values ),
+    CacheSlot( action.CacheSlot ),
+    CounterSlot( action.CounterSlot ),
     Root( static_cast<ReDefine*>(root) ),
     Flags( flags ),
     Cache( cache )
@@ -152,7 +214,7 @@ bool ReDefine::ScriptEditAction::GetCACHE( const char* caller, const uint32_t& v
         return false;
     }
 
-    if( Cache.empty() )
+    if( Cache.IsEmpty() )
     {
         if( caller )
             Root->WARNING( caller, "action cache is empty" );
@@ -160,15 +222,14 @@ bool ReDefine::ScriptEditAction::GetCACHE( const char* caller, const uint32_t& v
         return false;
     }
 
-    auto it = Cache.find( Values[val] );
-    if( it == Cache.end() )
+    if( !Cache.IsStored( CacheSlot, Values[val] ) )
     {
         if( caller )
             Root->WARNING( caller, "action cache<%s> does not exits", Values[val].c_str() );
 
         return false;
     }
-    else if( it->second.empty() )
+    else if( Cache.Get( CacheSlot, Values[val] ).empty() )
     {
         if( caller )
             Root->WARNING( caller, "action cache<%s> is empty", Values[val].c_str() );
@@ -179,6 +240,21 @@ bool ReDefine::ScriptEditAction::GetCACHE( const char* caller, const uint32_t& v
     return true;
 }
 
+bool ReDefine::ScriptEditAction::SetCACHE( const char* caller, const uint32_t& val, const std::string& value )
+{
+    if( val >= Values.size() || Values[val].empty() )
+    {
+        if( caller )
+            Root->WARNING( caller, "CACHE is empty" );
+
+        return false;
+    }
+
+    Cache.Set( CacheSlot, Values[val], value );
+
+    return true;
+}
+
 bool ReDefine::ScriptEditAction::GetINDEX( const char* caller, const uint32_t& val, const ScriptCode& code, uint32_t& out ) const
 {
     uint32_t tmp;
@@ -281,6 +357,7 @@ ReDefine::ScriptEditReturn ReDefine::ScriptEditAction::CallEditIf( const ScriptC
     ScriptEdit::Action action;
     action.Name = name;
     action.Values = values;
+    action.CacheSlot = Root->GetEditCacheSlot( name, values );
 
     ScriptEditAction data( Root, action, Flags, Cache );
 
@@ -304,6 +381,7 @@ ReDefine::ScriptEditReturn ReDefine::ScriptEditAction::CallEditDo( ScriptCode& c
     ScriptEdit::Action action;
     action.Name = name;
     action.Values = values;
+    action.CacheSlot = Root->GetEditCacheSlot( name, values );
 
     ScriptEditAction data( Root, action, Flags, Cache );
 
@@ -312,9 +390,26 @@ ReDefine::ScriptEditReturn ReDefine::ScriptEditAction::CallEditDo( ScriptCode& c
 
 //
 
+// returns slot of cache used by action called at runtime, or -1 if cache name is not used by any edit in config
+int32_t ReDefine::GetEditCacheSlot( const std::string& action, const std::vector<std::string>& values )
+{
+    auto itCache = EditCache.find( action );
+    if( itCache == EditCache.end() || itCache->second >= values.size() )
+        return -1;
+
+    auto itSlot = std::find( EditCacheSlots.begin(), EditCacheSlots.end(), values[itCache->second] );
+    if( itSlot == EditCacheSlots.end() )
+        return -1;
+
+    return static_cast<int32_t>(std::distance( EditCacheSlots.begin(), itSlot ) );
+}
+
+//
+
 ReDefine::ScriptCode::ScriptCode( const ScriptCode::Flag& flags /* = ScriptCode::Flag::NONE */ ) :
     Parent( nullptr ),
     File( nullptr ),
+    Batch( -1 ),
     Flags( flags )
 {}
 
@@ -481,7 +576,7 @@ bool ReDefine::ScriptCode::IsFunctionKnown( const char* caller ) const
     if( !IsFunction( caller ) )
         return false;
 
-    if( Parent->FunctionsPrototypes.find( Name ) == Parent->FunctionsPrototypes.end() )
+    if( !Parent->GetFunctionProto( Name ) )
     {
         if( caller )
             Parent->WARNING( caller, "function<%s> must be added to configuration before using this action", Name.c_str() );
@@ -628,7 +723,7 @@ static ReDefine::ScriptEditReturn RunExternal( const char* caller, ReDefine::Scr
     code.Changes.push_back( std::make_pair<std::string, std::string>( "script code (extracted)", codeExtracted.GetFullString() ) );
 
 
-    action.Root->ProcessScriptEdit( ReDefine::ScriptEditAction::Flag::DEMAND, action.Root->EditOnDemand, codeExtracted, restart, external );
+    action.Root->ProcessScriptEdit( ReDefine::ScriptEditAction::Flag::DEMAND, action.Root->EditOnDemand, codeExtracted, restart, action.Cache, external );
 
     for( const auto& change : codeExtracted.Changes )
     {
@@ -968,7 +1063,9 @@ static ReDefine::ScriptEditReturn DoArgumentCache( ReDefine::ScriptEditAction& a
     if( !action.GetINDEX( __FUNCTION__, 0, code, idx ) )
         return action.Invalid();
 
-    action.Cache[action.Values[1]] = code.Arguments[idx].Arg;
+    if( !action.SetCACHE( __FUNCTION__, 1, code.Arguments[idx].Arg ) )
+        return action.Invalid();
+
     return action.Success();
 }
 
@@ -985,7 +1082,7 @@ static ReDefine::ScriptEditReturn DoArgumentCount( ReDefine::ScriptEditAction& a
     if( !action.GetINDEX( __FUNCTION__, 0, code, idx ) )
         return action.Invalid();
 
-    action.Root->Status.Process.Counters[action.Values[1]][code.Arguments[idx].Arg]++;
+    action.Root->Count( action.CounterSlot, action.Values[1], code.Arguments[idx].Arg );
 
     return action.Success();
 }
@@ -1032,7 +1129,7 @@ static ReDefine::ScriptEditReturn DoArgumentSetCached( ReDefine::ScriptEditActio
     if( !action.GetCACHE( __FUNCTION__, 1 ) )
         return action.Invalid();
 
-    code.Arguments[idx].Raw = code.Arguments[idx].Arg = action.Cache[action.Values[1]];
+    code.Arguments[idx].Raw = code.Arguments[idx].Arg = action.CacheValue( 1 );
     code.Arguments[idx].Type = "?";
 
     return action.Success();
@@ -1134,9 +1231,9 @@ static ReDefine::ScriptEditReturn DoArgumentLookup( ReDefine::ScriptEditAction&
             action.Root->WARNING( __FUNCTION__, "unknown %s<%s>", code.Arguments[idx].Type.c_str(), code.Arguments[idx].Arg.c_str() );
 
             if( unknown )
-                action.Root->Status.Process.Counters["!Unknown " + code.Arguments[idx].Type + "!"][code.Arguments[idx].Arg]++;
+                action.Root->CountUnknown( code.Arguments[idx].Type, code.Arguments[idx].Arg );
             else if( !counter.empty() )
-                action.Root->Status.Process.Counters[counter][code.Arguments[idx].Arg]++;
+                action.Root->Count( action.CounterSlot, counter, code.Arguments[idx].Arg );
 
             return action.Success();
         }
@@ -1149,9 +1246,9 @@ static ReDefine::ScriptEditReturn DoArgumentLookup( ReDefine::ScriptEditAction&
             action.Root->WARNING( __FUNCTION__, "unknown %s<%s>", code.Arguments[idx].Type.c_str(), code.Arguments[idx].Arg.c_str() );
 
             if( unknown )
-                action.Root->Status.Process.Counters["!Unknown " + code.Arguments[idx].Type + "!"][code.Arguments[idx].Arg]++;
+                action.Root->CountUnknown( code.Arguments[idx].Type, code.Arguments[idx].Arg );
             else if( !counter.empty() )
-                action.Root->Status.Process.Counters[counter][code.Arguments[idx].Arg]++;
+                action.Root->Count( action.CounterSlot, counter, code.Arguments[idx].Arg );
 
             return action.Success();
         }
@@ -1320,7 +1417,7 @@ static ReDefine::ScriptEditReturn DoArgumentsPushBackCached( ReDefine::ScriptEdi
         type = action.Values[1];
     }
 
-    return action.CallEditDo( code, "DoArgumentsPushBack", { action.Cache[action.Values[0]], type } );
+    return action.CallEditDo( code, "DoArgumentsPushBack", { action.CacheValue( 0 ), type } );
 }
 
 // ? DoArgumentsPushFront:STRING,
@@ -1377,7 +1474,7 @@ static ReDefine::ScriptEditReturn DoArgumentsPushFrontCached( ReDefine::ScriptEd
         type = action.Values[1];
     }
 
-    return action.CallEditDo( code, "DoArgumentsPushFront", { action.Cache[action.Values[0]], type } );
+    return action.CallEditDo( code, "DoArgumentsPushFront", { action.CacheValue( 0 ), type } );
 }
 
 // ? DoArgumentsResize:UINT
@@ -1418,7 +1515,7 @@ static ReDefine::ScriptEditReturn DoFileCount( ReDefine::ScriptEditAction& actio
     if( !action.IsValues( __FUNCTION__, 1 ) )
         return action.Invalid();
 
-    action.Root->Status.Process.Counters[action.Values[0]][action.Root->Status.Current.File]++;
+    action.Root->Count( action.CounterSlot, action.Values[0], action.Root->Status.Current.File );
 
     return action.Success();
 }
@@ -1537,7 +1634,7 @@ static ReDefine::ScriptEditReturn DoNameCount( ReDefine::ScriptEditAction& actio
     if( !action.IsValues( __FUNCTION__, 1 ) )
         return action.Invalid();
 
-    action.Root->Status.Process.Counters[action.Values[0]][code.Name]++;
+    action.Root->Count( action.CounterSlot, action.Values[0], code.Name );
 
     return action.Success();
 }
@@ -1572,7 +1669,7 @@ static ReDefine::ScriptEditReturn DoNameSetCached( ReDefine::ScriptEditAction& a
     if( !action.GetCACHE( __FUNCTION__, 0 ) )
         return action.Invalid();
 
-    return action.CallEditDo( code, "DoNameSet", { action.Cache[action.Values[0]] } );
+    return action.CallEditDo( code, "DoNameSet", { action.CacheValue( 0 ) } );
 }
 
 // ? DoNameSetPrefix:STRING
@@ -1650,7 +1747,9 @@ static ReDefine::ScriptEditReturn DoOperatorValueCache( ReDefine::ScriptEditActi
     if( !action.IsValues( __FUNCTION__, 1 ) )
         return action.Invalid();
 
-    action.Cache[action.Values[0]] = code.OperatorArgument;
+    if( !action.SetCACHE( __FUNCTION__, 0, code.OperatorArgument ) )
+        return action.Invalid();
+
     return action.Success();
 }
 
@@ -1768,6 +1867,31 @@ void ReDefine::InitScript()
     EditDo["DoRestart"] = &DoRestart;
     EditDo["DoReturnSetType"] = &DoReturnSetType;
     EditDo["DoVariable"] = &DoVariable;
+
+    // index of CACHE value, for all actions using it
+    EditCache["DoArgumentCache"] = 1;
+    EditCache["DoArgumentSetCached"] = 1;
+    EditCache["DoArgumentsPushBackCached"] = 0;
+    EditCache["DoArgumentsPushFrontCached"] = 0;
+    EditCache["DoNameSetCached"] = 0;
+    EditCache["DoOperatorValueCache"] = 0;
+
+    // index of counter name value, for all actions using counters
+    EditCounter["DoArgumentCount"] = 1;
+    EditCounter["DoArgumentLookup"] = 1;
+    EditCounter["DoFileCount"] = 0;
+    EditCounter["DoNameCount"] = 0;
+
+    // conditions without side effects, which results can be shared between edits as long as script code is not changed
+    // IfArgumentCondition is not listed, as it runs other edits
+    EditIfPure = {
+        "IfArgumentIs", "IfArgumentValue", "IfArgumentsEqual", "IfArgumentsSize", "IfEdited", "IfFileName", "IfFunction",
+        "IfName", "IfOperator", "IfOperatorName", "IfOperatorValue", "IfReturnType", "IfVariable"
+    };
+
+    // conditions which never reports invalid result, regardless of conditions checked before them
+    // other conditions usually depends on previous ones (IfArgumentValue after IfFunction, etc.), and are never reordered
+    EditIfUnordered = { "IfEdited", "IfFileName", "IfFunction", "IfVariable" };
 }
 
 void ReDefine::FinishScript( bool finishCallbacks /* = true */ )
@@ -1776,8 +1900,21 @@ void ReDefine::FinishScript( bool finishCallbacks /* = true */ )
     {
         EditIf.clear();
         EditDo.clear();
+        EditCache.clear();
+        EditCounter.clear();
+        EditIfPure.clear();
+        EditIfUnordered.clear();
     }
 
+    EditCacheSlots.clear();
+    EditSharedSlots = 0;
+
+    // counters using old slots needs to be added to status before slots are gone
+    FlushCounters();
+    CounterSlots.clear();
+    CounterUnknownSlots.clear();
+
+    EditBatchSlots = 0;
     EditBefore.clear();
     EditAfter.clear();
     EditOnDemand.clear();
@@ -1896,6 +2033,23 @@ bool ReDefine::ReadConfigScript( const std::string& sectionPrefix )
                         result.Name = arg[0];
                         result.Values = vals;
 
+                        // cache names are shared by all edits (including ones running on demand),
+                        // and converted to slots so processing scripts doesn't need to search for them
+                        auto itCache = EditCache.find( result.Name );
+                        if( itCache != EditCache.end() && itCache->second < result.Values.size() && !result.Values[itCache->second].empty() )
+                        {
+                            auto itSlot = std::find( EditCacheSlots.begin(), EditCacheSlots.end(), result.Values[itCache->second] );
+                            if( itSlot == EditCacheSlots.end() )
+                                itSlot = EditCacheSlots.insert( EditCacheSlots.end(), result.Values[itCache->second] );
+
+                            result.CacheSlot = static_cast<int32_t>(std::distance( EditCacheSlots.begin(), itSlot ) );
+                        }
+
+                        // same for counters names
+                        auto itCounter = EditCounter.find( result.Name );
+                        if( itCounter != EditCounter.end() && itCounter->second < result.Values.size() && !result.Values[itCounter->second].empty() )
+                            result.CounterSlot = GetCounterSlot( result.Values[itCounter->second] );
+
                         edit.Results.push_back( result );
                     }
                     else
@@ -1976,33 +2130,133 @@ bool ReDefine::ReadConfigScript( const std::string& sectionPrefix )
         }
     }
 
+    ReadConfigScriptShared();
+
+    // edits running on demand are never evaluated in batch, as they always works on extracted script code
+    for( auto* edits : { &EditBefore, &EditAfter } )
+    {
+        for( auto& it : *edits )
+        {
+            for( ScriptEdit& edit : it.second )
+            {
+                edit.BatchSlot = EditBatchSlots++;
+            }
+        }
+    }
+
     return true;
 }
 
+static std::string GetSharedKey( const ReDefine::ScriptEdit::Action& condition )
+{
+    std::string result = condition.Name;
+
+    for( const auto& value : condition.Values )
+    {
+        result += '\0' + value;
+    }
+
+    return result;
+}
+
+void ReDefine::ReadConfigScriptShared()
+{
+    // find identical conditions used by multiple edits
+    // edits running on demand are skipped, as they always works on extracted script code
+
+    std::map<std::string, uint32_t> uses;
+    std::map<std::string, int32_t>  slots;
+
+    for( auto* edits : { &EditBefore, &EditAfter } )
+    {
+        for( const auto& it : *edits )
+        {
+            for( const ScriptEdit& edit : it.second )
+            {
+                for( const ScriptEdit::Action& condition : edit.Conditions )
+                {
+                    if( EditIfPure.find( condition.Name ) != EditIfPure.end() )
+                        uses[GetSharedKey( condition )]++;
+                }
+            }
+        }
+    }
+
+    EditSharedSlots = 0;
+
+    for( auto* edits : { &EditBefore, &EditAfter } )
+    {
+        for( auto& it : *edits )
+        {
+            for( ScriptEdit& edit : it.second )
+            {
+                for( ScriptEdit::Action& condition : edit.Conditions )
+                {
+                    if( EditIfPure.find( condition.Name ) == EditIfPure.end() )
+                        continue;
+
+                    const std::string conditionKey = GetSharedKey( condition );
+                    if( uses[conditionKey] < 2 )
+                        continue;
+
+                    auto itSlot = slots.find( conditionKey );
+                    if( itSlot == slots.end() )
+                        itSlot = slots.emplace( conditionKey, EditSharedSlots++ ).first;
+
+                    // negation is applied after getting result, so both versions can use same slot
+                    condition.SharedSlot = itSlot->second;
+                }
+            }
+        }
+    }
+}
+
 // processing
 
-void ReDefine::ProcessScript( const std::string& path, const std::string& filename, const bool readOnly /* = false */ )
+bool ReDefine::ProcessScript( const std::string& path, const std::string& filename, const bool readOnly /* = false */ )
+{
+    std::vector<char> data;
+    if( !ReadScript( path, filename, data ) )
+        return false;
+
+    ScriptResult result;
+    bool         updateFile = ProcessScript( path, filename, data, result, readOnly );
+
+    if( !result.Content.empty() )
+    {
+        const std::string fullname = TextGetFilename( path, filename );
+
+        SaveScript( fullname, static_cast<uint32_t>(result.Changes.size() ), WriteFile( fullname, result.Content.data(), result.Content.size(), Durability == ScriptDurability::FILE ) );
+    }
+
+    return updateFile;
+}
+
+bool ReDefine::ReadScript( const std::string& path, const std::string& filename, std::vector<char>& data )
 {
     if( path.empty() )
     {
         WARNING( __FUNCTION__, "script<%s> path is empty", filename.c_str() );
-        return;
+        return false;
     }
     else if( !std::filesystem::exists( path ) )
     {
         WARNING( __FUNCTION__, "script<%s> path<%s> does not exists", filename.c_str(), path.c_str() );
-        return;
+        return false;
     }
     else if( !std::filesystem::is_directory( path ) )
     {
         WARNING( __FUNCTION__, "script<%s> path<%s> is not a directory", filename.c_str(), path.c_str() );
-        return;
+        return false;
     }
 
-    std::vector<std::string> lines;
-    if( !ReadFile( TextGetFilename( path, filename ), lines ) )
-        return;
+    return ReadFile( TextGetFilename( path, filename ), data );
+}
 
+// processes script already loaded into memory
+// result content is left empty if there is nothing to write, that is when running in read-only mode or script does not need changes
+bool ReDefine::ProcessScript([[maybe_unused]] const std::string& path, const std::string& filename, const std::vector<char>& data, ScriptResult& result, const bool readOnly )
+{
     #if defined (HAVE_PARSER)
     if( UseParser )
     {
@@ -2054,11 +2308,8 @@ public:
         Parser::File file;
 
         // show time!
-        auto              read = std::chrono::system_clock::now();
-        std::vector<char> data;
+        auto read = std::chrono::system_clock::now();
         DEBUG( nullptr, "READ! %s %s", path.c_str(), filename.c_str() );
-        if( !ReadFile( TextGetFilename( path, filename ), data ) )
-            return;
 
         auto explode = std::chrono::system_clock::now();
         file.Exploded = parser.Explode( filename, data );
@@ -2096,23 +2347,61 @@ public:
     }
     #endif
 
+    bool updateFile = ProcessBuffer( std::string_view( data.data(), data.size() ), filename, result, readOnly );
+
+    // skip writing if new content is identical to original one
+    if( readOnly || !updateFile || (result.Content.size() == data.size() && std::equal( result.Content.begin(), result.Content.end(), data.begin() ) ) )
+        result.Content.clear();
+
+    return updateFile;
+}
+
+// updates status after writing changed script
+void ReDefine::SaveScript( const std::string& filename, const uint32_t changes, const bool saved )
+{
+    if( saved )
+    {
+        if( Durability == ScriptDurability::BATCH )
+            ScriptsUnsynced.push_back( filename );
+    }
+    else
+    {
+        WARNING( __FUNCTION__, "cannot write file<%s>", filename.c_str() );
+
+        // revert changes counter
+        Status.Process.FilesChanges--;
+        Status.Process.LinesChanges -= changes;
+    }
+}
+
+// processes script content without touching any files; filename is used by logs and conditions only
+// returns true if script content needs changes, in which case result contains rewritten content
+bool ReDefine::ProcessBuffer( const std::string_view& buffer, const std::string& filename, ScriptResult& result, const bool readOnly /* = false */ )
+{
+    result.Content.clear();
+    result.Changes.clear();
+    result.Process.Clear();
+
+    // status changes are collected separately, and added to totals when done
+    FlushCounters();
+    std::swap( result.Process, Status.Process );
+
+    std::vector<std::string> lines = TextGetLines( buffer );
+
     Status.Process.Files++;
     Status.Current.Clear();
 
     Status.Current.File = filename;
 
-    bool              updateFile = false, conflict = false, restart = false, codeChanged = false;
+    bool              updateFile = false, conflict = false;
     std::string       content, newline = ScriptFormattingUnix ? "\n" : "\r\n";
-    uint32_t          changes = 0;
-    uint16_t          restartCount = 0;
-    const uint16_t    restartLimit = 1000;
 
     SStatus::SCurrent previous;
 
     ScriptFile*       file = new ScriptFile();
 
-    std::smatch       match;
-    std::regex        define( "^[\\t\\ ]*\\#define[\\t\\ ]+([A-Za-z0-9_]+)(?:$|[\\t\\ ]+.*$)" );
+    if( EditBatch )
+        ProcessScriptBatch( lines, file->Batch );
 
     for( auto& line : lines )
     {
@@ -2137,7 +2426,7 @@ public:
             content += line + newline;
             continue;
         }
-        else if( line.find( "//ReDefine::IgnoreLine//" ) != std::string::npos || line.find( "/*ReDefine::IgnoreLine*/" ) != std::string::npos ) // TODO C++23 https://en.cppreference.com/w/cpp/string/basic_string/contains
+        else if( TextIsIgnored( line ) )
         {
             // DEBUG( nullptr, "SKIP" );
             content += line + newline;
@@ -2148,112 +2437,21 @@ public:
         if( TextIsConflict( line ) )
         {
             WARNING( nullptr, "possible merge conflict" );
-            Status.Process.Counters["!Possible merge conflicts!"][Status.Current.File]++;
+            Count( -1, "!Possible merge conflicts!", Status.Current.File );
             conflict = true;
         }
 
-        std::string defineName, defineValue;
-        if( std::regex_match( line, match, define ) )
+        std::string defineName;
+        if( TextGetScriptDefine( line, defineName ) )
         {
-            file->Defines.push_back( match.str( 1 ) );
+            file->Defines.push_back( defineName );
             // DEBUG( __FUNCTION__, "DEFINE [%s]", file->Defines.back().c_str() );
         }
 
         // save original line
         const std::string lineOld = line;
 
-        restart = true;
-        restartCount = 0;
-
-        while( restart )
-        {
-            restart = false;
-            if( restartCount > restartLimit )
-            {
-                WARNING( __FUNCTION__, "line processing stopped : reached restart limit<%u>", restartLimit );
-                break;
-            }
-
-            // extract more or less interesting code
-            std::vector<ScriptCode> extracted;
-            TextGetVariables( line, extracted );
-            TextGetFunctions( line, extracted );
-
-            for( const ScriptCode& codeOld : extracted )
-            {
-                ScriptCode code = codeOld;
-                code.Parent = this;
-                code.File = file;
-
-                // make sure type flag is set
-                if( !code.IsVariable( nullptr ) && !code.IsFunction( nullptr ) )
-                {
-                    WARNING( __FUNCTION__, "script code<%s> ignored : type missing", code.Name.c_str() );
-                    continue;
-                }
-
-                // prepare code to reflect configuration (required by some edit actions)
-                if( code.IsVariable( nullptr ) )
-                {
-                    auto it = VariablesPrototypes.find( code.Name );
-                    if( it != VariablesPrototypes.end() )
-                    {
-                        code.ReturnType = it->second;
-                    }
-                    else
-                    {
-                        code.ReturnType = "?";
-                    }
-                }
-                else if( code.IsFunction( nullptr ) )
-                {
-                    auto it = FunctionsPrototypes.find( code.Name );
-                    if( it != FunctionsPrototypes.end() )
-                    {
-                        code.ReturnType = it->second.ReturnType;
-                        // code.ArgumentsTypes = it->second.ArgumentsTypes;
-                        code.SetFunctionArgumentsTypes( it->second );
-                    }
-                }
-
-                code.Change( "script code", code.GetFullString() );
-
-                // "preprocess"
-                ProcessScriptEdit( ScriptEditAction::Flag::BEFORE, EditBefore, code, restart );
-
-                // "process"
-                ProcessScriptReplacements( code );
-
-                // "postprocess"
-                ProcessScriptEdit( ScriptEditAction::Flag::AFTER, EditAfter, code, restart );
-
-                // check for changes
-                code.SetFullString();
-                codeChanged = TextGetPacked( codeOld.Full ) != TextGetPacked( code.Full );
-
-                // dump changelog
-                if( code.Changes.size() >= 2 && (DebugChanges == ScriptDebugChanges::ALL || (DebugChanges == ScriptDebugChanges::ONLY_IF_CHANGED && codeChanged) ) )
-                    code.ChangeLog();
-
-                // update if needed
-                if( ScriptFormattingForced || codeChanged )
-                    line = TextGetReplaced( line, codeOld.Full, code.Full );
-
-                // handle restart
-                if( restart )
-                    restartCount++;
-            }
-        }
-
-        // process raw replacement
-        ProcessRaw( line );
-
-        // detect line change, ignore meaningless changes
-        bool change = TextGetPacked( line ) != TextGetPacked( lineOld );
-        if( !change )
-            change = ScriptFormattingForced && line != lineOld;
-
-        if( change )
+        if( ProcessScriptLine( line, file, EditBatch ) )
         {
             // log changes
             // requires messing with Status.Current so log functions won't add unwanted info
@@ -2271,7 +2469,7 @@ public:
             Status.Current = previous;
 
             // update file status
-            changes++;
+            result.Changes.push_back( { Status.Current.LineNumber, lineOld, line } );
             updateFile = true;
         }
 
@@ -2285,7 +2483,7 @@ public:
         Status.Current.Line.clear();
         Status.Current.LineNumber = 0;
 
-        WARNING( nullptr, "possible merge conflict : ignored all line changes<%u>", changes );
+        WARNING( nullptr, "possible merge conflict : ignored all line changes<%u>", static_cast<uint32_t>(result.Changes.size() ) );
         updateFile = false;
     }
 
@@ -2296,11 +2494,12 @@ public:
     if( updateFile )
     {
         Status.Process.FilesChanges++;
-        Status.Process.LinesChanges += changes;
+        Status.Process.LinesChanges += static_cast<uint32_t>(result.Changes.size() );
     }
 
-    if( readOnly )
-        return;
+    FlushCounters();
+    std::swap( result.Process, Status.Process );
+    Status.Process.Add( result.Process );
 
     if( updateFile )
     {
@@ -2311,23 +2510,127 @@ public:
             content += newline;
         }
 
-        std::ofstream file;
-        file.open( TextGetFilename( path, filename ), std::ios::out | std::ios::binary );
+        result.Content = std::move( content );
+    }
+
+    return updateFile;
+}
+
+// processes single script line, without any side-cleanup; returns true if line has been changed
+// script code extracted by ProcessScriptBatch() is used if batched is set, and can be used only for unchanged line
+bool ReDefine::ProcessScriptLine( std::string& line, ScriptFile* file, bool batched /* = false */ )
+{
+    bool           restart = true, codeChanged = false;
+    uint16_t       restartCount = 0;
+    const uint16_t restartLimit = 1000;
+
+    // save original line
+    const std::string lineOld = line;
+
+    // shared by all edits running for this line; cleared before each edit
+    ScriptEditCache cache;
+    cache.Resize( EditCacheSlots.size() );
 
-        if( file.is_open() )
+    while( restart )
+    {
+        restart = false;
+        if( restartCount > restartLimit )
+        {
+            WARNING( __FUNCTION__, "line processing stopped : reached restart limit<%u>", restartLimit );
+            break;
+        }
+
+        // extract more or less interesting code
+        std::vector<ScriptCode> extracted;
+        if( batched )
         {
-            file << content;
-            file.close();
+            // messages are shown in same place as they would be without batch
+            LogReplay( file->Batch.Messages[Status.Current.LineNumber - 1] );
+            extracted = std::move( file->Batch.Extracted[Status.Current.LineNumber - 1] );
         }
         else
         {
-            WARNING( __FUNCTION__, "cannot write file<%s>", TextGetFilename( path, filename ).c_str() );
+            TextGetVariables( line, extracted );
+            TextGetFunctions( line, extracted );
+        }
+
+        batched = false;
+
+        for( const ScriptCode& codeOld : extracted )
+        {
+            ScriptCode code = codeOld;
+            code.Parent = this;
+            code.File = file;
+
+            // make sure type flag is set
+            if( !code.IsVariable( nullptr ) && !code.IsFunction( nullptr ) )
+            {
+                WARNING( __FUNCTION__, "script code<%s> ignored : type missing", code.Name.c_str() );
+                continue;
+            }
+
+            // prepare code to reflect configuration (required by some edit actions)
+            if( code.IsVariable( nullptr ) )
+            {
+                auto it = VariablesPrototypes.find( code.Name );
+                if( it != VariablesPrototypes.end() )
+                {
+                    code.ReturnType = it->second;
+                }
+                else
+                {
+                    code.ReturnType = "?";
+                }
+            }
+            else if( code.IsFunction( nullptr ) )
+            {
+                const FunctionProto* proto = GetFunctionProto( code.Name );
+                if( proto )
+                {
+                    code.ReturnType = proto->ReturnType;
+                    // code.ArgumentsTypes = proto->ArgumentsTypes;
+                    code.SetFunctionArgumentsTypes( *proto );
+                }
+            }
+
+            code.Change( "script code", code.GetFullString() );
 
-            // revert changes counter
-            Status.Process.FilesChanges--;
-            Status.Process.LinesChanges -= changes;
+            // "preprocess"
+            ProcessScriptEdit( ScriptEditAction::Flag::BEFORE, EditBefore, code, restart, cache );
+
+            // "process"
+            ProcessScriptReplacements( code );
+
+            // "postprocess"
+            ProcessScriptEdit( ScriptEditAction::Flag::AFTER, EditAfter, code, restart, cache );
+
+            // check for changes
+            code.SetFullString();
+            codeChanged = TextGetPacked( codeOld.Full ) != TextGetPacked( code.Full );
+
+            // dump changelog
+            if( code.Changes.size() >= 2 && (DebugChanges == ScriptDebugChanges::ALL || (DebugChanges == ScriptDebugChanges::ONLY_IF_CHANGED && codeChanged) ) )
+                code.ChangeLog();
+
+            // update if needed
+            if( ScriptFormattingForced || codeChanged )
+                line = TextGetReplaced( line, codeOld.Full, code.Full );
+
+            // handle restart
+            if( restart )
+                restartCount++;
         }
     }
+
+    // process raw replacement
+    ProcessRaw( line );
+
+    // detect line change, ignore meaningless changes
+    bool change = TextGetPacked( line ) != TextGetPacked( lineOld );
+    if( !change )
+        change = ScriptFormattingForced && line != lineOld;
+
+    return change;
 }
 
 void ReDefine::ProcessScriptReplacements( ScriptCode& code, bool refresh /* = false */ )
@@ -2347,12 +2650,12 @@ void ReDefine::ProcessScriptReplacements( ScriptCode& code, bool refresh /* = fa
         }
         else if( code.IsFunction( nullptr ) )
         {
-            auto it = FunctionsPrototypes.find( code.Name );
-            if( it != FunctionsPrototypes.end() )
+            const FunctionProto* proto = GetFunctionProto( code.Name );
+            if( proto )
             {
-                code.ReturnType = it->second.ReturnType;
-                // code.ArgumentsTypes = it->second.ArgumentsTypes;
-                code.SetFunctionArgumentsTypes( it->second );
+                code.ReturnType = proto->ReturnType;
+                // code.ArgumentsTypes = proto->ArgumentsTypes;
+                code.SetFunctionArgumentsTypes( *proto );
             }
         }
     }
@@ -2403,39 +2706,494 @@ void ReDefine::ProcessScriptReplacements( ScriptCode& code, bool refresh /* = fa
     }
 }
 
-void ReDefine::ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, const std::map<uint32_t, std::vector<ReDefine::ScriptEdit>>& edits, ReDefine::ScriptCode& codeOld, bool& restart, ScriptEdit::External& external /* = ScriptEdit::ExternalDummy */ )
+uint32_t ReDefine::ScriptBatch::GetId( const std::string& text )
+{
+    auto it = Ids.find( text );
+    if( it != Ids.end() )
+        return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(Ids.size() );
+    Ids[text] = id;
+
+    return id;
+}
+
+// checks if condition wasn't replaced by plugin; replaced conditions are checked by regular processing only, as their results cannot be predicted
+static bool IsBuiltinEditIf( ReDefine* root, const std::string& name, decltype(&IfName) function )
+{
+    auto it = root->EditIf.find( name );
+    if( it == root->EditIf.end() )
+        return false;
+
+    auto target = it->second.target<decltype(&IfName)>();
+
+    return target && *target == function;
+}
+
+// checks first condition of edit for all script code in batch; returns false if condition cannot be checked that way
+// script code which fails first condition can skip the edit, as long as it's not changed
+// all conditions used here never reports invalid result for variables/functions, and don't log anything when failing as first condition
+static bool GetBatchRun( ReDefine* root, ReDefine::ScriptBatch& batch, const ReDefine::ScriptEdit::Action& condition, std::vector<uint8_t>& run )
+{
+    const size_t  size = batch.Name.size();
+    const uint8_t negate = condition.Negate ? 1 : 0;
+    const uint8_t function = static_cast<uint8_t>(ReDefine::ScriptCode::Flag::FUNCTION);
+    const uint8_t variable = static_cast<uint8_t>(ReDefine::ScriptCode::Flag::VARIABLE);
+
+    run.assign( size, 0 );
+
+    // names, which never appeared in file, are skipped
+    // IfFunction stops at first empty name
+    std::vector<uint32_t> names;
+    for( const auto& value : condition.Values )
+    {
+        if( value.empty() && condition.Name == "IfFunction" )
+            break;
+
+        auto it = batch.Ids.find( value );
+        if( it != batch.Ids.end() )
+            names.push_back( it->second );
+    }
+
+    if( condition.Name == "IfFunction" || condition.Name == "IfVariable" )
+    {
+        const uint8_t type = condition.Name == "IfFunction" ? function : variable;
+        const bool    any = condition.Values.empty() || condition.Values[0].empty();
+
+        // names are checked with IfName
+        if( !IsBuiltinEditIf( root, condition.Name, type == function ? &IfFunction : &IfVariable ) || (!any && !IsBuiltinEditIf( root, "IfName", &IfName ) ) )
+            return false;
+
+        for( size_t idx = 0; idx < size; idx++ )
+        {
+            uint8_t result = batch.Type[idx] == type;
+            if( result && !any )
+                result = std::find( names.begin(), names.end(), batch.Name[idx] ) != names.end();
+
+            run[idx] = result ^ negate;
+        }
+    }
+    else if( condition.Name == "IfName" && condition.Values.size() == 1 && IsBuiltinEditIf( root, condition.Name, &IfName ) )
+    {
+        const uint32_t name = names.empty() ? std::numeric_limits<uint32_t>::max() : names[0];
+
+        for( size_t idx = 0; idx < size; idx++ )
+        {
+            run[idx] = (batch.Name[idx] == name) ^ negate;
+        }
+    }
+    else if( condition.Name == "IfFileName" && condition.Values.size() == 1 && IsBuiltinEditIf( root, condition.Name, &IfFileName ) )
+    {
+        run.assign( size, (root->Status.Current.File == condition.Values[0]) ^ negate );
+    }
+    else if( condition.Name == "IfOperator" && IsBuiltinEditIf( root, condition.Name, &IfOperator ) )
+    {
+        const uint32_t none = batch.GetId( "" );
+
+        for( size_t idx = 0; idx < size; idx++ )
+        {
+            run[idx] = (batch.Operator[idx] != none) ^ negate;
+        }
+    }
+    else if( condition.Name == "IfArgumentsSize" && condition.Values.size() == 1 && root->TextIsInt( condition.Values[0] ) && IsBuiltinEditIf( root, condition.Name, &IfArgumentsSize ) )
+    {
+        int arity = -1;
+        if( !root->TextGetInt( condition.Values[0], arity ) || arity < 0 )
+            return false;
+
+        // variables are always checked, to keep warnings
+        for( size_t idx = 0; idx < size; idx++ )
+        {
+            run[idx] = batch.Type[idx] != function || ( (batch.Arity[idx] == static_cast<uint32_t>(arity) ) ^ negate );
+        }
+    }
+    else
+        return false;
+
+    return true;
+}
+
+void ReDefine::ProcessScriptBatch( const std::vector<std::string>& lines, ScriptBatch& batch )
+{
+    // extract script code from all lines, in same way as ProcessScript() does, and check first condition of all edits at once
+
+    // messages logged during extraction are kept per line, and shown when line is processed
+    // recording is paused, as messages are recorded when replayed
+    const SStatus::SCurrent  previous = Status.Current;
+    std::vector<LogMessage>* record = LogRecord;
+
+    LogRecord = nullptr;
+
+    batch.Extracted.resize( lines.size() );
+    batch.Messages.resize( lines.size() );
+    batch.GetId( "" );
+
+    for( size_t idx = 0, len = lines.size(); idx < len; idx++ )
+    {
+        std::string line = lines[idx];
+
+        if( line.empty() || TextIsBlank( line ) )
+            continue;
+
+        line.erase( line.find_last_not_of( "\t " ) + 1 );
+
+        if( TextIsComment( line ) || TextIsIgnored( line ) )
+            continue;
+
+        // keep extraction logs consistent with regular processing
+        Status.Current.Line = line;
+        Status.Current.LineNumber = idx + 1;
+
+        std::vector<ScriptCode>& extracted = batch.Extracted[idx];
+
+        std::vector<LogMessage>* capture = LogCapture( &batch.Messages[idx] );
+        TextGetVariables( line, extracted );
+        TextGetFunctions( line, extracted );
+        LogCapture( capture );
+
+        for( ScriptCode& code : extracted )
+        {
+            code.Batch = static_cast<int32_t>(batch.Name.size() );
+
+            batch.Name.push_back( batch.GetId( code.Name ) );
+            batch.Operator.push_back( batch.GetId( code.Operator ) );
+            batch.Type.push_back( static_cast<uint8_t>(code.IsFunction( nullptr ) ? ScriptCode::Flag::FUNCTION : code.IsVariable( nullptr ) ? ScriptCode::Flag::VARIABLE : ScriptCode::Flag::NONE) );
+            batch.Arity.push_back( static_cast<uint32_t>(code.Arguments.size() ) );
+        }
+    }
+
+    Status.Current = previous;
+    LogRecord = record;
+
+    batch.Run.assign( EditBatchSlots, std::vector<uint8_t>() );
+
+    for( auto* edits : { &EditBefore, &EditAfter } )
+    {
+        for( const auto& it : *edits )
+        {
+            for( const ScriptEdit& edit : it.second )
+            {
+                if( edit.BatchSlot < 0 || edit.Conditions.empty() || static_cast<size_t>(edit.BatchSlot) >= batch.Run.size() )
+                    continue;
+
+                if( !GetBatchRun( this, batch, edit.Conditions.front(), batch.Run[edit.BatchSlot] ) )
+                    batch.Run[edit.BatchSlot].clear();
+            }
+        }
+    }
+}
+
+// returns reason why given edit conditions can never be satisfied, or empty string
+// only problems which cannot be fixed by previous edits (or changed by script content) are reported
+static std::string GetDeadConditions( ReDefine* root, const ReDefine::ScriptEdit& edit, const std::set<std::string>& demandAlive )
+{
+    for( const ReDefine::ScriptEdit::Action& condition : edit.Conditions )
+    {
+        const std::string& name = condition.Name;
+
+        if( root->EditIf.find( name ) == root->EditIf.end() )
+            return "unknown condition<" + name + ">";
+
+        if( name == "IfReturnType" && !condition.Values.empty() && !root->IsMysteryDefineType( condition.Values[0] ) && !root->IsDefineType( condition.Values[0] ) )
+            return "condition<IfReturnType> uses unknown TYPE<" + condition.Values[0] + ">";
+
+        if( name == "IfArgumentIs" && condition.Values.size() >= 3 && !root->IsDefineType( condition.Values[2] ) )
+            return "condition<IfArgumentIs> uses unknown TYPE<" + condition.Values[2] + ">";
+
+        if( name == "IfArgumentCondition" && condition.Values.size() >= 3 && demandAlive.find( condition.Values[1] + "->" + condition.Values[2] ) == demandAlive.end() )
+            return "condition<IfArgumentCondition> uses unknown edit<" + condition.Values[1] + "->" + condition.Values[2] + ">";
+    }
+
+    return std::string();
+}
+
+void ReDefine::ProcessScriptEditDead()
+{
+    // remove edits which can never be completed, using defines types loaded by ProcessHeaders()
+    // such edits would otherwise be checked (and possibly report same warning) for every script code
+    //
+    // edits running on demand are removed if they are not used by any other edit,
+    // or if their conditions cannot be satisfied and they are not used by DoArgumentResult (which ignores conditions)
+
+    bool removed = true;
+
+    while( removed )
+    {
+        removed = false;
+
+        std::set<std::string> demandAlive, demandUsed, demandResults;
+
+        for( const auto& it : EditOnDemand )
+        {
+            for( const ScriptEdit& edit : it.second )
+            {
+                demandAlive.insert( edit.Name );
+            }
+        }
+
+        const std::function<std::string( const ScriptEdit&, bool )> getDead = [this, &demandAlive] ( const ScriptEdit& edit, bool results ) {
+                                                                                  if( !results )
+                                                                                      return GetDeadConditions( this, edit, demandAlive );
+
+                                                                                  for( const ScriptEdit::Action& result : edit.Results )
+                                                                                  {
+                                                                                      if( EditDo.find( result.Name ) == EditDo.end() )
+                                                                                          return "unknown result<" + result.Name + ">";
+
+                                                                                      if( result.Name == "DoArgumentResult" && result.Values.size() >= 3 && demandAlive.find( result.Values[1] + "->" + result.Values[2] ) == demandAlive.end() )
+                                                                                          return "result<DoArgumentResult> uses unknown edit<" + result.Values[1] + "->" + result.Values[2] + ">";
+                                                                                  }
+
+                                                                                  return std::string();
+                                                                              };
+
+        for( auto* edits : { &EditBefore, &EditAfter, &EditOnDemand } )
+        {
+            for( auto& it : *edits )
+            {
+                auto end = std::remove_if( it.second.begin(), it.second.end(), [&] ( const ScriptEdit& edit ) {
+                    // on-demand edits are validated separately
+                    std::string reason = edits == &EditOnDemand ? getDead( edit, true ) : getDead( edit, false );
+                    if( reason.empty() && edits != &EditOnDemand )
+                        reason = getDead( edit, true );
+
+                    if( !reason.empty() )
+                    {
+                        WARNING( nullptr, "script edit<%s> removed : %s", edit.Name.c_str(), reason.c_str() );
+                        return true;
+                    }
+
+                    for( const auto& actions : { &edit.Conditions, &edit.Results } )
+                    {
+                        for( const ScriptEdit::Action& action : *actions )
+                        {
+                            if( (action.Name == "IfArgumentCondition" || action.Name == "DoArgumentResult") && action.Values.size() >= 3 )
+                            {
+                                const std::string name = action.Values[1] + "->" + action.Values[2];
+
+                                // edits running on demand might reference themselves
+                                if( name == edit.Name )
+                                    continue;
+
+                                demandUsed.insert( name );
+                                if( action.Name == "DoArgumentResult" )
+                                    demandResults.insert( name );
+                            }
+                        }
+                    }
+
+                    return false;
+                } );
+
+                if( end != it.second.end() )
+                {
+                    it.second.erase( end, it.second.end() );
+                    removed = true;
+                }
+            }
+        }
+
+        // edits running on demand can be removed only after all references are known
+
+        for( auto& it : EditOnDemand )
+        {
+            auto end = std::remove_if( it.second.begin(), it.second.end(), [&] ( const ScriptEdit& edit ) {
+                std::string reason;
+
+                if( demandUsed.find( edit.Name ) == demandUsed.end() )
+                    reason = "edit is never used";
+                else if( demandResults.find( edit.Name ) == demandResults.end() )
+                    reason = GetDeadConditions( this, edit, demandAlive );
+
+                if( reason.empty() )
+                    return false;
+
+                WARNING( nullptr, "script edit<%s> removed : %s", edit.Name.c_str(), reason.c_str() );
+                return true;
+            } );
+
+            if( end != it.second.end() )
+            {
+                it.second.erase( end, it.second.end() );
+                removed = true;
+            }
+        }
+    }
+
+    for( auto* edits : { &EditBefore, &EditAfter, &EditOnDemand } )
+    {
+        for( auto it = edits->begin(); it != edits->end();)
+        {
+            if( it->second.empty() )
+                it = edits->erase( it );
+            else
+                ++it;
+        }
+    }
+}
+
+// conditions are AND-ed, so cheapest and most selective ones should be checked first
+// lower rank means condition should be moved closer to edit start
+static double GetAdaptiveRank( const ReDefine::ScriptEdit::Action& condition )
+{
+    // conditions never checked (because of previous ones failing) are kept at end
+    if( !condition.StatsCalls )
+        return std::numeric_limits<double>::max();
+
+    const double cost = static_cast<double>(condition.StatsTime) / condition.StatsCalls;
+    const double fail = 1.0 - static_cast<double>(condition.StatsPassed) / condition.StatsCalls;
+
+    return cost / std::max( fail, 0.000001 );
+}
+
+void ReDefine::ProcessScriptEditAdaptive()
+{
+    // only leading conditions which can be checked in any order are sorted, everything after first condition depending on order stays in place
+
+    for( auto* edits : { &EditBefore, &EditAfter } )
+    {
+        for( auto& it : *edits )
+        {
+            for( ScriptEdit& edit : it.second )
+            {
+                auto end = std::find_if( edit.Conditions.begin(), edit.Conditions.end(), [this] ( const ScriptEdit::Action& condition ) {
+                    return EditIfUnordered.find( condition.Name ) == EditIfUnordered.end();
+                } );
+
+                if( std::distance( edit.Conditions.begin(), end ) < 2 )
+                    continue;
+
+                std::stable_sort( edit.Conditions.begin(), end, [] ( const ScriptEdit::Action& left, const ScriptEdit::Action& right ) {
+                    return GetAdaptiveRank( left ) < GetAdaptiveRank( right );
+                } );
+            }
+        }
+    }
+}
+
+void ReDefine::LogScriptEditAdaptive()
+{
+    // learned order is logged in config format, so it can be copied back to [Script] section(s)
+
+    for( const auto& edits : { std::make_pair( "RunBefore", &EditBefore ), std::make_pair( "RunAfter", &EditAfter ) } )
+    {
+        for( const auto& it : *edits.second )
+        {
+            for( const ScriptEdit& edit : it.second )
+            {
+                std::vector<std::string> actions;
+                bool                     stats = false;
+
+                if( edit.Debug )
+                    actions.push_back( "DEBUG" );
+
+                actions.push_back( edits.first + std::string( ":" ) + std::to_string( it.first ) );
+
+                for( const ScriptEdit::Action& condition : edit.Conditions )
+                {
+                    actions.push_back( (condition.Negate ? "!" : "") + condition.Name + (!condition.Values.empty() ? (":" + TextGetJoined( condition.Values, "," ) ) : "") );
+
+                    if( condition.StatsCalls )
+                        stats = true;
+                }
+
+                for( const ScriptEdit::Action& result : edit.Results )
+                {
+                    actions.push_back( result.Name + (!result.Values.empty() ? (":" + TextGetJoined( result.Values, "," ) ) : "") );
+                }
+
+                if( !stats )
+                    continue;
+
+                LOG( "Adaptive conditions ... %s = %s", edit.Name.c_str(), TextGetJoined( actions, " " ).c_str() );
+
+                for( const ScriptEdit::Action& condition : edit.Conditions )
+                {
+                    if( !condition.StatsCalls )
+                        continue;
+
+                    DEBUG( nullptr, "%s %s%s : checked<%llu> passed<%llu> time<%lluns>", edit.Name.c_str(), condition.Negate ? "!" : "", condition.Name.c_str(),
+                           static_cast<unsigned long long>(condition.StatsCalls), static_cast<unsigned long long>(condition.StatsPassed), static_cast<unsigned long long>(condition.StatsTime) );
+                }
+            }
+        }
+    }
+}
+
+void ReDefine::ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, std::map<uint32_t, std::vector<ReDefine::ScriptEdit>>& edits, ReDefine::ScriptCode& codeOld, bool& restart, ScriptEditCache& cache, ScriptEdit::External& external /* = ScriptEdit::ExternalDummy */ )
 {
     // editing must always works on backup to prevent massive screwup
     // original code will be updated only if there's no problems with *any* condition/result function
     // that, plus (intentional) massive spam in warning log should be enough to get user's attention (yeah, i don't belive that either... :P)
-    ScriptCode        code = codeOld;
+    ScriptCode code = codeOld;
+
+    // results of conditions used by multiple edits; valid until any result changes script code
+    std::vector<ScriptEditReturn> shared( external.InUse() ? 0 : EditSharedSlots, ScriptEditReturn::Invalid );
+    const bool                    adaptive = EditAdaptive && !external.InUse();
+
+    // results of first conditions checked by ProcessScriptBatch(); valid until any result changes script code
+    ScriptBatch* batch = nullptr;
+    if( !external.InUse() && codeOld.Batch >= 0 && codeOld.File && static_cast<size_t>(codeOld.Batch) < codeOld.File->Batch.Name.size() )
+    {
+        batch = &codeOld.File->Batch;
+
+        auto itName = batch->Ids.find( codeOld.Name );
+        auto itOperator = batch->Ids.find( codeOld.Operator );
+
+        if( itName == batch->Ids.end() || itName->second != batch->Name[codeOld.Batch] ||
+            itOperator == batch->Ids.end() || itOperator->second != batch->Operator[codeOld.Batch] ||
+            codeOld.Arguments.size() != batch->Arity[codeOld.Batch] || codeOld.IsFlag( ScriptCode::Flag::EDITED ) )
+            batch = nullptr;
+    }
+
     const std::string timing = initFlag == ScriptEditAction::Flag::BEFORE ? "Before" : initFlag == ScriptEditAction::Flag::AFTER ? "After" : initFlag == ScriptEditAction::Flag::DEMAND ? "OnDemand" : "";
 
-    for( const auto& it : edits )
+    for( auto& it : edits )
     {
-        for( const ScriptEdit& edit : it.second )
+        for( ScriptEdit& edit : it.second )
         {
             if( external.InUse() && edit.Name != external.Name )
                 continue;
 
-            const ScriptDebugChanges           debug = edit.Debug ? ScriptDebugChanges::ALL : DebugChanges;
-            ScriptEditReturn                   editReturn = ScriptEditReturn::Invalid;
-            ScriptEditAction::Flag             editFlag = initFlag;
-            std::map<std::string, std::string> editCache;
+            // first condition is known to fail
+            if( batch && edit.BatchSlot >= 0 && static_cast<size_t>(edit.BatchSlot) < batch->Run.size() && !batch->Run[edit.BatchSlot].empty() && !batch->Run[edit.BatchSlot][code.Batch] )
+                continue;
+
+            const ScriptDebugChanges debug = edit.Debug ? ScriptDebugChanges::ALL : DebugChanges;
+            ScriptEditReturn         editReturn = ScriptEditReturn::Invalid;
+            ScriptEditAction::Flag   editFlag = initFlag;
+            ScriptEditCache&         editCache = external.InUse() ? external.Cache : cache;
+
+            bool                     run = false, first = true;
+            const std::string        change = "script edit<" +  timing + ":" + std::to_string( it.first ) + ":" + edit.Name + ">";
+            const size_t             changesSize = code.Changes.size();
+            std::string              log;
 
-            bool                               run = false, first = true;
-            const std::string                  change = "script edit<" +  timing + ":" + std::to_string( it.first ) + ":" + edit.Name + ">";
-            const size_t                       changesSize = code.Changes.size();
-            std::string                        log;
+            // cache is never shared between edits, unless running on demand
+            if( !external.InUse() )
+                editCache.Clear();
 
             // all conditions needs to be satisfied
-            for( const ScriptEdit::Action& condition : edit.Conditions )
+            for( ScriptEdit::Action& condition : edit.Conditions )
             {
                 if( external.InUse() && !external.RunConditions )
                     break;
 
-                ScriptEditAction editAction( this, condition, editFlag, external.InUse() ? external.Cache : editCache );
-                editReturn = editAction.CallEditIf( code );
+                const auto start = adaptive ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+                const bool useShared = condition.SharedSlot >= 0 && static_cast<size_t>(condition.SharedSlot) < shared.size();
+                const bool fromShared = useShared && shared[condition.SharedSlot] != ScriptEditReturn::Invalid;
+
+                if( fromShared )
+                    editReturn = shared[condition.SharedSlot];
+                else
+                {
+                    ScriptEditAction editAction( this, condition, editFlag, editCache );
+                    editReturn = editAction.CallEditIf( code );
+
+                    // invalid results are never shared, so warnings are still reported by each edit
+                    if( useShared )
+                        shared[condition.SharedSlot] = editReturn;
+                }
 
                 if( editReturn != ScriptEditReturn::Invalid )
                 {
@@ -2461,6 +3219,15 @@ void ReDefine::ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, const
                     external.ReturnConditions = ScriptEditReturn::Invalid;
                 }
 
+                // results reused from shared slots cost (almost) nothing, and would make condition look cheaper than it is
+                if( adaptive && !fromShared )
+                {
+                    condition.StatsCalls++;
+                    condition.StatsTime += std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+                    if( run )
+                        condition.StatsPassed++;
+                }
+
                 if( debug > ScriptDebugChanges::NONE && ( (first && run) || !first ) )
                     code.Change( change + " " + (condition.Negate ? "!" : "") + condition.Name + (!condition.Values.empty() ? (":" + TextGetJoined( condition.Values, "," ) ) : ""), run ? "true" : "false" );
 
@@ -2491,7 +3258,7 @@ void ReDefine::ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, const
                 if( debug > ScriptDebugChanges::NONE )
                     log = " " + result.Name + (!result.Values.empty() ? (":" + TextGetJoined( result.Values, "," ) ) : "");
 
-                ScriptEditAction editAction( this, result, editFlag, external.InUse() ? external.Cache : editCache );
+                ScriptEditAction editAction( this, result, editFlag, editCache );
                 editReturn = editAction.CallEditDo( code );
 
                 if( editReturn != ScriptEditReturn::Invalid )
@@ -2546,6 +3313,10 @@ void ReDefine::ProcessScriptEdit( const ScriptEditAction::Flag& initFlag, const
                 }
             }     // for( const ScriptEdit::Action& result : edit.Results )
 
+            // script code might be changed by results
+            std::fill( shared.begin(), shared.end(), ScriptEditReturn::Invalid );
+            batch = nullptr;
+
             // handle refresh
             if( code.IsFlag( ScriptCode::Flag::REFRESH ) )
             {
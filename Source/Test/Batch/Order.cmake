@@ -0,0 +1,68 @@
+# runs executable with and without --batch-edits on copies of same scripts, and compares output, logs and results
+# messages logged when extracting script code must be shown in same order in both runs; see Batch/Order/ReDefine.cfg
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( GLOB_RECURSE scripts LIST_DIRECTORIES false RELATIVE "${TEST_DIR}/Scripts" "${TEST_DIR}/Scripts/*" )
+list( SORT scripts )
+
+foreach( run IN ITEMS Regular Batch )
+	file( REMOVE_RECURSE "${PWD}/${run}" )
+	file( MAKE_DIRECTORY "${PWD}/${run}" )
+	file( COPY "${TEST_DIR}/ReDefine.cfg" "${TEST_DIR}/Scripts" DESTINATION "${PWD}/${run}" )
+
+	if( run STREQUAL "Batch" )
+		set( options --batch-edits )
+	else()
+		set( options )
+	endif()
+
+	message( "" )
+	message( STATUS "ReDefine run (${run})" )
+	message( "" )
+
+	execute_process(
+		COMMAND ${REDEFINE} --debug-changes 2 ${options}
+		WORKING_DIRECTORY "${PWD}/${run}"
+		RESULT_VARIABLE exitcode
+		OUTPUT_VARIABLE output
+	)
+
+	message( "${output}" )
+	file( WRITE "${PWD}/${run}/ReDefine.out" "${output}" )
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : ${run} exitcode<${exitcode}>" )
+	endif()
+endforeach()
+
+set( files ReDefine.out ReDefine.log ReDefine.WARNING.log ReDefine.DEBUG.log )
+foreach( script IN LISTS scripts )
+	list( APPEND files "Scripts/${script}" )
+endforeach()
+
+foreach( file IN LISTS files )
+	if( NOT EXISTS "${PWD}/Regular/${file}" AND NOT EXISTS "${PWD}/Batch/${file}" )
+		continue()
+	endif()
+
+	file( READ "${PWD}/Regular/${file}" regular )
+	file( READ "${PWD}/Batch/${file}" batch )
+
+	if( NOT regular STREQUAL batch )
+		message( "" )
+		message( STATUS "REGULAR ${file}" )
+		message( "${regular}" )
+		message( STATUS "BATCH   ${file}" )
+		message( "${batch}" )
+		message( FATAL_ERROR "TEST FAILED" )
+	endif()
+endforeach()
+
+file( REMOVE_RECURSE "${PWD}/Regular" "${PWD}/Batch" )
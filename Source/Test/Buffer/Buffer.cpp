@@ -0,0 +1,73 @@
+//
+// executable used by Buffer/Compare test
+//
+// ReDefine.Test.Buffer [config] [input] [output]
+//
+// processes content of input file as in-memory buffer, and saves result (or unchanged content) in output file;
+// results must be same as when input file is processed by ReDefine executable
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+#include "Ini.h"
+
+#include "ReDefine.h"
+
+int main( int argc, char** argv )
+{
+    if( argc != 4 )
+    {
+        std::printf( "Usage: ReDefine.Test.Buffer [config] [input] [output]\n" );
+        return EXIT_FAILURE;
+    }
+
+    ReDefine redefine;
+    redefine.Init();
+
+    // logfiles are used by ReDefine executable only
+    redefine.LogFile.clear();
+    redefine.LogWarning.clear();
+    redefine.LogDebug.clear();
+
+    if( !redefine.Config->LoadFile( argv[1] ) )
+    {
+        redefine.WARNING( nullptr, "cannot read config<%s>", argv[1] );
+        return EXIT_FAILURE;
+    }
+
+    const std::string headers = redefine.Config->GetStr( "ReDefine", "HeadersDir" );
+    redefine.ScriptFormattingUnix = redefine.Config->GetBool( "ReDefine", "UnixNewlines", redefine.ScriptFormattingUnix );
+
+    if( !redefine.ReadConfig( "Defines", "Variable", "Function", "Raw", "Script", "" ) )
+    {
+        redefine.WARNING( nullptr, "cannot parse config<%s>", argv[1] );
+        return EXIT_FAILURE;
+    }
+
+    redefine.Config->Unload();
+    redefine.ProcessHeaders( headers );
+
+    std::vector<char> data;
+    if( !redefine.ReadFile( argv[2], data ) )
+    {
+        redefine.WARNING( nullptr, "cannot read input<%s>", argv[2] );
+        return EXIT_FAILURE;
+    }
+
+    ReDefine::ScriptResult result;
+    const std::string      buffer( data.begin(), data.end() );
+
+    // filename is used same way as for scripts placed directly in scripts directory
+    if( !redefine.ProcessBuffer( buffer, std::filesystem::path( argv[2] ).filename().string(), result ) )
+        result.Content = buffer;
+
+    if( !redefine.WriteFile( argv[3], result.Content.data(), result.Content.size() ) )
+    {
+        redefine.WARNING( nullptr, "cannot write output<%s>", argv[3] );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
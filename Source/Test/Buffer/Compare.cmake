@@ -0,0 +1,71 @@
+# processes scripts as in-memory buffers, and checks if results are same as for scripts processed by ReDefine executable
+# see Buffer/ReDefine.cfg, Buffer/Buffer.cpp
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT REDEFINE_BUFFER )
+	message( FATAL_ERROR "REDEFINE_BUFFER not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( REMOVE_RECURSE "${PWD}/Buffer" )
+file( MAKE_DIRECTORY "${PWD}/Buffer/Buffers" )
+file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Buffer" )
+
+set( scripts )
+
+function( AddScript name content )
+	file( WRITE "${PWD}/Buffer/Scripts/${name}" "${content}" )
+	set( scripts ${scripts} ${name} PARENT_SCOPE )
+endfunction()
+
+AddScript( CrLf.ssl "f(1);\r\nh(2);\r\nf(3);\r\n" )
+AddScript( CrLfNoNewline.ssl "f(1);\r\nh(2);\r\nf(3);" )
+AddScript( LfNoNewline.ssl "f(1);\nh(2);\nf(3);" )
+AddScript( Mixed.ssl "f(1);\nh(2);   \r\n \t \r\n// f(3);\r\nf(4); //ReDefine::IgnoreLine//\nf(5);" )
+AddScript( Unchanged.ssl "h(1);\r\nh(2);" )
+AddScript( Single.ssl "f(1);" )
+
+foreach( script IN LISTS scripts )
+	execute_process(
+		COMMAND ${REDEFINE_BUFFER} ReDefine.cfg Scripts/${script} Buffers/${script}
+		WORKING_DIRECTORY "${PWD}/Buffer"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : script<${script}> buffer exitcode<${exitcode}>" )
+	endif()
+endforeach()
+
+execute_process(
+	COMMAND ${REDEFINE}
+	WORKING_DIRECTORY "${PWD}/Buffer"
+	RESULT_VARIABLE exitcode
+)
+
+if( NOT exitcode EQUAL 0 )
+	message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+endif()
+
+foreach( script IN LISTS scripts )
+	file( READ "${PWD}/Buffer/Scripts/${script}" expected HEX )
+	file( READ "${PWD}/Buffer/Buffers/${script}" content HEX )
+	if( NOT content STREQUAL expected )
+		message( FATAL_ERROR "TEST FAILED : script<${script}> buffer<${content}> file<${expected}>" )
+	endif()
+endforeach()
+
+# sanity check, in case both ways are broken same way
+file( READ "${PWD}/Buffer/Scripts/CrLfNoNewline.ssl" content HEX )
+string( HEX "g(DUMMY_ONE);\r\nh(2);\r\ng(3);\r\n" expected )
+if( NOT content STREQUAL expected )
+	message( FATAL_ERROR "TEST FAILED : unexpected content<${content}> expected<${expected}>" )
+endif()
+
+file( REMOVE_RECURSE "${PWD}/Buffer" )
@@ -0,0 +1,113 @@
+# runs executable with config cache enabled, and checks if cached config gives same results as validated one;
+# broken cache must be rebuilt
+# see ConfigCache/ReDefine.cfg
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( REMOVE_RECURSE "${PWD}/ConfigCache" )
+file( MAKE_DIRECTORY "${PWD}/ConfigCache" )
+file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/ConfigCache" )
+file( APPEND "${PWD}/ConfigCache/ReDefine.cfg" "\n#define DUMMY_ONE 1\n#define DUMMY_TWO 2\n" )
+
+set( cache "${PWD}/ConfigCache/Config.cache" )
+set( scripts Alpha.ssl Beta.ssl )
+
+function( ResetScripts )
+	file( WRITE "${PWD}/ConfigCache/Scripts/Alpha.ssl" "f(1);\nf(2);\n" )
+	file( WRITE "${PWD}/ConfigCache/Scripts/Beta.ssl" "procedure start begin\n   f(1, 1);\nend\n" )
+endfunction()
+
+function( RunReDefine )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	ResetScripts()
+	execute_process(
+		COMMAND ${REDEFINE} --config-cache Config.cache ${ARGN}
+		WORKING_DIRECTORY "${PWD}/ConfigCache"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	elseif( NOT EXISTS "${cache}" )
+		message( FATAL_ERROR "TEST FAILED : config cache not saved" )
+	endif()
+endfunction()
+
+function( CheckLog expected )
+	file( READ "${PWD}/ConfigCache/ReDefine.log" log )
+	string( FIND "${log}" "Config loaded from cache" found )
+	if( expected AND found EQUAL -1 )
+		message( FATAL_ERROR "TEST FAILED : config not loaded from cache" )
+	elseif( NOT expected AND NOT found EQUAL -1 )
+		message( FATAL_ERROR "TEST FAILED : config loaded from cache" )
+	endif()
+endfunction()
+
+# scripts must be byte-identical to ones processed with validated config
+function( CheckScripts )
+	foreach( script IN LISTS scripts )
+		file( READ "${PWD}/ConfigCache/Scripts/${script}" content HEX )
+		file( READ "${PWD}/ConfigCache/Expected/${script}" expected HEX )
+		if( NOT content STREQUAL expected )
+			message( FATAL_ERROR "TEST FAILED : script<${script}> differs from uncached run" )
+		endif()
+	endforeach()
+endfunction()
+
+# replaces part of cache file; cmake strings can hold any bytes as long as they are passed quoted
+function( CorruptCache offset bytes )
+	file( READ "${cache}" content )
+	string( LENGTH "${content}" length )
+	string( LENGTH "${bytes}" size )
+	math( EXPR after "${offset} + ${size}" )
+	if( length LESS after )
+		message( FATAL_ERROR "TEST FAILED : config cache too small<${length}>" )
+	endif()
+
+	string( SUBSTRING "${content}" 0 ${offset} head )
+	string( SUBSTRING "${content}" ${after} -1 tail )
+	file( WRITE "${cache}" "${head}${bytes}${tail}" )
+endfunction()
+
+RunReDefine()
+CheckLog( FALSE )
+file( COPY "${PWD}/ConfigCache/Scripts/" DESTINATION "${PWD}/ConfigCache/Expected" )
+
+RunReDefine()
+CheckLog( TRUE )
+CheckScripts()
+
+# headers list of first header with huge size; magic(8) + version(4) + hash(8) + headers count(4)
+string( ASCII 255 255 255 127 huge )
+CorruptCache( 24 "${huge}" )
+RunReDefine()
+CheckLog( FALSE )
+CheckScripts()
+
+RunReDefine()
+CheckLog( TRUE )
+CheckScripts()
+
+# truncated cache
+file( READ "${cache}" content LIMIT 40 )
+file( WRITE "${cache}" "${content}" )
+RunReDefine()
+CheckLog( FALSE )
+CheckScripts()
+
+RunReDefine()
+CheckLog( TRUE )
+CheckScripts()
+
+file( REMOVE_RECURSE "${PWD}/ConfigCache" )
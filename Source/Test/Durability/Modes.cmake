@@ -0,0 +1,79 @@
+# runs executable with all durability modes, and checks if all of them gives same results without leaving temporary files
+# see Durability/ReDefine.cfg
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+set( scripts Alpha.ssl Beta.ssl Sub/Gamma.ssl Unchanged.ssl )
+
+function( RunReDefine )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	file( REMOVE_RECURSE "${PWD}/Durability" )
+	file( MAKE_DIRECTORY "${PWD}/Durability" )
+	file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Durability" )
+
+	foreach( script IN LISTS scripts )
+		if( script STREQUAL "Unchanged.ssl" )
+			file( WRITE "${PWD}/Durability/Scripts/${script}" "h(1);\r\nh(2);" )
+		else()
+			file( WRITE "${PWD}/Durability/Scripts/${script}" "f(1);\r\nh(2);\r\nf(3);" )
+		endif()
+	endforeach()
+
+	execute_process(
+		COMMAND ${REDEFINE} ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Durability"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	endif()
+
+	file( GLOB_RECURSE temporary LIST_DIRECTORIES false RELATIVE "${PWD}/Durability" "${PWD}/Durability/*.tmp" )
+	if( temporary )
+		message( FATAL_ERROR "TEST FAILED : temporary files left<${temporary}>" )
+	endif()
+
+	foreach( file IN ITEMS Scripts.manifest Config.cache Defines.snapshot )
+		if( NOT EXISTS "${PWD}/Durability/${file}" )
+			message( FATAL_ERROR "TEST FAILED : file<${file}> not saved" )
+		endif()
+	endforeach()
+endfunction()
+
+# scripts must be byte-identical, regardless of durability mode and pipeline; changed scripts always ends with newline
+function( CheckScripts )
+	foreach( script IN LISTS scripts )
+		if( script STREQUAL "Unchanged.ssl" )
+			set( expected "h(1);\r\nh(2);" )
+		else()
+			set( expected "g(1);\r\nh(2);\r\ng(3);\r\n" )
+		endif()
+
+		file( READ "${PWD}/Durability/Scripts/${script}" content HEX )
+		string( HEX "${expected}" expected )
+		if( NOT content STREQUAL expected )
+			message( FATAL_ERROR "TEST FAILED : script<${script}> content<${content}> expected<${expected}>" )
+		endif()
+	endforeach()
+endfunction()
+
+foreach( durability IN ITEMS none batch file )
+	foreach( pipeline IN ITEMS 0 4 )
+		RunReDefine( --durability ${durability} --scripts-pipeline ${pipeline} )
+		CheckScripts()
+	endforeach()
+endforeach()
+
+file( REMOVE_RECURSE "${PWD}/Durability" )
@@ -0,0 +1,68 @@
+# runs regular and generated executables on copies of same scripts, and compares results
+# see Generated/ReDefine.cfg
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT REDEFINE_GENERATED )
+	message( FATAL_ERROR "REDEFINE_GENERATED not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( GLOB_RECURSE scripts LIST_DIRECTORIES false RELATIVE "${TEST_DIR}/Scripts" "${TEST_DIR}/Scripts/*" )
+list( SORT scripts )
+
+foreach( run IN ITEMS Regular Generated )
+	file( REMOVE_RECURSE "${PWD}/${run}" )
+	file( MAKE_DIRECTORY "${PWD}/${run}" )
+	file( COPY "${TEST_DIR}/Scripts" DESTINATION "${PWD}/${run}" )
+
+	# generated executable uses configuration and defines stored in tables, unless --config is used
+	if( run STREQUAL "Regular" )
+		file( COPY "${TEST_DIR}/ReDefine.cfg" "${TEST_DIR}/Headers" DESTINATION "${PWD}/${run}" )
+		set( executable "${REDEFINE}" )
+	else()
+		set( executable "${REDEFINE_GENERATED}" )
+	endif()
+
+	message( "" )
+	message( STATUS "ReDefine run (${run})" )
+	message( "" )
+
+	execute_process(
+		COMMAND ${executable} --debug-changes 2
+		WORKING_DIRECTORY "${PWD}/${run}"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : ${run} exitcode<${exitcode}>" )
+	endif()
+endforeach()
+
+set( files ReDefine.log ReDefine.WARNING.log ReDefine.DEBUG.log )
+foreach( script IN LISTS scripts )
+	list( APPEND files "Scripts/${script}" )
+endforeach()
+
+foreach( file IN LISTS files )
+	if( NOT EXISTS "${PWD}/Regular/${file}" AND NOT EXISTS "${PWD}/Generated/${file}" )
+		continue()
+	endif()
+
+	file( READ "${PWD}/Regular/${file}" regular )
+	file( READ "${PWD}/Generated/${file}" generated )
+
+	if( NOT regular STREQUAL generated )
+		message( "" )
+		message( STATUS "REGULAR   ${file}" )
+		message( "${regular}" )
+		message( STATUS "GENERATED ${file}" )
+		message( "${generated}" )
+		message( FATAL_ERROR "TEST FAILED" )
+	endif()
+endforeach()
+
+file( REMOVE_RECURSE "${PWD}/Regular" "${PWD}/Generated" )
@@ -0,0 +1,75 @@
+# runs executable on parts of scripts directory (selected or sharded), and checks if scripts manifest keeps entries of scripts which weren't processed
+# see Manifest/ReDefine.cfg
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( REMOVE_RECURSE "${PWD}/Manifest" )
+file( MAKE_DIRECTORY "${PWD}/Manifest" )
+file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Manifest" )
+
+set( scripts Alpha.ssl Beta.ssl Gamma.ssl Delta.ssl )
+foreach( script IN LISTS scripts )
+	file( WRITE "${PWD}/Manifest/Scripts/${script}" "f(1);\n" )
+endforeach()
+
+function( RunReDefine )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	execute_process(
+		COMMAND ${REDEFINE} ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Manifest"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	endif()
+endfunction()
+
+# scripts names are stored as-is, and can be found in binary manifest
+function( CheckManifest )
+	file( STRINGS "${PWD}/Manifest/Scripts.manifest" content )
+
+	foreach( script IN LISTS scripts )
+		string( FIND "${content}" "${script}" found )
+		list( FIND ARGN "${script}" expected )
+		if( NOT expected EQUAL -1 AND found EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : script<${script}> not found in manifest" )
+		elseif( expected EQUAL -1 AND NOT found EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : script<${script}> found in manifest" )
+		endif()
+	endforeach()
+endfunction()
+
+RunReDefine()
+CheckManifest( Alpha.ssl Beta.ssl Gamma.ssl Delta.ssl )
+
+RunReDefine( --files Alpha.ssl )
+CheckManifest( Alpha.ssl Beta.ssl Gamma.ssl Delta.ssl )
+
+# removed scripts are dropped from manifest, even if they weren't selected
+file( REMOVE "${PWD}/Manifest/Scripts/Beta.ssl" )
+RunReDefine( --files Alpha.ssl )
+CheckManifest( Alpha.ssl Gamma.ssl Delta.ssl )
+
+# each shard keeps entries of scripts processed by other shards, and uses own logfiles
+file( REMOVE "${PWD}/Manifest/Scripts.manifest" )
+RunReDefine( --shard 1/2 )
+RunReDefine( --shard 2/2 )
+CheckManifest( Alpha.ssl Gamma.ssl Delta.ssl )
+
+foreach( log IN ITEMS ReDefine.shard1.log ReDefine.shard2.log )
+	if( NOT EXISTS "${PWD}/Manifest/${log}" )
+		message( FATAL_ERROR "TEST FAILED : logfile<${log}> not found" )
+	endif()
+endforeach()
+
+file( REMOVE_RECURSE "${PWD}/Manifest" )
@@ -0,0 +1,70 @@
+# runs executable with plugins replacing built-in actions, and plugins which must be rejected
+# see Plugin/ReDefine.cfg, Plugin/Plugin.cpp
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+elseif( NOT PLUGIN OR NOT PLUGIN_VERSION OR NOT PLUGIN_NO_INIT )
+	message( FATAL_ERROR "PLUGIN, PLUGIN_VERSION or PLUGIN_NO_INIT not set" )
+endif()
+
+set( original "f(1);\nF(2);\nh(3);\n" )
+
+# runs executable with given plugin (if any), and checks exitcode, output and script content
+function( RunReDefine plugin success expected message )
+	message( "" )
+	message( STATUS "ReDefine run (${plugin} ${ARGN})" )
+	message( "" )
+
+	file( REMOVE_RECURSE "${PWD}/Plugin" )
+	file( MAKE_DIRECTORY "${PWD}/Plugin" )
+	file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Plugin" )
+	file( WRITE "${PWD}/Plugin/Scripts/Script.ssl" "${original}" )
+	if( plugin )
+		file( APPEND "${PWD}/Plugin/ReDefine.cfg" "\n[Plugins]\nTest = ${plugin}\n" )
+	endif()
+
+	execute_process(
+		COMMAND ${REDEFINE} ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Plugin"
+		RESULT_VARIABLE exitcode
+		OUTPUT_VARIABLE output
+		ERROR_VARIABLE  output
+	)
+
+	message( "${output}" )
+
+	if( success AND NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	elseif( NOT success AND exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : plugin not rejected" )
+	endif()
+
+	string( FIND "${output}" "${message}" found )
+	if( found EQUAL -1 )
+		message( FATAL_ERROR "TEST FAILED : message<${message}> not found" )
+	endif()
+
+	file( READ "${PWD}/Plugin/Scripts/Script.ssl" content )
+	if( NOT content STREQUAL expected )
+		message( FATAL_ERROR "TEST FAILED : unexpected script content\n${content}" )
+	endif()
+endfunction()
+
+# built-in actions
+RunReDefine( "" TRUE "f(1);\ng(2);\nh(3);\n" "Changed scripts" )
+
+# replaced IfName is used by IfFunction, also when first conditions are checked for whole file at once
+foreach( batch IN ITEMS "" --batch-edits )
+	RunReDefine( "${PLUGIN}" TRUE "G(1);\nG(2);\nh(3);\n" "Added plugin ... Test" ${batch} )
+endforeach()
+
+RunReDefine( "${PLUGIN_VERSION}" FALSE "${original}" "plugin<Test> version<0> does not match" )
+RunReDefine( "${PLUGIN_NO_INIT}" FALSE "${original}" "plugin<Test> does not export" )
+
+file( REMOVE_RECURSE "${PWD}/Plugin" )
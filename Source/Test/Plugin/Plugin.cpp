@@ -0,0 +1,68 @@
+//
+// plugin used by Plugin/Load test
+//
+// built in few variants, see Test/CMakeLists.txt
+// TEST_PLUGIN_VERSION - exported version; used to check plugins built against different ReDefine.h
+// TEST_PLUGIN_NO_INIT - plugin without ReDefinePluginInit()
+//
+
+#include <algorithm>
+#include <cctype>
+
+#include "ReDefine.h"
+
+#if !defined (TEST_PLUGIN_VERSION)
+# define TEST_PLUGIN_VERSION    REDEFINE_PLUGIN_VERSION
+#endif
+
+static std::string GetLower( std::string text )
+{
+    std::transform( text.begin(), text.end(), text.begin(), [] ( unsigned char ch ) { return static_cast<char>(std::tolower( ch ) ); } );
+
+    return text;
+}
+
+// ? IfName:STRING
+// ! Replaces built-in condition; names are compared case insensitively.
+static ReDefine::ScriptEditReturn IfName( ReDefine::ScriptEditAction& action, const ReDefine::ScriptCode& code )
+{
+    if( !code.IsVariableOrFunction( __FUNCTION__ ) )
+        return action.Invalid();
+
+    if( !action.IsValues( __FUNCTION__, 1 ) )
+        return action.Invalid();
+
+    return action.Return( GetLower( code.Name ) == GetLower( action.Values[0] ) );
+}
+
+// ? DoNameSet:STRING
+// ! Replaces built-in result; name is changed to uppercased STRING.
+static ReDefine::ScriptEditReturn DoNameSet( ReDefine::ScriptEditAction& action, ReDefine::ScriptCode& code )
+{
+    if( !code.IsVariableOrFunction( __FUNCTION__ ) )
+        return action.Invalid();
+
+    if( !action.IsValues( __FUNCTION__, 1 ) )
+        return action.Invalid();
+
+    code.Name = action.Values[0];
+    std::transform( code.Name.begin(), code.Name.end(), code.Name.begin(), [] ( unsigned char ch ) { return static_cast<char>(std::toupper( ch ) ); } );
+    code.SetFlag( ReDefine::ScriptCode::Flag::REFRESH );
+
+    return action.Success();
+}
+
+REDEFINE_PLUGIN_EXPORT uint32_t ReDefinePluginVersion()
+{
+    return TEST_PLUGIN_VERSION;
+}
+
+#if !defined (TEST_PLUGIN_NO_INIT)
+REDEFINE_PLUGIN_EXPORT bool ReDefinePluginInit( ReDefine* root )
+{
+    root->EditIf["IfName"] = IfName;
+    root->EditDo["DoNameSet"] = DoNameSet;
+
+    return true;
+}
+#endif
@@ -15,6 +15,7 @@ list( APPEND T_REQUIRED EXPECT )
 
 list( APPEND T_LIST CONFIG )
 list( APPEND T_LIST SCRIPT )
+list( APPEND T_LIST LOG )
 
 foreach( line IN LISTS content )
 	string( REGEX MATCH "^[A-Z]+" var "${line}" )
@@ -122,4 +123,19 @@ if( NOT "${result}" STREQUAL "${TEST_EXPECT}" )
 	message( "" )
 	message( FATAL_ERROR "TEST FAILED" )
 endif()
+
+# LOG lines must be found in general logfile
+if( TEST_LOG )
+	file( READ "${PWD}/Run/ReDefine.log" log )
+	foreach( line IN LISTS TEST_LOG )
+		string( FIND "${log}" "${line}" found )
+		if( found EQUAL -1 )
+			message( "" )
+			message( STATUS "LOG     ${line}" )
+			message( "" )
+			message( FATAL_ERROR "TEST FAILED" )
+		endif()
+	endforeach()
+endif()
+
 file( REMOVE_RECURSE "Run" )
@@ -0,0 +1,103 @@
+# runs executable with scripts selected by --files and --changed-since, and checks which scripts were changed
+# see Selection/ReDefine.cfg
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+set( scripts Alpha.ssl Beta.ssl Gamma.ssl Sub/Delta.ssl )
+
+# recreates test directory; all scripts needs changes
+function( Reset )
+	file( REMOVE_RECURSE "${PWD}/Selection" )
+	file( MAKE_DIRECTORY "${PWD}/Selection" )
+	file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Selection" )
+
+	foreach( script IN LISTS scripts )
+		file( WRITE "${PWD}/Selection/Scripts/${script}" "f(1);\n" )
+	endforeach()
+
+	file( WRITE "${PWD}/Selection/Outside.ssl" "f(1);\n" )
+endfunction()
+
+function( RunReDefine )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	execute_process(
+		COMMAND ${REDEFINE} ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Selection"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	endif()
+endfunction()
+
+# checks that only given scripts were changed
+function( CheckChanged )
+	foreach( script IN LISTS scripts ITEMS ../Outside.ssl )
+		file( READ "${PWD}/Selection/Scripts/${script}" content )
+		string( FIND "${content}" "f(" unchanged )
+		list( FIND ARGN "${script}" expected )
+
+		if( NOT expected EQUAL -1 AND NOT unchanged EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : script<${script}> not changed" )
+		elseif( expected EQUAL -1 AND unchanged EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : script<${script}> changed" )
+		endif()
+	endforeach()
+endfunction()
+
+function( Git )
+	execute_process(
+		COMMAND ${GIT} -c user.name=ReDefine -c user.email=ReDefine@localhost -c commit.gpgsign=false ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Selection"
+		RESULT_VARIABLE exitcode
+		OUTPUT_QUIET
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : git ${ARGN} exitcode<${exitcode}>" )
+	endif()
+endfunction()
+
+# files outside of scripts directory are ignored, regardless how they're passed
+Reset()
+RunReDefine( --files Alpha.ssl,./Sub/../Beta.ssl,../Outside.ssl,Sub/../../Outside.ssl,Outside.ssl,${PWD}/Selection/Outside.ssl )
+CheckChanged( Alpha.ssl Beta.ssl )
+
+file( STRINGS "${PWD}/Selection/ReDefine.WARNING.log" warnings REGEX "is outside of scripts directory" )
+list( LENGTH warnings count )
+if( NOT count EQUAL 4 )
+	message( FATAL_ERROR "TEST FAILED : outside warnings<${count}>" )
+endif()
+
+# revision is passed to git as-is
+find_program( GIT git )
+if( NOT GIT )
+	message( STATUS "git not found : --changed-since not tested" )
+	file( REMOVE_RECURSE "${PWD}/Selection" )
+	return()
+endif()
+
+foreach( revision IN ITEMS HEAD~1 HEAD^ "HEAD^{commit}~1" )
+	Reset()
+	Git( init -q )
+	Git( add -A )
+	Git( commit -q -m First )
+	file( WRITE "${PWD}/Selection/Scripts/Beta.ssl" "f(2);\n" )
+	Git( commit -q -a -m Second )
+	file( WRITE "${PWD}/Selection/Scripts/Sub/Delta.ssl" "f(2);\n" )
+
+	RunReDefine( --changed-since ${revision} )
+	CheckChanged( Beta.ssl Sub/Delta.ssl )
+endforeach()
+
+file( REMOVE_RECURSE "${PWD}/Selection" )
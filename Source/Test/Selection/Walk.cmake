@@ -0,0 +1,75 @@
+# runs executable on nested scripts directory, and checks which scripts were found by walking it
+# see Selection/ReDefine.cfg
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+# directory with extension used by scripts must be walked, not processed
+set( files Alpha.ssl Beta.SSL Gamma.Ssl Text.txt NoExtension Sub/Delta.ssl Sub/Deep/Epsilon.SSL Sub/Deep/Deeper/Zeta.ssl Sub/Skip/Eta.ssl Other/Theta.ssl Other/Iota.h Directory.ssl/Kappa.ssl )
+
+# recreates test directory; all files needs changes
+function( Reset )
+	file( REMOVE_RECURSE "${PWD}/Walk" )
+	file( MAKE_DIRECTORY "${PWD}/Walk" )
+	file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Walk" )
+
+	foreach( file IN LISTS files )
+		file( WRITE "${PWD}/Walk/Scripts/${file}" "f(1);\n" )
+	endforeach()
+endfunction()
+
+function( RunReDefine )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	Reset()
+	execute_process(
+		COMMAND ${REDEFINE} ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Walk"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	endif()
+endfunction()
+
+# checks that only given files were processed
+function( CheckChanged )
+	foreach( file IN LISTS files )
+		file( READ "${PWD}/Walk/Scripts/${file}" content )
+		string( FIND "${content}" "f(" unchanged )
+		list( FIND ARGN "${file}" expected )
+
+		if( NOT expected EQUAL -1 AND NOT unchanged EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : file<${file}> not processed" )
+		elseif( expected EQUAL -1 AND unchanged EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : file<${file}> processed" )
+		endif()
+	endforeach()
+endfunction()
+
+# extensions are case insensitive
+RunReDefine()
+CheckChanged( Alpha.ssl Beta.SSL Gamma.Ssl Sub/Delta.ssl Sub/Deep/Epsilon.SSL Sub/Deep/Deeper/Zeta.ssl Sub/Skip/Eta.ssl Other/Theta.ssl Directory.ssl/Kappa.ssl )
+
+# globs are case insensitive; '*' doesn't cross directories, '**' does; excluded directory is skipped with all its content
+RunReDefine( --scripts-include "Sub/** *.ssl" --scripts-exclude "sub/skip *.txt" )
+CheckChanged( Alpha.ssl Beta.SSL Gamma.Ssl Sub/Delta.ssl Sub/Deep/Epsilon.SSL Sub/Deep/Deeper/Zeta.ssl )
+
+# "**/" matches zero or more directories
+RunReDefine( --scripts-extensions "ssl .H" --scripts-exclude "**/deeper **/Beta.ssl" )
+CheckChanged( Alpha.ssl Gamma.Ssl Sub/Delta.ssl Sub/Deep/Epsilon.SSL Sub/Skip/Eta.ssl Other/Theta.ssl Other/Iota.h Directory.ssl/Kappa.ssl )
+
+RunReDefine( --scripts-include "**/*.h other/**" --scripts-exclude "Other/Theta.ssl" --scripts-extensions "h ssl" )
+CheckChanged( Other/Iota.h )
+
+file( REMOVE_RECURSE "${PWD}/Walk" )
@@ -0,0 +1,72 @@
+# runs language server with scripted client session, and checks its responses
+# see Server/ReDefine.cfg
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( REMOVE_RECURSE "${PWD}/Lsp" )
+file( MAKE_DIRECTORY "${PWD}/Lsp" )
+file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Lsp" )
+
+# adds message to client session, using same framing as server
+function( AddMessage content )
+	string( LENGTH "${content}" length )
+	file( APPEND "${PWD}/Lsp/Input" "Content-Length: ${length}\r\n\r\n${content}" )
+endfunction()
+
+# too deeply nested message must be rejected without crashing server
+string( REPEAT "[" 100000 nested )
+
+AddMessage( [=[{"jsonrpc":"2.0","id":1,"method":"initialize","params":{}}]=] )
+AddMessage( [=[{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file:///Lsp/Test.ssl","version":1,"text":"procedure start\nbegin\n    f(1);\n    x := 1;\n    f(2);\nend\n"}}}]=] )
+AddMessage( [=[{"jsonrpc":"2.0","id":2,"method":"textDocument/codeAction","params":{"textDocument":{"uri":"file:///Lsp/Test.ssl"},"range":{"start":{"line":2,"character":0},"end":{"line":2,"character":0}}}}]=] )
+AddMessage( "${nested}" )
+# changed line, and line added before all lines; results of following lines must be updated
+AddMessage( [=[{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///Lsp/Test.ssl","version":2},"contentChanges":[{"text":"procedure start\nbegin\n    h(1);\n    x := 1;\n    f(2);\nend\n"}]}}]=] )
+AddMessage( [=[{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///Lsp/Test.ssl","version":3},"contentChanges":[{"text":"// f(0);\nprocedure start\nbegin\n    h(1);\n    x := 1;\n    f(2);\nend\n"}]}}]=] )
+AddMessage( [=[{"jsonrpc":"2.0","id":3,"method":"shutdown"}]=] )
+AddMessage( [=[{"jsonrpc":"2.0","method":"exit"}]=] )
+
+message( "" )
+message( STATUS "ReDefine run" )
+message( "" )
+
+execute_process(
+	COMMAND ${REDEFINE} --lsp
+	WORKING_DIRECTORY "${PWD}/Lsp"
+	INPUT_FILE "${PWD}/Lsp/Input"
+	OUTPUT_VARIABLE output
+	RESULT_VARIABLE exitcode
+)
+
+message( "${output}" )
+
+if( NOT exitcode EQUAL 0 )
+	message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+endif()
+
+# responses which must be found in server output
+function( CheckResponse text )
+	string( FIND "${output}" "${text}" found )
+	if( found EQUAL -1 )
+		message( FATAL_ERROR "TEST FAILED : response not found<${text}>" )
+	endif()
+endfunction()
+
+CheckResponse( [=["id":1,"jsonrpc":"2.0","result":{"capabilities":{]=] )
+CheckResponse( [=["serverInfo":{"name":"ReDefine"}]=] )
+CheckResponse( [=["message":"-> g(1);","range":{"end":{"character":9,"line":2},"start":{"character":0,"line":2}}]=] )
+CheckResponse( [=["message":"-> g(2);","range":{"end":{"character":9,"line":4},"start":{"character":0,"line":4}}]=] )
+CheckResponse( [=["id":2,"jsonrpc":"2.0","result":[{"edit":{"changes":{"file:///Lsp/Test.ssl":[{"newText":"    g(1);","range":{"end":{"character":9,"line":2},"start":{"character":0,"line":2}}}]}},"isPreferred":true,"kind":"quickfix","title":"ReDefine: g(1);"}]=] )
+CheckResponse( [=["title":"ReDefine: apply all changes (2)"]=] )
+CheckResponse( [=["diagnostics":[{"message":"-> g(2);","range":{"end":{"character":9,"line":4},"start":{"character":0,"line":4}},"severity":3,"source":"ReDefine"}],"uri":"file:///Lsp/Test.ssl","version":2}]=] )
+CheckResponse( [=["diagnostics":[{"message":"-> g(2);","range":{"end":{"character":9,"line":5},"start":{"character":0,"line":5}},"severity":3,"source":"ReDefine"}],"uri":"file:///Lsp/Test.ssl","version":3}]=] )
+CheckResponse( [=[{"error":{"code":-32700,"message":"parse error"},"id":null,]=] )
+CheckResponse( [=[{"id":3,"jsonrpc":"2.0","result":null}]=] )
+
+file( REMOVE_RECURSE "${PWD}/Lsp" )
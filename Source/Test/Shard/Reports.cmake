@@ -0,0 +1,141 @@
+# runs executable split between shards running at same time, and checks if merged reports and scripts are same as for single run;
+# each shard must use own logfiles and temporary files, and scripts manifest must keep entries of all shards
+# see Shard/ReDefine.cfg
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+# single shard, started by main script; output is kept, so shards can run in pipeline without writing to each other
+if( SHARD )
+	execute_process(
+		COMMAND ${REDEFINE} --shard ${SHARD}/${SHARDS} --report Shard${SHARD}.json
+		WORKING_DIRECTORY "${PWD}/Shard/Sharded"
+		RESULT_VARIABLE exitcode
+		OUTPUT_VARIABLE output
+		ERROR_VARIABLE  output
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : shard<${SHARD}/${SHARDS}> exitcode<${exitcode}>\n${output}" )
+	endif()
+
+	return()
+endif()
+
+set( shards 3 )
+set( scripts Alpha.ssl Beta.ssl Gamma.ssl Delta.ssl Epsilon.ssl Zeta.ssl Eta.ssl )
+
+file( REMOVE_RECURSE "${PWD}/Shard" )
+foreach( dir IN ITEMS Single Sharded )
+	file( MAKE_DIRECTORY "${PWD}/Shard/${dir}" )
+	file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Shard/${dir}" )
+	foreach( script IN LISTS scripts )
+		file( WRITE "${PWD}/Shard/${dir}/Scripts/${script}" "f(1);\nf(2);\nh(1);\n" )
+	endforeach()
+endforeach()
+
+function( RunReDefine dir )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	execute_process(
+		COMMAND ${REDEFINE} ${ARGN}
+		WORKING_DIRECTORY "${PWD}/Shard/${dir}"
+		RESULT_VARIABLE exitcode
+	)
+
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+	endif()
+endfunction()
+
+function( CheckSame filename )
+	file( READ "${PWD}/Shard/Single/${filename}" expected )
+	file( READ "${PWD}/Shard/Sharded/${filename}" content )
+	if( NOT content STREQUAL expected )
+		message( FATAL_ERROR "TEST FAILED : file<${filename}> differs from single run\n${content}\n${expected}" )
+	endif()
+endfunction()
+
+RunReDefine( Single --report Report.json )
+
+# all shards are started at once
+set( commands )
+set( reports )
+foreach( shard RANGE 1 ${shards} )
+	list( APPEND commands COMMAND ${CMAKE_COMMAND} -DREDEFINE=${REDEFINE} -DTEST_DIR=${TEST_DIR} -DSHARD=${shard} -DSHARDS=${shards} -P ${CMAKE_CURRENT_LIST_FILE} )
+	list( APPEND reports Shard${shard}.json )
+endforeach()
+
+message( "" )
+message( STATUS "ReDefine run (${shards} shards)" )
+message( "" )
+
+execute_process(
+	${commands}
+	WORKING_DIRECTORY "${PWD}"
+	RESULTS_VARIABLE exitcodes
+)
+
+foreach( exitcode IN LISTS exitcodes )
+	if( NOT exitcode EQUAL 0 )
+		message( FATAL_ERROR "TEST FAILED : exitcodes<${exitcodes}>" )
+	endif()
+endforeach()
+
+# each script is logged by exactly one shard, and nothing is logged to regular logfile
+if( EXISTS "${PWD}/Shard/Sharded/ReDefine.log" )
+	message( FATAL_ERROR "TEST FAILED : logfile<ReDefine.log> used by shard" )
+endif()
+
+foreach( script IN LISTS scripts )
+	set( found 0 )
+	foreach( shard RANGE 1 ${shards} )
+		file( READ "${PWD}/Shard/Sharded/ReDefine.shard${shard}.log" log )
+		string( FIND "${log}" "fileline<${script}:1>" position )
+		if( NOT position EQUAL -1 )
+			math( EXPR found "${found} + 1" )
+		endif()
+	endforeach()
+
+	if( NOT found EQUAL 1 )
+		message( FATAL_ERROR "TEST FAILED : script<${script}> found in ${found} shards logfiles" )
+	endif()
+endforeach()
+
+file( GLOB_RECURSE temporary LIST_DIRECTORIES false RELATIVE "${PWD}/Shard" "${PWD}/Shard/*.tmp" )
+if( temporary )
+	message( FATAL_ERROR "TEST FAILED : temporary files left<${temporary}>" )
+endif()
+
+list( JOIN reports "," reports )
+RunReDefine( Sharded --merge-reports ${reports} --report Report.json )
+
+CheckSame( Report.json )
+foreach( script IN LISTS scripts )
+	CheckSame( Scripts/${script} )
+endforeach()
+
+# shards started one by one must keep manifest entries of each other
+file( REMOVE "${PWD}/Shard/Sharded/Scripts.manifest" )
+foreach( shard RANGE 1 ${shards} )
+	RunReDefine( Sharded --shard ${shard}/${shards} )
+endforeach()
+
+file( STRINGS "${PWD}/Shard/Sharded/Scripts.manifest" content )
+foreach( script IN LISTS scripts )
+	string( FIND "${content}" "${script}" found )
+	if( found EQUAL -1 )
+		message( FATAL_ERROR "TEST FAILED : script<${script}> not found in manifest" )
+	endif()
+endforeach()
+
+file( REMOVE_RECURSE "${PWD}/Shard" )
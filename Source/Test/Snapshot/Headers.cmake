@@ -0,0 +1,93 @@
+# runs executable with defines snapshot enabled, and checks if snapshot gives same results as parsing headers;
+# changed headers must be parsed again, and broken snapshot must be ignored
+# see Snapshot/ReDefine.cfg
+
+cmake_minimum_required( VERSION 3.19 FATAL_ERROR )
+
+set( PWD "${CMAKE_CURRENT_BINARY_DIR}" )
+
+if( NOT REDEFINE )
+	message( FATAL_ERROR "REDEFINE not set" )
+elseif( NOT TEST_DIR )
+	message( FATAL_ERROR "TEST_DIR not set" )
+endif()
+
+file( REMOVE_RECURSE "${PWD}/Snapshot" )
+file( MAKE_DIRECTORY "${PWD}/Snapshot" )
+file( COPY "${TEST_DIR}/ReDefine.cfg" DESTINATION "${PWD}/Snapshot" )
+file( WRITE "${PWD}/Snapshot/Defines.h" "#define DUMMY_ONE 1\n#define DUMMY_TWO 2\n#define DUMMY_THREE (DUMMY_TWO + 1)\n" )
+
+set( snapshot "${PWD}/Snapshot/Defines.snapshot" )
+
+# runs executable without snapshot first, and keeps results as expected ones
+function( RunReDefine )
+	message( "" )
+	message( STATUS "ReDefine run (${ARGN})" )
+	message( "" )
+
+	foreach( run IN ITEMS Expected Scripts )
+		file( REMOVE_RECURSE "${PWD}/Snapshot/Scripts" )
+		file( WRITE "${PWD}/Snapshot/Scripts/Script.ssl" "f(1);\nf(2);\nf(3);\n" )
+
+		if( run STREQUAL "Expected" )
+			set( options )
+		else()
+			set( options --defines-snapshot Defines.snapshot )
+		endif()
+
+		execute_process(
+			COMMAND ${REDEFINE} ${options}
+			WORKING_DIRECTORY "${PWD}/Snapshot"
+			RESULT_VARIABLE exitcode
+			OUTPUT_VARIABLE output
+			ERROR_VARIABLE  output
+		)
+
+		message( "${output}" )
+
+		if( NOT exitcode EQUAL 0 )
+			message( FATAL_ERROR "TEST FAILED : exitcode<${exitcode}>" )
+		endif()
+
+		# defines read from snapshot must not be mixed with parsed ones
+		string( FIND "${output}" "WARNING" found )
+		if( NOT found EQUAL -1 )
+			message( FATAL_ERROR "TEST FAILED : warning found in output" )
+		endif()
+
+		if( run STREQUAL "Expected" )
+			file( READ "${PWD}/Snapshot/Scripts/Script.ssl" expected )
+		endif()
+	endforeach()
+
+	file( READ "${PWD}/Snapshot/Scripts/Script.ssl" content )
+	if( NOT content STREQUAL expected )
+		message( FATAL_ERROR "TEST FAILED : snapshot results differs from parsed headers\n${content}\n${expected}" )
+	elseif( NOT EXISTS "${snapshot}" )
+		message( FATAL_ERROR "TEST FAILED : defines snapshot not saved" )
+	endif()
+endfunction()
+
+# creates snapshot
+RunReDefine()
+
+# unchanged header
+RunReDefine()
+
+# touched header, with same content
+file( TOUCH "${PWD}/Snapshot/Defines.h" )
+RunReDefine()
+
+# changed header
+file( WRITE "${PWD}/Snapshot/Defines.h" "#define DUMMY_ONE 1\n#define DUMMY_SECOND 2\n#define DUMMY_THREE (DUMMY_SECOND + 1)\n" )
+RunReDefine()
+
+# name of second define pointing outside of record; head(16) + offset(8) + record(40) + define(16) + Line(4) + Value(4)
+file( READ "${snapshot}" content )
+string( ASCII 255 255 255 127 huge )
+string( SUBSTRING "${content}" 0 88 head )
+string( SUBSTRING "${content}" 92 -1 tail )
+file( WRITE "${snapshot}" "${head}${huge}${tail}" )
+RunReDefine()
+
+file( REMOVE_RECURSE "${PWD}/Snapshot" )
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <cstdlib>
 #include <filesystem>
+#include <iterator>
 #include <sstream>
 
 #include "ReDefine.h"
@@ -14,6 +16,8 @@ namespace
     static const std::regex IsInt( "^[\\-]?[0-9]+$" );
     static const std::regex IsConflict( "^[\\<]+ (HEAD|\\.mine).*$" );
 
+    static const std::regex GetScriptDefine( "^[\\t\\ ]*\\#define[\\t\\ ]+([A-Za-z0-9_]+)(?:$|[\\t\\ ]+.*$)" );
+
     static const std::regex GetVariables( "([A-Za-z0-9_]+)[\\t\\ ]*([\\:\\=\\!\\<\\>\\+]+|[Bb][Ww][a-z]+)[\\t\\ ]*([\\-]?[A-Za-z0-9\\_]+)" );
     static const std::regex GetVariablesSimple( "([A-Za-z0-9_]+)[\\t\\ ]*;" );
 
@@ -44,6 +48,63 @@ bool ReDefine::TextIsConflict( const std::string& text )
     return std::regex_match( text, IsConflict );
 }
 
+// lines marked with "//ReDefine::IgnoreLine//" or "/*ReDefine::IgnoreLine*/" are never changed
+bool ReDefine::TextIsIgnored( const std::string& text )
+{
+    return text.find( "//ReDefine::IgnoreLine//" ) != std::string::npos || text.find( "/*ReDefine::IgnoreLine*/" ) != std::string::npos; // TODO C++23 https://en.cppreference.com/w/cpp/string/basic_string/contains
+}
+
+// case insensitive; '*' and '?' never matches '/', '**' matches anything, "**/" matches zero or more directories
+static bool IsGlobMatch( const std::string_view& text, const std::string_view& glob )
+{
+    if( glob.empty() )
+        return text.empty();
+
+    if( glob.starts_with( "**" ) )
+    {
+        const std::string_view rest = glob.substr( 2 );
+
+        if( rest.starts_with( "/" ) && IsGlobMatch( text, rest.substr( 1 ) ) )
+            return true;
+
+        for( size_t idx = 0; idx <= text.size(); idx++ )
+        {
+            if( IsGlobMatch( text.substr( idx ), rest ) )
+                return true;
+        }
+
+        return false;
+    }
+    else if( glob.front() == '*' )
+    {
+        for( size_t idx = 0; idx <= text.size(); idx++ )
+        {
+            if( IsGlobMatch( text.substr( idx ), glob.substr( 1 ) ) )
+                return true;
+            else if( idx < text.size() && text[idx] == '/' )
+                break;
+        }
+
+        return false;
+    }
+    else if( text.empty() )
+        return false;
+    else if( glob.front() == '?' )
+    {
+        if( text.front() == '/' )
+            return false;
+    }
+    else if( ::tolower( static_cast<unsigned char>(text.front() ) ) != ::tolower( static_cast<unsigned char>(glob.front() ) ) )
+        return false;
+
+    return IsGlobMatch( text.substr( 1 ), glob.substr( 1 ) );
+}
+
+bool ReDefine::TextIsGlobMatch( const std::string& text, const std::string& glob )
+{
+    return IsGlobMatch( text, TextGetReplaced( glob, "\\", "/" ) );
+}
+
 std::string ReDefine::TextGetFilename( const std::string& path, const std::string& filename )
 {
     std::string spath = path;
@@ -59,6 +120,25 @@ std::string ReDefine::TextGetFilename( const std::string& path, const std::strin
     return full.string();
 }
 
+// FNV-1a
+uint64_t ReDefine::TextGetHash( const char* data, const size_t size )
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for( size_t idx = 0; idx < size; idx++ )
+    {
+        hash ^= static_cast<unsigned char>(data[idx]);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+uint64_t ReDefine::TextGetHash( const std::string& text )
+{
+    return TextGetHash( text.data(), text.size() );
+}
+
 bool ReDefine::TextGetInt( const std::string& text, int& result, const uint8_t& base /* = 10 */ )
 {
     // https://stackoverflow.com/a/6154614
@@ -95,6 +175,38 @@ std::string ReDefine::TextGetJoined( const std::vector<std::string>& text, const
     }
 }
 
+// splits text into lines the same way as ReadFile() does; leading bom and all '\r' are removed
+std::vector<std::string> ReDefine::TextGetLines( const std::string_view& text )
+{
+    std::vector<std::string> result;
+    std::string_view         view = text;
+
+    if( view.size() >= 3 && view[0] == static_cast<char>(0xEF) && view[1] == static_cast<char>(0xBB) && view[2] == static_cast<char>(0xBF) )
+        view.remove_prefix( 3 );
+
+    while( !view.empty() )
+    {
+        size_t      end = view.find( '\n' );
+        std::string line;
+
+        line.reserve( std::min( end, view.size() ) );
+        for( const char c : view.substr( 0, end ) )
+        {
+            if( c != '\r' )
+                line += c;
+        }
+
+        result.push_back( std::move( line ) );
+
+        if( end == std::string_view::npos )
+            break;
+
+        view.remove_prefix( end + 1 );
+    }
+
+    return result;
+}
+
 std::string ReDefine::TextGetLower( const std::string& text )
 {
     std::string result = text;
@@ -184,6 +296,51 @@ bool ReDefine::TextIsDefine( const std::string& text )
     return std::regex_search( text, IsDefine );
 }
 
+bool ReDefine::TextGetScriptDefine( const std::string& text, std::string& name )
+{
+    std::smatch match;
+    if( std::regex_match( text, match, GetScriptDefine ) )
+    {
+        name = match.str( 1 );
+        return true;
+    }
+
+    return false;
+}
+
+// same as "^[\t\ ]*\#define[\t\ ]+([A-Za-z0-9_]+)[\t\ ]+(.*)", without using regex
+bool ReDefine::TextGetDefine( const std::string_view& text, std::string_view& name, std::string_view& value )
+{
+    static constexpr std::string_view define = "#define";
+    static constexpr const char*      blank = "\t ";
+
+    size_t                            pos = text.find_first_not_of( blank );
+    if( pos == std::string_view::npos || text.substr( pos, define.size() ) != define )
+        return false;
+
+    pos += define.size();
+
+    const size_t start = text.find_first_not_of( blank, pos );
+    if( start == pos || start == std::string_view::npos )
+        return false;
+
+    size_t end = start;
+    while( end < text.size() && ( (text[end] >= 'A' && text[end] <= 'Z') || (text[end] >= 'a' && text[end] <= 'z') || (text[end] >= '0' && text[end] <= '9') || text[end] == '_' ) )
+    {
+        end++;
+    }
+
+    if( end == start || end == text.size() || (text[end] != '\t' && text[end] != ' ') )
+        return false;
+
+    name = text.substr( start, end - start );
+
+    pos = text.find_first_not_of( blank, end );
+    value = pos != std::string_view::npos ? text.substr( pos ) : std::string_view();
+
+    return true;
+}
+
 bool ReDefine::TextGetDefineInt( const std::string& text, const std::regex& re, std::string& name, int& value )
 {
     std::smatch match;
@@ -0,0 +1,399 @@
+#include "Uring.h"
+
+#if defined (HAVE_IO_URING)
+# include <algorithm>
+# include <atomic>
+# include <cerrno>
+# include <cstring>
+# include <fcntl.h>
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+Uring::Uring() :
+    Ring( -1 ),
+    Entries( 0 ),
+    SqRing( nullptr ),
+    SqRingSize( 0 ),
+    CqRing( nullptr ),
+    CqRingSize( 0 ),
+    Sqes( nullptr ),
+    SqesSize( 0 ),
+    SqHead( nullptr ),
+    SqTail( nullptr ),
+    SqMask( nullptr ),
+    SqArray( nullptr ),
+    CqHead( nullptr ),
+    CqTail( nullptr ),
+    CqMask( nullptr ),
+    Cqes( nullptr ),
+    Busy( false )
+{}
+
+Uring::~Uring()
+{
+    Finish();
+
+    // kernel might still write to retained buffers after ring is closed; they're intentionally leaked
+    if( Busy )
+        new std::vector<std::vector<char>>( std::move( Retained ) );
+}
+
+#if defined (HAVE_IO_URING)
+
+bool Uring::Init( uint32_t entries )
+{
+    Finish();
+
+    io_uring_params params;
+    std::memset( &params, 0, sizeof(params) );
+
+    Ring = static_cast<int>(syscall( __NR_io_uring_setup, entries, &params ) );
+    if( Ring < 0 )
+    {
+        Ring = -1;
+        return false;
+    }
+
+    Entries = params.sq_entries;
+
+    SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    SqRing = mmap( nullptr, SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring, IORING_OFF_SQ_RING );
+    CqRing = mmap( nullptr, CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring, IORING_OFF_CQ_RING );
+    Sqes = mmap( nullptr, SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring, IORING_OFF_SQES );
+
+    if( SqRing == MAP_FAILED || CqRing == MAP_FAILED || Sqes == MAP_FAILED )
+    {
+        Finish();
+        return false;
+    }
+
+    char* sq = static_cast<char*>(SqRing);
+    SqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    SqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    SqMask = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    SqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(CqRing);
+    CqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    CqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    CqMask = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    Cqes = cq + params.cq_off.cqes;
+
+    return true;
+}
+
+void Uring::Finish()
+{
+    if( Sqes && Sqes != MAP_FAILED )
+        munmap( Sqes, SqesSize );
+    if( CqRing && CqRing != MAP_FAILED )
+        munmap( CqRing, CqRingSize );
+    if( SqRing && SqRing != MAP_FAILED )
+        munmap( SqRing, SqRingSize );
+    if( Ring >= 0 )
+        close( Ring );
+
+    Ring = -1;
+    Entries = 0;
+    SqRing = CqRing = Sqes = Cqes = nullptr;
+    SqRingSize = CqRingSize = SqesSize = 0;
+    SqHead = SqTail = SqMask = SqArray = CqHead = CqTail = CqMask = nullptr;
+}
+
+bool Uring::Submit( std::vector<io_uring_sqe>& requests, std::vector<int32_t>& results )
+{
+    results.assign( requests.size(), -ECANCELED );
+
+    if( Ring < 0 )
+        return false;
+
+    io_uring_sqe*     sqes = static_cast<io_uring_sqe*>(Sqes);
+    io_uring_cqe*     cqes = static_cast<io_uring_cqe*>(Cqes);
+    size_t            submitted = 0, completed = 0;
+    uint32_t          pending = 0, active = 0;
+    std::vector<bool> running( requests.size(), false );
+
+    while( completed < requests.size() )
+    {
+        // queue as many requests as possible; completion queue is twice as big as submission queue, so it never overflows
+        uint32_t tail = *SqTail;
+        while( submitted < requests.size() && active < Entries )
+        {
+            const uint32_t idx = tail & *SqMask;
+
+            sqes[idx] = requests[submitted];
+            sqes[idx].user_data = submitted;
+            SqArray[idx] = idx;
+            running[submitted] = true;
+
+            tail++;
+            submitted++;
+            pending++;
+            active++;
+        }
+
+        std::atomic_ref<uint32_t>( *SqTail ).store( tail, std::memory_order_release );
+
+        int result = static_cast<int>(syscall( __NR_io_uring_enter, Ring, pending, 1, IORING_ENTER_GETEVENTS, nullptr, 0 ) );
+        if( result < 0 )
+        {
+            if( errno == EINTR || errno == EAGAIN || errno == EBUSY )
+                continue;
+
+            // requests already queued might still use buffers; ring is closed only after all of them are completed
+            // if that's not possible, caller must keep buffers used by requests, see Retained
+            if( !Cancel( running, results ) )
+                Busy = true;
+
+            Finish();
+            return false;
+        }
+
+        pending -= static_cast<uint32_t>(result);
+
+        uint32_t       head = *CqHead;
+        const uint32_t end = std::atomic_ref<uint32_t>( *CqTail ).load( std::memory_order_acquire );
+        while( head != end )
+        {
+            const io_uring_cqe& cqe = cqes[head & *CqMask];
+            results[cqe.user_data] = cqe.res;
+            running[cqe.user_data] = false;
+
+            head++;
+            completed++;
+            active--;
+        }
+
+        std::atomic_ref<uint32_t>( *CqHead ).store( head, std::memory_order_release );
+    }
+
+    return true;
+}
+
+// cancels all running requests, and waits until they are completed; returns false if ring cannot be used anymore
+// requests which are queued but not passed to kernel yet are submitted before cancellations, so they're cancelled as well
+// results of requests completed before cancellation are kept, so caller can cleanup after them (close opened files, etc.)
+bool Uring::Cancel( const std::vector<bool>& running, std::vector<int32_t>& results )
+{
+    // user_data of cancellation requests; never used by regular requests
+    static const uint64_t cancel = UINT64_MAX;
+
+    io_uring_sqe*         sqes = static_cast<io_uring_sqe*>(Sqes);
+    io_uring_cqe*         cqes = static_cast<io_uring_cqe*>(Cqes);
+    std::vector<bool>     active = running;
+    size_t                next = 0, failures = 0;
+    uint32_t              left = static_cast<uint32_t>(std::count( active.begin(), active.end(), true ) ), cancelling = 0;
+
+    while( left )
+    {
+        // completion queue keeps space for all queued requests and same number of cancellations
+        uint32_t tail = *SqTail;
+        while( next < active.size() && cancelling < Entries && (tail - std::atomic_ref<uint32_t>( *SqHead ).load( std::memory_order_acquire ) ) < Entries )
+        {
+            if( !active[next] )
+            {
+                next++;
+                continue;
+            }
+
+            const uint32_t idx = tail & *SqMask;
+
+            std::memset( &sqes[idx], 0, sizeof(io_uring_sqe) );
+            sqes[idx].opcode = IORING_OP_ASYNC_CANCEL;
+            sqes[idx].addr = next;
+            sqes[idx].user_data = cancel;
+            SqArray[idx] = idx;
+
+            tail++;
+            next++;
+            cancelling++;
+        }
+
+        std::atomic_ref<uint32_t>( *SqTail ).store( tail, std::memory_order_release );
+
+        const uint32_t queued = tail - std::atomic_ref<uint32_t>( *SqHead ).load( std::memory_order_acquire );
+
+        if( syscall( __NR_io_uring_enter, Ring, queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0 ) < 0 )
+        {
+            if( errno == EINTR || errno == EAGAIN || errno == EBUSY )
+                continue;
+
+            // give up if ring keeps failing
+            if( ++failures > 100 )
+                return false;
+        }
+
+        uint32_t       head = *CqHead;
+        const uint32_t end = std::atomic_ref<uint32_t>( *CqTail ).load( std::memory_order_acquire );
+        while( head != end )
+        {
+            const io_uring_cqe& cqe = cqes[head & *CqMask];
+
+            if( cqe.user_data == cancel )
+                cancelling--;
+            else if( cqe.user_data < active.size() && active[cqe.user_data] )
+            {
+                results[cqe.user_data] = cqe.res;
+                active[cqe.user_data] = false;
+                left--;
+            }
+
+            head++;
+        }
+
+        std::atomic_ref<uint32_t>( *CqHead ).store( head, std::memory_order_release );
+    }
+
+    return true;
+}
+
+void Uring::Read( const std::vector<std::string>& filenames, std::vector<std::vector<char>>& data, std::vector<bool>& loaded )
+{
+    const size_t size = filenames.size();
+
+    data.assign( size, std::vector<char>() );
+    loaded.assign( size, false );
+
+    if( Ring < 0 || !size )
+        return;
+
+    // open and check size of all files at once
+    std::vector<io_uring_sqe> requests( size * 2 );
+    std::vector<int32_t>      results;
+    std::vector<char>         statsBuffer( size * sizeof(struct statx) );
+    struct statx*             stats = reinterpret_cast<struct statx*>(statsBuffer.data() );
+
+    std::memset( requests.data(), 0, requests.size() * sizeof(io_uring_sqe) );
+    for( size_t idx = 0; idx < size; idx++ )
+    {
+        io_uring_sqe& open = requests[idx * 2];
+        open.opcode = IORING_OP_OPENAT;
+        open.fd = AT_FDCWD;
+        open.addr = reinterpret_cast<uint64_t>(filenames[idx].c_str() );
+        open.open_flags = O_RDONLY | O_CLOEXEC;
+
+        io_uring_sqe& stat = requests[idx * 2 + 1];
+        stat.opcode = IORING_OP_STATX;
+        stat.fd = AT_FDCWD;
+        stat.addr = reinterpret_cast<uint64_t>(filenames[idx].c_str() );
+        stat.len = STATX_SIZE;
+        stat.off = reinterpret_cast<uint64_t>(&stats[idx]);
+    }
+
+    // files opened before failure still needs to be closed
+    if( !Submit( requests, results ) && Busy )
+        Retained.push_back( std::move( statsBuffer ) );
+
+    std::vector<int32_t> files( size, -1 );
+    std::vector<size_t>  reads;
+
+    requests.clear();
+    for( size_t idx = 0; idx < size; idx++ )
+    {
+        files[idx] = results[idx * 2];
+        if( files[idx] < 0 || results[idx * 2 + 1] < 0 )
+            continue;
+
+        // don't waste time on empty files
+        if( !stats[idx].stx_size )
+        {
+            loaded[idx] = true;
+            continue;
+        }
+
+        data[idx].resize( stats[idx].stx_size );
+
+        io_uring_sqe read;
+        std::memset( &read, 0, sizeof(read) );
+        read.opcode = IORING_OP_READ;
+        read.fd = files[idx];
+        read.addr = reinterpret_cast<uint64_t>(data[idx].data() );
+        read.len = static_cast<uint32_t>(data[idx].size() );
+        read.off = 0;
+
+        requests.push_back( read );
+        reads.push_back( idx );
+    }
+
+    // read all files at once; short reads are left for fallback
+    if( !requests.empty() && Submit( requests, results ) )
+    {
+        for( size_t idx = 0; idx < reads.size(); idx++ )
+        {
+            loaded[reads[idx]] = results[idx] >= 0 && static_cast<size_t>(results[idx]) == data[reads[idx]].size();
+        }
+    }
+    else if( Busy )
+    {
+        for( const size_t idx : reads )
+        {
+            Retained.push_back( std::move( data[idx] ) );
+        }
+    }
+
+    // close all files at once
+    requests.clear();
+    for( size_t idx = 0; idx < size; idx++ )
+    {
+        if( files[idx] < 0 )
+            continue;
+
+        io_uring_sqe close;
+        std::memset( &close, 0, sizeof(close) );
+        close.opcode = IORING_OP_CLOSE;
+        close.fd = files[idx];
+
+        requests.push_back( close );
+    }
+
+    // files are closed in usual way if closing is not supported by kernel, or request was never executed
+    if( !requests.empty() )
+        Submit( requests, results );
+
+    for( size_t idx = 0, req = 0; idx < size; idx++ )
+    {
+        if( files[idx] < 0 )
+            continue;
+
+        if( results[req] == -EINVAL || results[req] == -ECANCELED )
+            ::close( files[idx] );
+
+        req++;
+    }
+
+    for( size_t idx = 0; idx < size; idx++ )
+    {
+        if( !loaded[idx] )
+            data[idx].clear();
+    }
+}
+
+#else
+
+bool Uring::Init( uint32_t /* entries */ )
+{
+    return false;
+}
+
+void Uring::Finish()
+{}
+
+bool Uring::Submit( std::vector<io_uring_sqe>& /* requests */, std::vector<int32_t>& /* results */ )
+{
+    return false;
+}
+
+void Uring::Read( const std::vector<std::string>& filenames, std::vector<std::vector<char>>& data, std::vector<bool>& loaded )
+{
+    data.assign( filenames.size(), std::vector<char>() );
+    loaded.assign( filenames.size(), false );
+}
+
+#endif
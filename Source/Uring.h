@@ -0,0 +1,56 @@
+#ifndef __URING__
+#define __URING__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct io_uring_sqe;
+
+// bulk files reader using io_uring
+// Init() fails if io_uring is not available (not a Linux build, old kernel, blocked by seccomp, etc.), in which case files should be read in usual way
+class Uring
+{
+protected:
+    int       Ring;
+    uint32_t  Entries;
+
+    void*     SqRing;
+    size_t    SqRingSize;
+    void*     CqRing;
+    size_t    CqRingSize;
+    void*     Sqes;
+    size_t    SqesSize;
+
+    uint32_t* SqHead;
+    uint32_t* SqTail;
+    uint32_t* SqMask;
+    uint32_t* SqArray;
+    uint32_t* CqHead;
+    uint32_t* CqTail;
+    uint32_t* CqMask;
+    void*     Cqes;
+
+    // buffers which might still be used by kernel, as ring failed before all requests using them were completed; see Submit()
+    // kept alive until process exits
+    std::vector<std::vector<char>> Retained;
+    bool                           Busy; // set if ring failed before all requests were completed
+
+    // submits all requests, and waits until all of them are completed
+    // results are stored in requests order
+    bool Submit( std::vector<io_uring_sqe>& requests, std::vector<int32_t>& results );
+    bool Cancel( const std::vector<bool>& running, std::vector<int32_t>& results );
+
+public:
+    Uring();
+    virtual ~Uring();
+
+    virtual bool Init( uint32_t entries );
+    virtual void Finish();
+
+    // reads whole files; loaded[idx] is false if given file could not be read with io_uring
+    virtual void Read( const std::vector<std::string>& filenames, std::vector<std::vector<char>>& data, std::vector<bool>& loaded );
+};
+
+#endif // __URING__ //